@@ -8,9 +8,8 @@
 // This version has not been tested with a BNO055, although it will compile. Minor adjustments may be necessary
 // to the EulerVector3 inputs to get correct behavior.
 
-#include <ArduinoSTL.h>
-#include <map>
 #include <Wire.h>
+#include <malloc.h>
 
 #include "string_utils.h"
 
@@ -28,22 +27,47 @@
 	MPU6050 mpu6050(Wire);
 
 #elif defined(IMU_MPU9250)
-	#include <quaternionFilters.h>
 	#include <MPU9250.h>
 	MPU9250 mpu9250;
+	const float MAG_DECLINATION = 11.5; // TRANSDEC, San Diego - http://www.ngdc.noaa.gov/geomag-web/#declination
 #endif
 
+// the MPUs measure rates and gravity, Fusion turns them into an attitude once per control tick
+#if defined(IMU_MPU6050) || defined(IMU_MPU9250)
+	#include "Fusion.h"
+	Fusion fusion;
+	// at boot, 'fusion:tune:_,_' changes them. Kp 10 is what the MPU9250's quaternionFilters ran (2 * 5), a
+	// time constant of about 0.1 s - the MPU6050 library's complementary filter was about 0.25 s at 200 Hz
+	#define FUSION_KP (10)
+	#define FUSION_KI (0)
+#endif
+
+// how the IMU reports each angle, which decides how the controllers find the short way round to a target
+#include "AngleError.h"
+#ifdef IMU_BNO055
+	typedef angle::Axis<angle::Unsigned> YawAngle;
+#elif defined(IMU_MPU6050)
+	typedef angle::Axis<angle::Continuous> YawAngle;
+#else
+	typedef angle::Axis<angle::Signed> YawAngle;
+#endif
+typedef angle::Axis<angle::Signed> PitchAngle;
+typedef angle::Axis<angle::Signed> RollAngle;
+
 // brushless thruster ESC wrapper
 #include "BLThruster.h"
 
-// maps are slower than direct access, however they lend themselves to being accessed from an interpreter
-std::map<String, BLThruster> thrusters = {
-	{ "vert_fl", BLThruster(3) },
-	{ "vert_bl", BLThruster(4) },
-	{ "vert_fr", BLThruster(6) },
-	{ "vert_br", BLThruster(7) },
-	{ "thrust_l", BLThruster(2) },
-	{ "thrust_r", BLThruster(5) }
+// axis:: and thr:: ids, and the names the interpreter knows them by
+#include "control_ids.h"
+
+// indexed by thr::Id - the control loop indexes directly, the interpreter looks names up in thruster_names
+BLThruster thrusters[thr::Count] = {
+	BLThruster(3), // vert_fl
+	BLThruster(4), // vert_bl
+	BLThruster(6), // vert_fr
+	BLThruster(7), // vert_br
+	BLThruster(2), // thrust_l
+	BLThruster(5)  // thrust_r
 };
 
 /*
@@ -55,76 +79,160 @@ Location Map (Top):
 				 [Back]
 */
 
+// how much of each demand goes to each thruster, 'mixer:?:_,_,_,_,_' changes a row
+#include "Mixer.h"
+
+const float mix_matrix[thr::Count][dof::Count] = {
+	//  heave  pitch  roll  yaw  surge
+	{   1,     -1,     1,    0,   0 }, // vert_fl
+	{   1,      1,     1,    0,   0 }, // vert_bl
+	{   1,     -1,    -1,    0,   0 }, // vert_fr
+	{   1,      1,    -1,    0,   0 }, // vert_br
+	{   0,      0,     0,    1,   1 }, // thrust_l
+	{   0,      0,     0,   -1,   1 }  // thrust_r
+};
+Mixer mixer(BLThruster::PWR_MAX, mix_matrix);
+
 // Depth Sensor
 #include "MS5803.h"
 
 MS5803 ms5803 = MS5803(0x77, 5);
 
-// PID (in a wrapper class to handle the variables)
-#include "PID_v1_strang.h"
-
-// std::map doesn't maintain insertion order -> use a vector with the same names, iterate the vector and use that to access
-// elements in map in correct order. This can also be used to disable printing of certain elements by simply not inserting it.
-std::vector<String> pid_order = { "yaw", "pitch", "roll", "pressure" };
-std::map<String, PID> pid = {
-	{ "yaw", PID(-50, 50, 50, PID::Direction::Reverse) },
-	{ "pitch", PID(-80, 80, 50, PID::Direction::Reverse) },
-	{ "roll", PID(-30, 30, 50, PID::Direction::Reverse) },
-	{ "pressure", PID(-80, 80, 50, PID::Direction::Reverse) }
-};
-
-std::map<String, float> pid_target = {
-	{ "yaw", 0 },        // degrees
-	{ "pitch", 0 },       // degrees
-	{ "roll", 0 },        // degrees
-	{ "pressure", 1010 } // millibar, ~1 atm
+// PID, float on the Teensy's single precision FPU, stepped all together off one clock read
+#include "PIDCore.h"
+
+// sensors, PID and mixing run at a fixed rate off a timer, serial and logging in the time left over
+#include "ControlTick.h"
+#define CONTROL_HZ (200) // at boot, 'tick:_' changes it
+ControlTick control_tick;
+
+// indexed by axis::Id, names in axis_names. Stepped every control tick, startControlTick() sets the period
+typedef PIDBank<float, axis::Count> PIDControllers;
+PIDControllers pid(1000 / CONTROL_HZ, PIDBase::Reverse, {
+	{ -50, 50 }, // yaw
+	{ -80, 80 }, // pitch
+	{ -30, 30 }, // roll
+	{ -80, 80 }  // pressure
+});
+
+float pid_target[axis::Count] = {
+	0,   // yaw, degrees
+	0,   // pitch, degrees
+	0,   // roll, degrees
+	1010 // pressure, millibar, ~1 atm
 };
 
 // lonely variable that sets the base forward/backwards velocity before yaw pid output is mixed
 float thrust_base = 0;
 
-std::map<String, std::map<String, float>> mode_vars = {
-	{ "pilot", {
-		{ "jump_thrust", 25 },
-		{ "step_thrust", 20 },
-		{ "jump_yaw", 30 },
-		{ "step_yaw", 5 },
-		{ "step_pressure", 10 },
-		{ "lim_base", 80 }
-	}},
-	{ "test", {
-		{ "power", 20 }
-	}}
+// settings of the interpreter modes, indexed by id like the controllers - 'vars:?mode:?field:_' finds them by name
+struct ModeVar {
+	const char* name;
+	float value;
 };
 
+namespace pilot_var {
+	enum Id : uint8_t {
+		JumpThrust, StepThrust, JumpYaw, StepYaw, StepPressure, LimBase,
+		Count
+	};
+}
+ModeVar pilot_vars[pilot_var::Count] = {
+	{ "jump_thrust", 25 },
+	{ "step_thrust", 20 },
+	{ "jump_yaw", 30 },
+	{ "step_yaw", 5 },
+	{ "step_pressure", 10 },
+	{ "lim_base", 80 }
+};
+
+namespace test_var {
+	enum Id : uint8_t {
+		Power,
+		Count
+	};
+}
+ModeVar test_vars[test_var::Count] = {
+	{ "power", 20 }
+};
+
+struct ModeVars {
+	const char* mode;
+	ModeVar* vars;
+	uint8_t count;
+};
+const ModeVars mode_vars[] = {
+	{ "pilot", pilot_vars, pilot_var::Count },
+	{ "test", test_vars, test_var::Count }
+};
+const uint8_t MODE_VARS = sizeof(mode_vars) / sizeof(mode_vars[0]);
+
 // global struct to hold sensor data in one place
 #include "EulerVector3.h"
 
 struct sensor_data_struct {
+	unsigned long sample_ms; // millis() as the sensors were read, the one clock read the rest of loop() runs off
 	float water_pressure, water_temp;
+	bool pressure_fresh; // true for the loop() that read a new pressure/temperature sample
 	int count_kill_adc; // count out of 4095 of adc reading kill switch (battery voltage means system enabled)
 	int count_batt_adc; // not implemented
 	float battery_voltage; // not implemented
-	EulerVector3 e_orientation; // (e)uler
+	EulerVector3 e_orientation; // (e)uler, read it through orientation()
 } sensor_data;
 
 // logging stuff
 #include "NBDelayCallback.h"
 
+// replies and log lines are built here and sent a line at a time, so printing never touches the heap
+#include "ReplyBuffer.h"
+ReplyBuffer reply;
+
+// a binary frame every control tick while 'log:telemetry:start' has it on, for Brain and for tuning
+#include "Telemetry.h"
+Telemetry telemetry;
+
 // forward declare functions passed as function pointers
 void logSensors(void);
 void logImuCal(void);
 void logThrusters(void);
+void logTick(void);
 void logPID(void);
-void logTelemetry(void);
 
-std::map<String, NBDelayCallback> log_triggers = {
+// the Arduino IDE generates prototypes for the rest of the sketch, the host build (host/) compiles it as plain C++
+void controlTick(void);
+bool startControlTick(uint16_t hz);
+void tickStats(void);
+void heapStats(void);
+void readSensors(void);
+EulerVector3& orientation(void);
+void sendTelemetry(void);
+void readSerial(void);
+void updatePIDControllers(void);
+void updateThrusters(void);
+void bgLog(void);
+void parseCommand(char* cmd);
+float setTarget(uint8_t id, float value);
+void lockTarget(uint8_t id);
+void startPilot(void);
+void makeSafe(void);
+void EStop(void);
+void printHelp(void);
+#ifdef IMU_MPU9250
+void readMPU9250(void);
+#endif
+
+struct LogTrigger {
+	const char* name; // 'log:?:start/stop'
+	NBDelayCallback trigger;
+};
+LogTrigger log_triggers[] = {
 	{ "sensors", NBDelayCallback(200, logSensors) },
 	{ "imu_cal", NBDelayCallback(200, logImuCal) },
 	{ "thr", NBDelayCallback(200, logThrusters) },
 	{ "pid", NBDelayCallback(200, logPID) },
-	{ "telemetry", NBDelayCallback(50, logTelemetry) }
+	{ "tick", NBDelayCallback(1000, logTick) }
 };
+const uint8_t LOG_TRIGGERS = sizeof(log_triggers) / sizeof(log_triggers[0]);
 
 const int PIN_ADC_KILL = 22;
 
@@ -150,10 +258,12 @@ void setup() {
 
 	// easy way to initialize everything to a safe state and prevent premature activation
 	EStop();
-}
 
-// throwaway string that's always in scope to build messages to be printed with Serial.println()
-String msg;
+#if defined(IMU_MPU6050) || defined(IMU_MPU9250)
+	fusion.setGains(FUSION_KP, FUSION_KI);
+#endif
+	startControlTick(CONTROL_HZ);
+}
 
 namespace mode {
 	enum Interpreter {
@@ -175,9 +285,21 @@ mode::Interpreter i_mode = mode::Config;
 //		#####   ###    ###   #
 
 void loop() {
+	// control, once per tick and ahead of anything else that's waiting
+	if(control_tick.due()) {
+		controlTick();
+		control_tick.done();
+	}
+
+	// background - commands and logging, in between ticks. How long one pass of these takes
+	// is how late a tick can start, keep them short
+	readSerial();
+	bgLog();
+}
+
+void controlTick() {
 	// input
 	readSensors();
-	readSerial();
 
 	// data analysis and computation
 	updatePIDControllers();
@@ -185,36 +307,103 @@ void loop() {
 	// output
 	if(i_mode != mode::Test) updateThrusters(); // mode::Test sets thruster powers directly
 
-	// logging
-	bgLog();
+	if(telemetry.isEnabled()) sendTelemetry();
+}
+
+// (re)starts the tick at hz and runs the PID controllers at its rate, false if hz isn't allowed
+bool startControlTick(uint16_t hz) {
+	if(!control_tick.begin(hz)) return false;
+	pid.setPeriodMicros(control_tick.getPeriodMicros());
+#if defined(IMU_MPU6050) || defined(IMU_MPU9250)
+	fusion.setPeriodMicros(control_tick.getPeriodMicros());
+#endif
+	return true;
 }
 
 void readSensors() {
-	ms5803.update(MS5803_OSR_256); // 2-20 mS of delay, depending on sampling rate
-	sensor_data.water_pressure = ms5803.getPressure();
-	sensor_data.water_temp = ms5803.getTemperature();
+	sensor_data.sample_ms = millis();
+
+	// never waits, a new sample is ready every 2 conversions - every 2 ticks as long as a conversion
+	// (0.6 ms at OSR 256, 9 ms at OSR 4096) fits in a tick
+	sensor_data.pressure_fresh = ms5803.update(MS5803_OSR_256);
+	if(sensor_data.pressure_fresh) {
+		sensor_data.water_pressure = ms5803.getPressure();
+		sensor_data.water_temp = ms5803.getTemperature();
+	}
 
 #ifdef IMU_BNO055
 	imu::Vector<3> euler = bno055.getVector(Adafruit_BNO055::VECTOR_EULER);
 	sensor_data.e_orientation.set(euler.x(), euler.y(), euler.z());
 
 #elif defined(IMU_MPU6050)
+	// the library's own angles come from a filter on its own millis() clock, only its calibrated readings are used
 	mpu6050.update();
-	// yaw and roll appear to be inverted compared to bno055
-	sensor_data.e_orientation.set(-1*mpu6050.getAngleZ(), mpu6050.getAngleX(), -1*mpu6050.getAngleY());
+	fusion.update(mpu6050.getGyroX(), mpu6050.getGyroY(), mpu6050.getGyroZ(), mpu6050.getAccX(), mpu6050.getAccY(), mpu6050.getAccZ());
 
 #elif defined(IMU_MPU9250)
 	readMPU9250();
-	sensor_data.e_orientation.set(mpu9250.yaw, mpu9250.roll, mpu9250.pitch);
 
 #endif
 
 	sensor_data.count_kill_adc = analogRead(PIN_ADC_KILL);
 }
 
+// the attitude in degrees, as the sub's yaw, pitch and roll. From the MPUs it's converted out of the filter's
+// quaternion the first time it's asked for after an update, and kept for the rest of the tick
+EulerVector3& orientation() {
+#if defined(IMU_MPU6050) || defined(IMU_MPU9250)
+	static uint32_t converted = 0; // fusion update the angles are from
+	if(converted != fusion.getUpdates()) {
+		converted = fusion.getUpdates();
+		float yaw, pitch, roll;
+		fusion.getEuler(yaw, pitch, roll);
+	#ifdef IMU_MPU6050
+		// yaw and roll appear to be inverted compared to bno055. Yaw carries on past +-180 the way the
+		// library's integrated angle did, taking the turn nearest the last one - it's converted every tick
+		// the controllers run, so it can't have moved half a turn in between
+		yaw = -yaw;
+		yaw += 360 * roundf((sensor_data.e_orientation.yaw() - yaw) / 360);
+		sensor_data.e_orientation.set(yaw, roll, -pitch);
+	#else
+		sensor_data.e_orientation.set(YawAngle::wrap(yaw - MAG_DECLINATION), roll, pitch);
+	#endif
+	}
+#endif
+	return sensor_data.e_orientation;
+}
+
+// this tick's sensors, controller outputs and thruster powers, as a Telemetry frame. Dropped rather than
+// waited for when the USB buffer is full - the frame's seq still counts it, so Brain sees the gap
+void sendTelemetry() {
+	Telemetry::Frame& f = telemetry.next();
+	if(Serial.availableForWrite() < Telemetry::SIZE) return;
+
+	f.time_ms = sensor_data.sample_ms;
+	f.pressure = sensor_data.water_pressure;
+	f.temperature = sensor_data.water_temp;
+	EulerVector3& o = orientation();
+	f.yaw = o.yaw();
+	f.pitch = o.pitch();
+	f.roll = o.roll();
+	for(uint8_t i = 0; i < axis::Count; ++i) {
+		f.pid_out[i] = pid[i].getOutput();
+		if(pid[i].getMode() == PIDBase::Automatic) f.pid_auto |= 1 << i;
+	}
+	for(uint8_t i = 0; i < thr::Count; ++i) {
+		f.power[i] = thrusters[i].getPower();
+	}
+	if(sensor_data.pressure_fresh) f.flags |= Telemetry::FRESH_PRESSURE;
+	f.kill_adc = sensor_data.count_kill_adc;
+
+	Serial.write(telemetry.finish(), Telemetry::SIZE);
+}
+
 #define MAX_CHARS_PER_LOOP (20)
 #define CONFIG_ARG_SEP (' ')
-String cmd_str;
+#define MAX_CMD_LEN (63) // longer lines are dropped whole
+char cmd_buf[MAX_CMD_LEN + 1];
+uint8_t cmd_len = 0;
+bool cmd_overflow = false;
 void readSerial() {
 	uint16_t char_count = 0;
 
@@ -223,81 +412,87 @@ void readSerial() {
 		++char_count;
 
 		if(i_mode == mode::Pilot_OnChar) {
-			parseCommand(c);
+			char key[2] = { c, '\0' };
+			parseCommand(key);
 
 		} else {
 			if(c == '\n') {
-				if(cmd_str.startsWith("~~") && cmd_str.indexOf("cmd") > -1) { // if using USBSerialLink syntax, parse as such
+				cmd_buf[cmd_len] = '\0';
+				if(cmd_overflow) {
+					reply.add("ERROR Command longer than ", MAX_CMD_LEN, " chars, dropped.").send();
+				} else if(strncmp(cmd_buf, "~~", 2) == 0 && strstr(cmd_buf, "cmd")) { // if using USBSerialLink syntax, parse as such
 					// ~~field_name~type~data
-					int i = cmd_str.lastIndexOf('~'); i++; // index after syntax finish
-        			String contents = cmd_str.substring(i);
-        			Serial.print(">> "); Serial.println(contents);
-        			parseCommand(contents);
-				} else parseCommand(cmd_str); // otherwise parse directly
-				cmd_str = "";
+					char* contents = strrchr(cmd_buf, '~') + 1; // after syntax finish
+					Serial.print(">> "); Serial.println(contents);
+					parseCommand(contents);
+				} else parseCommand(cmd_buf); // otherwise parse directly
+				cmd_len = 0;
+				cmd_overflow = false;
+			} else if(cmd_len < MAX_CMD_LEN) {
+				cmd_buf[cmd_len++] = c;
 			} else {
-				cmd_str += c;
+				cmd_overflow = true;
 			}
 		}	
 	}
 }
 
-double angleWrapShortcut(double angle) {
-	// it may be possible to improve this by first finding the piece that fits within a 360 degree disk
-	// and then running the shortcut
-	if(angle > 180) angle -= 360; else if(angle < -180) angle += 360;
-	return angle;
-}
 void updatePIDControllers() {
 	// In general, the PID controller setpoints are held at zero and an error between target and measurement
 	// fed to the input. This keeps the numbers fed into the controllers predictable and low, regardless
 	// of the ranges of the sensor measurements, which makes the tuning constants easier to predict.
 
-	// For IMUs that report 0-360, a calculation can be done to minimize the angle the robot has to travel through
-#if defined(BNO055) // || defined(XXX) // or any other imu that reports in 0-360 degrees
-	pid["yaw"].setInput(angleWrapShortcut(pid_target["yaw"] - sensor_data.e_orientation.yaw()));
-	pid["pitch"].setInput(angleWrapShortcut(pid_target["pitch"] - sensor_data.e_orientation.pitch()));
-	pid["roll"].setInput(angleWrapShortcut(pid_target["roll"] - sensor_data.e_orientation.roll()));
-
-#else
-	pid["yaw"].setInput(pid_target["yaw"] - sensor_data.e_orientation.yaw());
-	pid["pitch"].setInput(pid_target["pitch"] - sensor_data.e_orientation.pitch());
-	pid["roll"].setInput(pid_target["roll"] - sensor_data.e_orientation.roll());
-#endif
-
-	pid["pressure"].setInput(pid_target["pressure"] - sensor_data.water_pressure);
-
-	// run compute() on all pid controllers
-	for(auto it = pid.begin(); it != pid.end(); ++it) {
-		it->second.compute();
+	// the angles take the shortest way round to their targets, however the IMU reports them (see setTarget())
+	EulerVector3& o = orientation();
+	pid[axis::Yaw].setInput(YawAngle::error(pid_target[axis::Yaw], o.yaw()));
+	pid[axis::Pitch].setInput(PitchAngle::error(pid_target[axis::Pitch], o.pitch()));
+	pid[axis::Roll].setInput(RollAngle::error(pid_target[axis::Roll], o.roll()));
+
+	pid[axis::Pressure].setInput(pid_target[axis::Pressure] - sensor_data.water_pressure);
+
+	// steps all the controllers that are running, this is called once per tick. Depth only has a new sample
+	// every other tick (see readSensors()), stepping it in between would make its derivative 0 one tick and
+	// two ticks' worth the next - so it steps on the samples, with its period the ticks since the last one
+	static uint8_t pressure_ticks = 0;
+	if(pressure_ticks < 255) ++pressure_ticks;
+	if(sensor_data.pressure_fresh) {
+		uint32_t us = pressure_ticks * control_tick.getPeriodMicros();
+		if(us != pid[axis::Pressure].getPeriodMicros()) pid[axis::Pressure].setPeriodMicros(us);
+		pressure_ticks = 0;
+		pid.step();
+	} else {
+		pid.step(PIDControllers::ALL & ~PIDControllers::only(axis::Pressure));
 	}
 }
 
 void updateThrusters() {
 	// see instantiations at top for location map
 
-	// yaw correction mixed on top of a base forwards / backwards velocity
-	// There is currently no way to measure velocity -> use a constant power level restricted to a low enough 
-	// value that there is still room for the motors to react to yaw changes
-	thrusters["thrust_l"].setPower(thrust_base + pid["yaw"].getOutput());
-	thrusters["thrust_r"].setPower(thrust_base - pid["yaw"].getOutput());
-
-	// mix outputs of pressure, pitch, and roll into vertical thrusters
-	// this simple approach works reasonably well as long as the sub is intended to be flat (ie ~0 targets for pitch and roll)
-	thrusters["vert_fl"].setPower(pid["pressure"].getOutput() - pid["pitch"].getOutput() + pid["roll"].getOutput());
-	thrusters["vert_bl"].setPower(pid["pressure"].getOutput() + pid["pitch"].getOutput() + pid["roll"].getOutput());
-	thrusters["vert_fr"].setPower(pid["pressure"].getOutput() - pid["pitch"].getOutput() - pid["roll"].getOutput());
-	thrusters["vert_br"].setPower(pid["pressure"].getOutput() + pid["pitch"].getOutput() - pid["roll"].getOutput());
+	// There is currently no way to measure velocity -> surge is a constant power level, thrust_base. In
+	// Priority mode the mixer takes it down as far as needed to leave the yaw correction room to work
+	float demand[dof::Count];
+	demand[dof::Heave] = pid[axis::Pressure].getOutput();
+	demand[dof::Pitch] = pid[axis::Pitch].getOutput();
+	demand[dof::Roll] = pid[axis::Roll].getOutput();
+	demand[dof::Yaw] = pid[axis::Yaw].getOutput();
+	demand[dof::Surge] = thrust_base;
+
+	// the default matrix works reasonably well as long as the sub is intended to be flat (ie ~0 targets for pitch and roll)
+	float power[thr::Count];
+	mixer.mix(demand, power);
+	for(uint8_t i = 0; i < thr::Count; ++i) {
+		thrusters[i].setPower(power[i] + (power[i] < 0 ? -0.5f : 0.5f)); // to the nearest step, not towards 0
+	}
 }
 
 void startPilot() {
 	// lock depth and yaw (keep existing settings for pitch and roll which have sane defaults)
-	parseCommand(String("pid") + CONFIG_ARG_SEP + "pressure" + CONFIG_ARG_SEP + "lock");
-	parseCommand(String("pid") + CONFIG_ARG_SEP + "yaw" + CONFIG_ARG_SEP + "lock");
+	lockTarget(axis::Pressure);
+	lockTarget(axis::Yaw);
 
 	// enable all PID controllers
-	for(auto it = pid.begin(); it != pid.end(); ++it) {
-		it->second.setMode(PID::Mode::Automatic);
+	for(uint8_t i = 0; i < axis::Count; ++i) {
+		pid[i].setMode(PIDBase::Automatic);
 	}
 }
 
@@ -305,13 +500,13 @@ void makeSafe() {
 	// thrusters
 	thrust_base = 0;
 
-	for(auto thr_it = thrusters.begin(); thr_it != thrusters.end(); ++thr_it) {
-		thr_it->second.setPower(0);
+	for(uint8_t i = 0; i < thr::Count; ++i) {
+		thrusters[i].setPower(0);
 	}
 
 	// pid controllers
-	for(auto pid_it = pid.begin(); pid_it != pid.end(); ++pid_it) {
-		pid_it->second.setMode(PID::Mode::Manual);
+	for(uint8_t i = 0; i < axis::Count; ++i) {
+		pid[i].setMode(PIDBase::Manual);
 	}
 }
 
@@ -330,7 +525,7 @@ void EStop() {
 //		   ##
 
 void printHelp(void) {
-	msg = 
+	Serial.println(
 		"Quick help:\n"
 		"* ? represents a valid string tag in the context\n"
 		"* _ represents a number\n"
@@ -359,6 +554,14 @@ void printHelp(void) {
 		"    vars:?mode:read\n"
 		"    log:?:start/stop\n"
 		"    log:stop\n"
+		"    mixer:priority/clip\n"
+		"    mixer:?:_,_,_,_,_\n"
+		"    mixer:read\n"
+		"    tick:_\n"
+		"    tick:read\n"
+		"    fusion:tune:_,_\n"
+		"    fusion:tune:read\n"
+		"    heap:read\n"
 		"    mode:pilot/pilot_/test\n"
 		"    stop/exit/quit/q/x\n"
 		"  if i_mode == Pilot || Pilot_OnChar\n"
@@ -370,8 +573,7 @@ void printHelp(void) {
 		"    ?\n"
 		"    stop/x\n"
 		"    quit/exit\n"
-	;
-	Serial.println(msg);
+	);
 }
 
 
@@ -410,7 +612,7 @@ op_mode == Enabled
 		pid:?:start/stop ~ starts or stops a single controller
 		pid:start/stop   ~ starts or stops all controllers
 
-		thrust:_ ~ set thrust_base, it will clip to +-BLThruster::PWR_MAX, although this will not gave yaw correction any room to work
+		thrust:_ ~ set thrust_base, it will clip to +-BLThruster::PWR_MAX, in mixer:clip this leaves the yaw correction no room to work
 		thrust:stop ~ alias to thrust:0
 		
 		vars:pilot:?:_     ~ set value of a variable in pilot_vars
@@ -421,9 +623,23 @@ op_mode == Enabled
 		vars:test:?:read
 		vars:test:read
 
-		log:?:start/stop  ~ start or stop the logging of a set of information
+		log:?:start/stop  ~ start or stop the logging of a set of information - sensors, imu_cal, thr, pid and tick
+		                    print text, telemetry sends a binary frame every tick (see Telemetry.h)
 		log:stop          ~ stop all logging
 
+		mixer:priority  ~ when the thrusters saturate, meet depth demand first, then attitude, then surge
+		mixer:clip      ~ when the thrusters saturate, clip each one on its own
+		mixer:?:_,_,_,_,_  ~ set how much heave, pitch, roll, yaw and surge demand goes to a thruster
+		mixer:read      ~ print the mode, how much of each group's demand got through last tick, and the matrix
+
+		tick:_     ~ set the rate of the control tick in Hz, the PID controllers follow it
+		tick:read  ~ print timing of the ticks since the last read (log:tick:start prints it every second)
+
+		fusion:tune:_,_   ~ set the MPU attitude filter's kp and ki (see Fusion.h), kp 10 at boot
+		fusion:tune:read  ~ print them
+
+		heap:read  ~ print bytes on the heap now and the most it has ever been grown to (log:tick:start prints these too)
+
 		mode:pilot/pilot_  ~ enter pilot mode; 'pilot' is \n-based, 'pilot_' is char-based
 		mode:test          ~ enter thruster testing mode
 
@@ -475,13 +691,328 @@ op_mode == Enabled
 
 #define ERR_BAD_SYNTAX ("ERROR Bad syntax")
 
-std::vector<String> args;
-void parseCommand(String cmd) {
-	String msg;
+#define MAX_ARGS (6)
+
+// every change to a target goes through here, so the angles are in the IMU's range by the time
+// updatePIDControllers() takes the error - 'pid yaw 370' and 10 are the same heading
+float setTarget(uint8_t id, float value) {
+	switch(id) {
+		case axis::Yaw: value = YawAngle::wrap(value); break;
+		case axis::Pitch: value = PitchAngle::wrap(value); break;
+		case axis::Roll: value = RollAngle::wrap(value); break;
+	}
+	return pid_target[id] = value;
+}
+
+// stores where the sub is now as a controller's target
+void lockTarget(uint8_t id) {
+	float target = 0;
+	switch(id) {
+		case axis::Yaw: target = orientation().yaw(); break;
+		case axis::Pitch: target = orientation().pitch(); break;
+		case axis::Roll: target = orientation().roll(); break;
+		case axis::Pressure: target = sensor_data.water_pressure; break;
+	}
+	reply.add("CMD config.pid.", axis_names[id], ".lock -> ", setTarget(id, target)).send();
+}
+
+// config commands, argv is the line split on CONFIG_ARG_SEP with the command's own name in argv[0]
+
+void cmdPid(uint8_t argc, char** argv) { // pid:
+	using str_util::equals;
+	if(argc == 2) {
+		if(equals(argv[1], "stop")) { // pid:stop
+			for(uint8_t i = 0; i < axis::Count; ++i) {
+				pid[i].setMode(PIDBase::Manual);
+			}
+			Serial.println("CMD config.pid.stop -> All PID controllers stopped.");
+
+		} else if(equals(argv[1], "start")) { // pid:start
+			for(uint8_t i = 0; i < axis::Count; ++i) {
+				pid[i].setMode(PIDBase::Automatic);
+			}
+			Serial.println("CMD config.pid.start -> All PID controllers started.");
+		}
+
+	} else if(argc == 3) {
+		int8_t id = lookupId(axis_names, axis::Count, argv[1]);
+		if(id >= 0) { // ensure pid tag is valid
+			if(equals(argv[2], "start")) { // pid:?:start
+				pid[id].setMode(PIDBase::Automatic);
+				reply.add("CMD config.pid.", argv[1], ".start -> ", argv[1], " controller started.").send();
+
+			} else if(equals(argv[2], "stop")) { // pid:?:stop
+				pid[id].setMode(PIDBase::Manual);
+				reply.add("CMD config.pid.", argv[1], ".stop -> ", argv[1], " controller stopped.").send();
+
+			} else if(equals(argv[2], "lock")) { // pid:?:lock
+				lockTarget(id);
+
+			} else if(equals(argv[2], "read")) { // pid:?:read
+				reply.add("CMD config.pid.", argv[1], ".read: ", pid_target[id]).send();
+
+			} else { // pid:?:+/-_ or pid:?:_
+				float val = atof(argv[2]);
+				char sign = argv[2][0];
+				if(sign == '+' || sign == '-') val += pid_target[id];
+				reply.add("CMD config.pid.", argv[1], " -> ", setTarget(id, val)).send();
+			}
+		} else if(equals(argv[1], "tune") && equals(argv[2], "read")) { // pid:tune:read
+			Serial.println("CMD config.pid.tune.read:");
+			for(uint8_t i = 0; i < axis::Count; ++i) {
+				PIDControllers::Channel tmp = pid[i];
+				reply.add("   ", axis_names[i], ": p = ", tmp.getKp(), ", i = ", tmp.getKi(), ", d = ", tmp.getKd()).send();
+			}
+		}
+	} else if(argc == 4 && equals(argv[2], "tune")) {
+		int8_t id = lookupId(axis_names, axis::Count, argv[1]);
+		if(id >= 0) {
+			if(equals(argv[3], "read")) { // pid:?:tune:read
+				PIDControllers::Channel tmp = pid[id];
+				reply.add("CMD config.pid.", argv[1], ".tune.read: p = ", tmp.getKp(), ", i = ", tmp.getKi(), ", d = ", tmp.getKd()).send();
+
+			} else { // pid:?:tune:_,_,_
+				char* tunings[3];
+				if(str_util::tokenize(argv[3], ',', tunings, 3) == 3) {
+					PIDControllers::Channel tmp = pid[id];
+					tmp.setTunings(atof(tunings[0]), atof(tunings[1]), atof(tunings[2]));
+					reply.add("CMD config.pid.", argv[1], ".tune -> p = ", tmp.getKp(), ", i = ", tmp.getKi(), ", d = ", tmp.getKd()).send();
+				}
+			}
+		}
+	}
+}
+
+void cmdThrust(uint8_t argc, char** argv) { // thrust:
+	if(argc == 2) {
+		if(str_util::equals(argv[1], "stop")) {
+			thrust_base = 0;
+			Serial.println("CMD thrust.stop -> thrust_base = 0");
+		} else {
+			float new_pwr = atof(argv[1]);
+			new_pwr = constrain(new_pwr, BLThruster::PWR_MIN, BLThruster::PWR_MAX);
+			thrust_base = new_pwr;
+			reply.add("CMD thrust -> thrust_base = ", thrust_base).send();
+		}
+	}
+}
+
+void cmdVars(uint8_t argc, char** argv) { // vars:
+	using str_util::equals;
+	if(argc < 3) return;
+
+	const ModeVars* these_vars = NULL; // vars:?
+	for(uint8_t m = 0; m < MODE_VARS; ++m) {
+		if(equals(argv[1], mode_vars[m].mode)) these_vars = &mode_vars[m];
+	}
+	if(!these_vars) return;
+
+	if(argc == 3) {
+		if(equals(argv[2], "read")) { // vars:?:read
+			reply.add("CMD config.vars.", argv[1], ".read:").send();
+			for(uint8_t i = 0; i < these_vars->count; ++i) {
+				reply.add("   ", these_vars->vars[i].name, ": ", these_vars->vars[i].value).send();
+			}
+		}
+	} else if(argc == 4) { // vars:?:?:
+		ModeVar* var = NULL;
+		for(uint8_t i = 0; i < these_vars->count; ++i) {
+			if(equals(argv[2], these_vars->vars[i].name)) var = &these_vars->vars[i];
+		}
+		if(!var) return;
+
+		if(equals(argv[3], "read")) { // vars:?:?:read
+			reply.add("CMD config.vars.", argv[1], ".", argv[2], ".read: ", var->value).send();
+
+		} else { // vars:?:?:_
+			// put mode specific constraint behavior here
+			// if(var == &pilot_vars[...]) ... else ...
+			var->value = atof(argv[3]);
+			reply.add("CMD config.vars.", argv[1], ".", argv[2], " -> ", var->value).send();
+		}
+	}
+}
+
+void cmdLog(uint8_t argc, char** argv) { // log:
+	using str_util::equals;
+	if(argc == 2) {
+		if(equals(argv[1], "stop")) { // log:stop
+			for(uint8_t i = 0; i < LOG_TRIGGERS; ++i) {
+				log_triggers[i].trigger.setEnabled(false);
+			}
+			telemetry.setEnabled(false);
+			Serial.println("CMD config.log.stop -> All loggers disabled.");
+		}
+	} else if(argc == 3) {
+		LogTrigger* log = NULL;
+		for(uint8_t i = 0; i < LOG_TRIGGERS; ++i) {
+			if(equals(argv[1], log_triggers[i].name)) log = &log_triggers[i];
+		}
+		bool frames = equals(argv[1], "telemetry"); // every tick rather than on a delay, controlTick() sends it
+		int val = ( equals(argv[2], "start") ? 1 : ( equals(argv[2], "stop") ? 0 : -1 ) ); // ternary for the win!
+		if((log || frames) && val > -1) {
+			if(frames) telemetry.setEnabled( (bool)val ); else log->trigger.setEnabled( (bool)val ); // log:?:start/stop
+			reply.add("CMD config.log.", argv[1], ".", argv[2], " -> Logging for ", argv[1], (val > 0 ? " enabled." : " disabled.")).send();
+		}
+	}
+}
+
+void cmdMixer(uint8_t argc, char** argv) { // mixer:
+	using str_util::equals;
+	if(argc == 2) {
+		if(equals(argv[1], "read")) { // mixer:read
+			reply.add("CMD mixer.read: ", (mixer.getMode() == Mixer::Priority ? "priority" : "clip"), ", last scale");
+			for(uint8_t g = 0; g < Mixer::GROUPS; ++g) reply.add(" ", Mixer::GROUP_NAMES[g], " = ", mixer.getScale(g));
+			reply.send();
+			for(uint8_t t = 0; t < thr::Count; ++t) {
+				reply.add("   ", thruster_names[t], ":");
+				for(uint8_t d = 0; d < dof::Count; ++d) reply.add(" ", dof_names[d], " = ", mixer.getEntry(t, d));
+				reply.send();
+			}
+		} else if(equals(argv[1], "priority")) { // mixer:priority
+			mixer.setMode(Mixer::Priority);
+			Serial.println("CMD mixer -> priority: depth, then attitude, then surge.");
+		} else if(equals(argv[1], "clip")) { // mixer:clip
+			mixer.setMode(Mixer::Clip);
+			Serial.println("CMD mixer -> clip: each thruster clipped on its own.");
+		}
+	} else if(argc == 3) { // mixer:?:_,_,_,_,_
+		int8_t id = lookupId(thruster_names, thr::Count, argv[1]);
+		char* entries[dof::Count];
+		if(id >= 0 && str_util::tokenize(argv[2], ',', entries, dof::Count) == dof::Count) {
+			float row[dof::Count];
+			reply.add("CMD mixer.", argv[1], " ->");
+			for(uint8_t d = 0; d < dof::Count; ++d) {
+				row[d] = atof(entries[d]);
+				reply.add(" ", dof_names[d], " = ", row[d]);
+			}
+			mixer.setRow(id, row);
+			reply.send();
+		}
+	}
+}
+
+void cmdTick(uint8_t argc, char** argv) { // tick:
+	if(argc == 2) {
+		if(str_util::equals(argv[1], "read")) { // tick:read
+			reply.add("CMD tick.read: ");
+			tickStats();
+			reply.send();
+		} else { // tick:_
+			// checked as a long before it's narrowed, or 65546 would wrap round to 10. strtol() saturates
+			// rather than overflowing on anything longer
+			long hz = strtol(argv[1], NULL, 10);
+			if(hz >= ControlTick::MIN_HZ && hz <= ControlTick::MAX_HZ && startControlTick((uint16_t)hz)) {
+				reply.add("CMD tick -> ", control_tick.getRate(), " Hz").send();
+			} else {
+				reply.add("ERROR tick -> ", argv[1], " Hz is outside ", ControlTick::MIN_HZ, " - ", ControlTick::MAX_HZ).send();
+			}
+		}
+	}
+}
+
+void cmdFusion(uint8_t argc, char** argv) { // fusion:
+#if defined(IMU_MPU6050) || defined(IMU_MPU9250)
+	if(argc == 3 && str_util::equals(argv[1], "tune")) {
+		if(str_util::equals(argv[2], "read")) { // fusion:tune:read
+			reply.add("CMD config.fusion.tune.read: kp = ", fusion.getKp(), ", ki = ", fusion.getKi()).send();
+		} else { // fusion:tune:_,_
+			char* gains[2];
+			if(str_util::tokenize(argv[2], ',', gains, 2) == 2 && atof(gains[0]) >= 0 && atof(gains[1]) >= 0) {
+				fusion.setGains(atof(gains[0]), atof(gains[1]));
+				reply.add("CMD config.fusion.tune -> kp = ", fusion.getKp(), ", ki = ", fusion.getKi()).send();
+			}
+		}
+	}
+#else
+	Serial.println("ERROR fusion -> only the MPUs have an attitude filter");
+#endif
+}
+
+void cmdHeap(uint8_t argc, char** argv) { // heap:
+	if(argc == 2 && str_util::equals(argv[1], "read")) { // heap:read
+		reply.add("CMD heap.read: ");
+		heapStats();
+		reply.send();
+	}
+}
+
+void cmdMode(uint8_t argc, char** argv) { // mode:
+	using str_util::equals;
+	if(argc == 2) {
+		if(equals(argv[1], "pilot")) { // mode:pilot
+			startPilot();
+			i_mode = mode::Pilot;
+			Serial.println("CMD config.mode -> Pilot - Parse on \\n.");
+		} else if(equals(argv[1], "pilot_")) { // mode:pilot_
+			startPilot();
+			i_mode = mode::Pilot_OnChar;
+			Serial.println("CMD config.mode -> Pilot - Parse each char.");
+		} else if(equals(argv[1], "test")) { // mode:test
+			i_mode = mode::Test;
+			makeSafe();
+			Serial.println("CMD config.mode -> Test.");
+		}
+	}
+}
+
+void cmdStop(uint8_t argc, char** argv) { // stop/exit/quit/q/x
+	makeSafe();
+	Serial.println("CMD stop -> Made safe.");
+}
+
+// the config commands by the first word of the line. Looked up by hash, so finding one costs the
+// same whichever it is - the name is only compared to rule out a collision
+struct Command {
+	uint32_t hash; // str_util::hash(name), worked out by the compiler
+	const char* name;
+	void (*run)(uint8_t argc, char** argv);
+};
+#define COMMAND(name, run) { str_util::hash(name), name, run }
+
+constexpr Command config_commands[] = {
+	COMMAND("pid", cmdPid),
+	COMMAND("thrust", cmdThrust),
+	COMMAND("vars", cmdVars),
+	COMMAND("log", cmdLog),
+	COMMAND("mixer", cmdMixer),
+	COMMAND("tick", cmdTick),
+	COMMAND("fusion", cmdFusion),
+	COMMAND("heap", cmdHeap),
+	COMMAND("mode", cmdMode),
+	COMMAND("stop", cmdStop),
+	COMMAND("exit", cmdStop),
+	COMMAND("quit", cmdStop),
+	COMMAND("q", cmdStop),
+	COMMAND("x", cmdStop)
+};
+
+// cmd is split in place
+void runConfigCommand(char* cmd) {
+	char* argv[MAX_ARGS];
+	int8_t argc = str_util::tokenize(cmd, CONFIG_ARG_SEP, argv, MAX_ARGS);
+	if(argc < 0) {
+		Serial.println(ERR_BAD_SYNTAX);
+		return;
+	}
+	if(argc == 0) return;
+
+	uint32_t hash = str_util::hash(argv[0]);
+	for(uint8_t i = 0; i < sizeof(config_commands) / sizeof(config_commands[0]); ++i) {
+		const Command& c = config_commands[i];
+		if(c.hash == hash && str_util::equals(c.name, argv[0])) {
+			c.run(argc, argv);
+			return;
+		}
+	}
+}
+
+void parseCommand(char* cmd) {
+	using str_util::equals;
 
 	switch(op_mode) {
 		case mode::Disabled:
-			if(cmd.equals("SAFE")) {
+			if(equals(cmd, "SAFE")) {
 				op_mode = mode::Enabled;
 				i_mode = mode::Config;
 				Serial.println("INFO System Enabled. Interpreter mode -> Config");
@@ -490,10 +1021,10 @@ void parseCommand(String cmd) {
 			break;
 
 		case mode::Enabled:
-			if(cmd.equals("ESTOP")) {
+			if(equals(cmd, "ESTOP")) {
 				EStop();
 				return;
-			} else if(cmd.equals("help")) {
+			} else if(equals(cmd, "help")) {
 				printHelp();
 				return;
 			}
@@ -507,170 +1038,7 @@ void parseCommand(String cmd) {
 
 			switch(i_mode) {
 				case mode::Config:
-				{
-					str_util::split(cmd, CONFIG_ARG_SEP, args);
-					uint8_t num_args = args.size();
-
-					if(num_args > 0) {
-						if(args[0].equals("pid")) { // pid:
-							if(num_args == 2) {
-								if(args[1].equals("stop")) { // pid:stop
-									for(auto it = pid.begin(); it != pid.end(); ++it) {
-										it->second.setMode(PID::Mode::Manual);
-									}
-									Serial.println("CMD config.pid.stop -> All PID controllers stopped.");
-
-								} else if(args[1].equals("start")) { // pid:start
-									for(auto it = pid.begin(); it != pid.end(); ++it) {
-										it->second.setMode(PID::Mode::Automatic);
-									}
-									Serial.println("CMD config.pid.start -> All PID controllers started.");
-								}
-
-							} else if(num_args == 3) {
-								if(pid.count(args[1]) > 0) { // ensure pid tag is valid
-									if(args[2].equals("start")) { // pid:?:start
-										pid[args[1]].setMode(PID::Mode::Automatic);
-										msg = String("CMD config.pid.") + args[1] + ".start -> " + args[1] + " controller started."; Serial.println(msg);
-
-									} else if(args[2].equals("stop")) { // pid:?:stop
-										pid[args[1]].setMode(PID::Mode::Manual);
-										msg = String("CMD config.pid.") + args[1] + ".stop -> " + args[1] + " controller stopped."; Serial.println(msg);
-									
-									} else if(args[2].equals("lock")) { // pid:?:lock
-										// pretty much the only one that has to be filled manually
-										bool print_success = true;
-										float& target = pid_target[args[1]];
-										if(args[1].equals("yaw")) {
-											target = sensor_data.e_orientation.yaw();
-										} else if(args[1].equals("pitch")) {
-											target = sensor_data.e_orientation.pitch();
-										} else if(args[1].equals("roll")) {
-											target = sensor_data.e_orientation.roll();
-										} else if(args[1].equals("pressure")) {
-											target = sensor_data.water_pressure;
-										} else {
-											msg = String("ERROR config.pid.") + args[1] + ".lock -> " + args[1] + " not registered in pid_target[].";
-											Serial.println(msg);
-											print_success = false;
-										}
-										if(print_success) msg = String("CMD config.pid.") + args[1] + ".lock -> " + target; Serial.println(msg);
-									
-									} else if(args[2].equals("read")) { // pid:?:read
-										msg = String("CMD config.pid.") + args[1] + ".read: " + pid_target[args[1]]; Serial.println(msg);
-
-									} else { // pid:?:+/-_ or pid:?:_
-										float val = args[2].toFloat();
-										char sign = args[2].charAt(0);
-										float& target = pid_target[args[1]];
-										if(sign == '+' || sign == '-') target += val; else target = val;
-										msg = String("CMD config.pid.") + args[1] + " -> " + target; Serial.println(msg);
-									}
-								} else if(args[1].equals("tune") && args[2].equals("read")) { // pid:tune:read
-									Serial.println("CMD config.pid.tune.read:");
-									for(auto it = pid_order.begin(); it != pid_order.end(); ++it) {
-										PID& tmp = pid[*it];
-										msg = String("   ") + *it + ": p = " + tmp.getKp() + ", i = " + tmp.getKi() + ", d = " + tmp.getKd();
-										Serial.println(msg);
-									}
-								}
-							} else if(num_args == 4 && args[2].equals("tune")) {
-								if(pid.count(args[1]) > 0) {
-									if(args[3].equals("read")) { // pid:?:tune:read
-										PID& tmp = pid[args[1]];
-										msg = String("CMD config.pid.") + args[1] + ".tune.read: p = " + tmp.getKp() + ", i = " + tmp.getKi() + ", d = " + tmp.getKd();
-										Serial.println(msg);
-
-									} else if(args[3].indexOf(',') > -1) { // probably pid:?:tune:_,_,_
-										std::vector<String> tunings;
-										str_util::split(args[3], ',', tunings);
-										if(tunings.size() == 3) { // pid:?:tune:_,_,_
-											PID& tmp = pid[args[1]];
-											tmp.setTunings(tunings[0].toFloat(), tunings[1].toFloat(), tunings[2].toFloat());
-											msg = String("CMD config.pid.") + args[1] + ".tune -> p = " + tmp.getKp() + ", i = " + tmp.getKi() + ", d = " + tmp.getKd();
-											Serial.println(msg);
-										}
-									}
-								}
-							}
-
-						} else if(args[0].equals("thrust")) {
-							if(num_args == 2) {
-								if(args[1].equals("stop")) {
-									thrust_base = 0;
-									Serial.println("CMD thrust.stop -> thrust_base = 0");
-								} else {
-									float new_pwr = args[1].toFloat();
-									new_pwr = constrain(new_pwr, BLThruster::PWR_MIN, BLThruster::PWR_MAX);
-									thrust_base = new_pwr;
-									msg = String("CMD thrust -> thrust_base = ") + thrust_base; Serial.println(msg);
-								}
-							}
-
-						} else if(args[0].equals("vars")) { // vars:
-							if(mode_vars.count(args[1]) > 0) { // vars:?
-								std::map<String, float>& these_vars = mode_vars[args[1]];
-								if(num_args == 3) {
-									if(args[2].equals("read")) { // vars:?:read
-										msg = String("CMD config.vars.") + args[1] + ".read:\n";
-										for(auto it = these_vars.begin(); it != these_vars.end(); ++it) {
-											msg += "   " + it->first + ": " + it->second + "\n";
-										}
-										Serial.println(msg);
-									}
-								} else if(num_args == 4 && these_vars.count(args[2]) > 0) { // vars:?:?:
-									if(args[3].equals("read")) { // vars:?:?:read
-										msg = String("CMD config.vars.") + args[1] + "." + args[2] + ".read: " + these_vars[args[2]]; Serial.println(msg);
-
-									} else { // vars:?:?:_
-										// put mode specific constraint behavior here
-										// if(args[2].equals("...")) ... else ...
-										these_vars[args[2]] = args[3].toFloat();
-										msg = String("CMD config.vars.") + args[1] + "." + args[2] + " -> " + these_vars[args[2]]; Serial.println(msg);
-									}
-								}
-							}
-
-						} else if(args[0].equals("log")) { // log:
-							if(num_args == 2) {
-								if(args[1].equals("stop")) { // log:stop
-									for(auto it = log_triggers.begin(); it != log_triggers.end(); ++it) {
-										it->second.setEnabled(false);
-									}
-									Serial.println("CMD config.log.stop -> All loggers disabled.");
-								}
-							} else if(num_args == 3 && log_triggers.count(args[1]) > 0) {
-								int val = ( args[2].equals("start") ? 1 : ( args[2].equals("stop") ? 0 : -1 ) ); // ternary for the win!
-								if(val > -1) {
-									log_triggers[args[1]].setEnabled( (bool)val ); // log:?:start/stop
-									msg = String("CMD config.log.") + args[1] + "." + args[2] + " -> Logging for " + args[1] + (val > 0 ? " enabled." : " disabled.");
-									Serial.println(msg);
-								}
-							}
-
-						} else if(args[0].equals("mode")) { // mode:
-							if(num_args == 2) {
-								if(args[1].equals("pilot")) { // mode:pilot
-									startPilot(); // run before changing i_mode, otherwise text commands to config mode are invalid
-									i_mode = mode::Pilot;
-									Serial.println("CMD config.mode -> Pilot - Parse on \\n.");
-								} else if(args[1].equals("pilot_")) { // mode:pilot_
-									startPilot(); // run before changing i_mode, otherwise text commands to config mode are invalid
-									i_mode = mode::Pilot_OnChar;
-									Serial.println("CMD config.mode -> Pilot - Parse each char.");
-								} else if(args[1].equals("test")) { // mode:test
-									i_mode = mode::Test;
-									makeSafe();
-									Serial.println("CMD config.mode -> Test.");
-								}
-							}
-
-						} else if(args[0].equals("stop") || args[0].equals("exit") || args[0].equals("quit") || args[0].equals("q") || args[0].equals("x")) {
-							makeSafe();
-							Serial.println("CMD stop -> Made safe.");
-						}
-					}
-				}
+					runConfigCommand(cmd);
 					break;
 
 
@@ -684,63 +1052,75 @@ void parseCommand(String cmd) {
 					Serial.print(" ... "); // send a separator so the response message doesn't end up appended to the command char
 				case mode::Pilot:
 				{
-					std::map<String, float>& pilot_vars = mode_vars["pilot"];
-
-					if(cmd.equals("i")) { // forwards
-						if(thrust_base > 0) {
-							if(abs(thrust_base) < pilot_vars["lim_base"]) thrust_base += pilot_vars["step_thrust"];
-						} else {
-							thrust_base = pilot_vars["jump_thrust"];
-						}
-						thrust_base = constrain(thrust_base, 0, pilot_vars["lim_base"]);
-						Serial.print("CMD pilot.Forward @ "); Serial.println(thrust_base);
-
-					} else if(cmd.equals(",")) { // backwards
-						if(thrust_base < 0) {
-							if(abs(thrust_base) < pilot_vars["lim_base"]) thrust_base -= pilot_vars["step_thrust"];
-						} else {
-							thrust_base = -1*pilot_vars["jump_thrust"];
-						}
-						thrust_base = constrain(thrust_base, -1*pilot_vars["lim_base"], 0);
-						Serial.print("CMD pilot.Reverse @ "); Serial.println(thrust_base);
-
-					} else if(cmd.equals("k")) { // halt forward/backward motion
-						thrust_base = 0;
-						Serial.println("CMD pilot.Halt");
-
-					} else if(cmd.equals("J")) { // left big
-						pid_target["yaw"] -= pilot_vars["jump_yaw"];
-						Serial.print("CMD pilot.Left -> "); Serial.println(pid_target["yaw"]);
-
-					} else if(cmd.equals("j")) { // left small
-						pid_target["yaw"] -= pilot_vars["step_yaw"];
-						Serial.print("CMD pilot.Left -> "); Serial.println(pid_target["yaw"]);
-
-					} else if(cmd.equals("L")) { // right big
-						pid_target["yaw"] += pilot_vars["jump_yaw"];
-						Serial.print("CMD pilot.Right -> "); Serial.println(pid_target["yaw"]);
-
-					} else if(cmd.equals("l")) { // right small
-						pid_target["yaw"] += pilot_vars["step_yaw"];
-						Serial.print("CMD pilot.Right -> "); Serial.println(pid_target["yaw"]);
-
-					} else if(cmd.equals("u")){ // ascend
-						pid_target["pressure"] -= pilot_vars["step_pressure"];
-						Serial.print("CMD pilot.Ascend -> "); Serial.println(pid_target["pressure"]);
-
-					} else if(cmd.equals("m")){ // descend
-						pid_target["pressure"] += pilot_vars["step_pressure"];
-						Serial.print("CMD pilot.Descend -> "); Serial.println(pid_target["pressure"]);
-
-					} else if(cmd.equals("q")) { // exit mode
-						i_mode = mode::Config;
-						Serial.println("CMD pilot.Quit -> Returning to Config mode. Retaining behavior.");
-
-					} else if(cmd.equals("Q")) {
-						i_mode = mode::Config;
-						makeSafe();
-						Serial.println("CMD pilot.QuitAndSafe -> Returning to Config mode. Making safe.");
-
+					if(cmd[0] == '\0' || cmd[1] != '\0') break; // every key is a single char
+
+					float lim_base = pilot_vars[pilot_var::LimBase].value;
+					switch(cmd[0]) {
+						case 'i': // forwards
+							if(thrust_base > 0) {
+								if(abs(thrust_base) < lim_base) thrust_base += pilot_vars[pilot_var::StepThrust].value;
+							} else {
+								thrust_base = pilot_vars[pilot_var::JumpThrust].value;
+							}
+							thrust_base = constrain(thrust_base, 0, lim_base);
+							Serial.print("CMD pilot.Forward @ "); Serial.println(thrust_base);
+							break;
+
+						case ',': // backwards
+							if(thrust_base < 0) {
+								if(abs(thrust_base) < lim_base) thrust_base -= pilot_vars[pilot_var::StepThrust].value;
+							} else {
+								thrust_base = -1*pilot_vars[pilot_var::JumpThrust].value;
+							}
+							thrust_base = constrain(thrust_base, -1*lim_base, 0);
+							Serial.print("CMD pilot.Reverse @ "); Serial.println(thrust_base);
+							break;
+
+						case 'k': // halt forward/backward motion
+							thrust_base = 0;
+							Serial.println("CMD pilot.Halt");
+							break;
+
+						case 'J': // left big
+							setTarget(axis::Yaw, pid_target[axis::Yaw] - pilot_vars[pilot_var::JumpYaw].value);
+							Serial.print("CMD pilot.Left -> "); Serial.println(pid_target[axis::Yaw]);
+							break;
+
+						case 'j': // left small
+							setTarget(axis::Yaw, pid_target[axis::Yaw] - pilot_vars[pilot_var::StepYaw].value);
+							Serial.print("CMD pilot.Left -> "); Serial.println(pid_target[axis::Yaw]);
+							break;
+
+						case 'L': // right big
+							setTarget(axis::Yaw, pid_target[axis::Yaw] + pilot_vars[pilot_var::JumpYaw].value);
+							Serial.print("CMD pilot.Right -> "); Serial.println(pid_target[axis::Yaw]);
+							break;
+
+						case 'l': // right small
+							setTarget(axis::Yaw, pid_target[axis::Yaw] + pilot_vars[pilot_var::StepYaw].value);
+							Serial.print("CMD pilot.Right -> "); Serial.println(pid_target[axis::Yaw]);
+							break;
+
+						case 'u': // ascend
+							pid_target[axis::Pressure] -= pilot_vars[pilot_var::StepPressure].value;
+							Serial.print("CMD pilot.Ascend -> "); Serial.println(pid_target[axis::Pressure]);
+							break;
+
+						case 'm': // descend
+							pid_target[axis::Pressure] += pilot_vars[pilot_var::StepPressure].value;
+							Serial.print("CMD pilot.Descend -> "); Serial.println(pid_target[axis::Pressure]);
+							break;
+
+						case 'q': // exit mode
+							i_mode = mode::Config;
+							Serial.println("CMD pilot.Quit -> Returning to Config mode. Retaining behavior.");
+							break;
+
+						case 'Q':
+							i_mode = mode::Config;
+							makeSafe();
+							Serial.println("CMD pilot.QuitAndSafe -> Returning to Config mode. Making safe.");
+							break;
 					}
 				}
 					break;
@@ -754,38 +1134,37 @@ void parseCommand(String cmd) {
 
 				case mode::Test:
 				{
-					std::map<String, float>& test_vars = mode_vars["test"];
+					float power = test_vars[test_var::Power].value;
 
-					if(cmd.equals("list")) {
-						msg = String("CMD test.list: [ ");
-						for(auto it = thrusters.begin(); it != thrusters.end(); ++it) {
-							msg += it->first + " ";
+					if(equals(cmd, "list")) {
+						reply.add("CMD test.list: [ ");
+						for(uint8_t i = 0; i < thr::Count; ++i) {
+							reply.add(thruster_names[i], " ");
 						}
-						msg += " ]"; Serial.println(msg);
+						reply.add(" ]").send();
 
-					} else if(cmd.equals("x") || cmd.equals("stop")) {
-						for(auto it = thrusters.begin(); it != thrusters.end(); ++it) {
-							it->second.setPower(0);
+					} else if(equals(cmd, "x") || equals(cmd, "stop")) {
+						for(uint8_t i = 0; i < thr::Count; ++i) {
+							thrusters[i].setPower(0);
 						}
 						Serial.println("CMD test.stop -> Set power of all thrusters to 0.");
 
-					} else if(cmd.equals("quit") || cmd.equals("exit")) {
+					} else if(equals(cmd, "quit") || equals(cmd, "exit")) {
 						i_mode = mode::Config;
 						makeSafe();
 						Serial.println("CMD test.Quit -> Config.");
 
-					} else if(!cmd.equals("")) {
-						String list = "";
-						for(auto it = thrusters.begin(); it != thrusters.end(); ++it) {
-							if(it->first.indexOf(cmd) > -1) {
-								it->second.setPower(test_vars["power"]);
-								list += it->first + " ";
+					} else if(cmd[0] != '\0') {
+						bool any = false;
+						reply.add("CMD test.set -> [ ");
+						for(uint8_t i = 0; i < thr::Count; ++i) {
+							if(strstr(thruster_names[i], cmd)) {
+								thrusters[i].setPower(power);
+								reply.add(thruster_names[i], " ");
+								any = true;
 							}
 						}
-						if(!list.equals("")) {
-							msg = String("CMD test.set -> [ ") + list + "] to " + test_vars["power"];
-							Serial.println(msg);
-						}
+						if(any) reply.add("] to ", power).send(); else reply.clear();
 					}
 				}
 					break;
@@ -806,29 +1185,27 @@ void parseCommand(String cmd) {
 
 
 void bgLog() {
-	for(auto it = log_triggers.begin(); it != log_triggers.end(); ++it) {
-		it->second.update();
+	for(uint8_t i = 0; i < LOG_TRIGGERS; ++i) {
+		log_triggers[i].trigger.update(sensor_data.sample_ms);
 	}
 }
 
 void logSensors(void) {
 	Serial.println("INFO log.sensors...");
-	msg = String("INFO Pressure (mbar): ") + sensor_data.water_pressure; Serial.println(msg);
-	msg = String("INFO Temperature (C): ") + sensor_data.water_temp; Serial.println(msg);
-	msg = String("INFO Orientation (degrees): Yaw = ") + sensor_data.e_orientation.yaw()
-		+ " Pitch = " + sensor_data.e_orientation.pitch()
-		+ " Roll = " + sensor_data.e_orientation.roll(); Serial.println(msg);
-	msg = String("INFO Kill ADC (cnt): ") + sensor_data.count_kill_adc; Serial.println(msg);
+	reply.add("INFO Pressure (mbar): ", sensor_data.water_pressure).send();
+	reply.add("INFO Temperature (C): ", sensor_data.water_temp).send();
+	reply.add("INFO Orientation (degrees): Yaw = ", orientation().yaw(),
+		" Pitch = ", orientation().pitch(),
+		" Roll = ", orientation().roll()).send();
+	reply.add("INFO Kill ADC (cnt): ", sensor_data.count_kill_adc).send();
 	Serial.println();
 }
 
 void logPID(void) {
 	Serial.println("INFO log.pid...");
-	for(auto it = pid_order.begin(); it != pid_order.end(); ++it) {
-		PID& tmp = pid[*it];
-		float& tmp_val = pid_target[*it];
-		msg = String("INFO ") + *it + ": target = " + tmp_val + " | in = " + tmp.getInput() + " out = " + tmp.getOutput();
-		Serial.println(msg);
+	for(uint8_t i = 0; i < axis::Count; ++i) {
+		PIDControllers::Channel tmp = pid[i];
+		reply.add("INFO ", axis_names[i], ": target = ", pid_target[i], " | in = ", tmp.getInput(), " out = ", tmp.getOutput()).send();
 	}
 	Serial.println();
 }
@@ -838,9 +1215,7 @@ void logImuCal(void) {
 #ifdef IMU_BNO055
 	uint8_t sys, gyro, accel, mag;
 	bno055.getCalibration(&sys, &gyro, &accel, &mag); // this blocks the entire program if it fails to get the data
-	msg = String("INFO Imu Cal: Sys = ") + sys + ", Gyro = " + gyro + ", Accel = "
-		+ accel + ", Mag = " + mag;
-	Serial.println(msg);
+	reply.add("INFO Imu Cal: Sys = ", sys, ", Gyro = ", gyro, ", Accel = ", accel, ", Mag = ", mag).send();
 
 #elif defined(IMU_MPU6050)
 	Serial.println("INFO Imu Cal: Not implemented for MPU6050.");
@@ -851,15 +1226,40 @@ void logImuCal(void) {
 
 void logThrusters(void) {
 	Serial.println("INFO log.thr...");
-	msg = String("INFO Thrusters: L") + thrusters["thrust_l"].getPower() + " R" + thrusters["thrust_r"].getPower() + " | ";
-	msg += String("FL") + thrusters["vert_fl"].getPower() + " BL" + thrusters["vert_bl"].getPower()
-	+ " BR" + thrusters["vert_br"].getPower() + " FR" + thrusters["vert_fr"].getPower();
-	Serial.println(msg); Serial.println();
+	reply.add("INFO Thrusters: L", thrusters[thr::ThrustL].getPower(), " R", thrusters[thr::ThrustR].getPower(), " | ");
+	reply.add("FL", thrusters[thr::VertFL].getPower(), " BL", thrusters[thr::VertBL].getPower(),
+		" BR", thrusters[thr::VertBR].getPower(), " FR", thrusters[thr::VertFR].getPower());
+	reply.send(); Serial.println();
+}
+
+// timing of the ticks since it was last called, appended to reply: how many ran and how many were dropped
+// because the one before was still waiting, and the latency, interval and work time ControlTick measures
+void tickStats(void) {
+	ControlTick::Stats st = control_tick.takeStats();
+	reply.add(control_tick.getRate(), " Hz, ", st.ticks, " ticks, ", st.missed, " missed");
+	if(st.ticks > 0) {
+		reply.add(" | latency us: avg ", st.latency_sum / st.ticks, " max ", st.latency_max);
+		reply.add(" | work us: avg ", st.work_sum / st.ticks, " max ", st.work_max);
+	}
+	if(st.ticks > 1) {
+		reply.add(" | interval us: ", st.interval_min, " - ", st.interval_max);
+	}
+}
+
+// heap use, appended to reply: what's allocated now, and the most the heap has ever been grown to.
+// newlib only gives memory back to sbrk() once 128K at the top of the heap are free, more than the
+// Teensy has to spare, so arena never goes down - it's the high-water mark
+void heapStats(void) {
+	struct mallinfo mi = mallinfo();
+	reply.add(mi.uordblks, " B in use, ", mi.arena, " B high-water");
 }
 
-void logTelemetry(void) {
-	// USBSerialLink syntax: ~~field~type_hint~data
-	msg = String("~~data_pressure~d~") + sensor_data.water_pressure; Serial.println(msg);
+void logTick(void) {
+	reply.add("INFO tick: ");
+	tickStats();
+	reply.add(" | heap: ");
+	heapStats();
+	reply.send();
 }
 
 //		#       ###   #   #   ####          ####  #####  #   #  #####  #####
@@ -869,60 +1269,38 @@ void logTelemetry(void) {
 //		#####   ###   #   #   ####         ####     #     ###   #      #
 
 #ifdef IMU_MPU9250
+// read every tick whether or not there's a new sample, the filter steps once a tick at a fixed time step. The
+// sensor's sample rate is set to 200 Hz in initMPU9250(), the tick's default
 void readMPU9250(void) {
-	if(mpu9250.readByte(MPU9250_ADDRESS, INT_STATUS) & 0x01) {
-		mpu9250.readAccelData(mpu9250.accelCount);
-		mpu9250.getAres();
-
-		mpu9250.ax = (float)mpu9250.accelCount[0]*mpu9250.aRes;
-		mpu9250.ay = (float)mpu9250.accelCount[1]*mpu9250.aRes;
-		mpu9250.az = (float)mpu9250.accelCount[2]*mpu9250.aRes;
-
-		mpu9250.readGyroData(mpu9250.gyroCount);
-		mpu9250.getGres();
-
-		mpu9250.gx = (float)mpu9250.gyroCount[0]*mpu9250.aRes;
-		mpu9250.gy = (float)mpu9250.gyroCount[1]*mpu9250.aRes;
-		mpu9250.gz = (float)mpu9250.gyroCount[2]*mpu9250.aRes;
-
-		mpu9250.readMagData(mpu9250.magCount);
-		mpu9250.getMres();
-
-		// correction in milliGuasss, should be calculated
-		mpu9250.magbias[0] = +470;
-		mpu9250.magbias[1] = +120;
-		mpu9250.magbias[2] = +125;
-
-		mpu9250.mx = (float)mpu9250.magCount[0] * mpu9250.mRes * mpu9250.magCalibration[0] - mpu9250.magbias[0];
-		mpu9250.my = (float)mpu9250.magCount[1] * mpu9250.mRes * mpu9250.magCalibration[1] - mpu9250.magbias[1];
-		mpu9250.mz = (float)mpu9250.magCount[2] * mpu9250.mRes * mpu9250.magCalibration[2] - mpu9250.magbias[2];
-
-		mpu9250.updateTime();
-
-		MahonyQuaternionUpdate(mpu9250.ax, mpu9250.ay, mpu9250.az,
-			mpu9250.gx * DEG_TO_RAD, mpu9250.gy * DEG_TO_RAD, mpu9250.gz * DEG_TO_RAD,
-			//mpu9250.my, mpu9250.mx, mpu9250.mz,
-			mpu9250.my, mpu9250.mx, mpu9250.mz,
-			mpu9250.deltat);
-
-		mpu9250.yaw   = atan2(2.0f * (*(getQ()+1) * *(getQ()+2) + *getQ()
-                    * *(getQ()+3)), *getQ() * *getQ() + *(getQ()+1)
-                    * *(getQ()+1) - *(getQ()+2) * *(getQ()+2) - *(getQ()+3)
-                    * *(getQ()+3));
-		mpu9250.yaw   *= RAD_TO_DEG;
-
-		mpu9250.pitch = -asin(2.0f * (*(getQ()+1) * *(getQ()+3) - *getQ()
-		            * *(getQ()+2)));
-		mpu9250.pitch *= RAD_TO_DEG;
-
-		mpu9250.roll  = atan2(2.0f * (*getQ() * *(getQ()+1) + *(getQ()+2)
-		            * *(getQ()+3)), *getQ() * *getQ() - *(getQ()+1)
-		            * *(getQ()+1) - *(getQ()+2) * *(getQ()+2) + *(getQ()+3)
-		            * *(getQ()+3));
-		mpu9250.roll *= RAD_TO_DEG;
-
-		// calculate declination of location using http://www.ngdc.noaa.gov/geomag-web/#declination
-		mpu9250.yaw  -= 11.5; // TRANSDEC, San Diego
-	}
+	mpu9250.readAccelData(mpu9250.accelCount);
+	mpu9250.getAres();
+
+	mpu9250.ax = (float)mpu9250.accelCount[0]*mpu9250.aRes;
+	mpu9250.ay = (float)mpu9250.accelCount[1]*mpu9250.aRes;
+	mpu9250.az = (float)mpu9250.accelCount[2]*mpu9250.aRes;
+
+	mpu9250.readGyroData(mpu9250.gyroCount);
+	mpu9250.getGres();
+
+	mpu9250.gx = (float)mpu9250.gyroCount[0]*mpu9250.gRes;
+	mpu9250.gy = (float)mpu9250.gyroCount[1]*mpu9250.gRes;
+	mpu9250.gz = (float)mpu9250.gyroCount[2]*mpu9250.gRes;
+
+	mpu9250.readMagData(mpu9250.magCount); // leaves the last reading when the AK8963 has nothing new
+	mpu9250.getMres();
+
+	// correction in milliGuasss, should be calculated
+	mpu9250.magbias[0] = +470;
+	mpu9250.magbias[1] = +120;
+	mpu9250.magbias[2] = +125;
+
+	mpu9250.mx = (float)mpu9250.magCount[0] * mpu9250.mRes * mpu9250.magCalibration[0] - mpu9250.magbias[0];
+	mpu9250.my = (float)mpu9250.magCount[1] * mpu9250.mRes * mpu9250.magCalibration[1] - mpu9250.magbias[1];
+	mpu9250.mz = (float)mpu9250.magCount[2] * mpu9250.mRes * mpu9250.magCalibration[2] - mpu9250.magbias[2];
+
+	// the magnetometer's x and y are swapped relative to the accelerometer and gyro
+	fusion.update(mpu9250.gx, mpu9250.gy, mpu9250.gz,
+		mpu9250.ax, mpu9250.ay, mpu9250.az,
+		mpu9250.my, mpu9250.mx, mpu9250.mz);
 }
 #endif
@@ -0,0 +1,65 @@
+#ifndef ANGLE_ERROR_H
+#define ANGLE_ERROR_H
+
+#include <math.h>
+
+// the attitude controllers are fed target - measured, which for an angle has to be the short way round: a target
+// of 170 with the sub at -170 is 20 degrees to the left, not 340 to the right. How much work that takes depends on
+// how the IMU reports the angle, so each convention is its own type and the sketch picks one per axis with the IMU
+// - the control tick doesn't check which IMU it has
+//
+//	typedef angle::Axis<angle::Unsigned> YawAngle; // BNO055 heading
+//	pid_target[axis::Yaw] = YawAngle::wrap(350 + 20);  // 10
+//	pid[axis::Yaw].setInput(YawAngle::error(pid_target[axis::Yaw], heading));
+//
+// error() is in degrees, -180 up to but not including 180
+
+namespace angle {
+	enum Convention {
+		Unsigned,  // 0 to 360, the BNO055's heading
+		Signed,    // -180 to 180, from atan2() - Fusion's yaw and roll, the BNO055's pitch and roll
+		Continuous // carries on past a turn, the MPU6050's yaw counts them
+	};
+
+	// any angle into [lo, lo + 360). fmodf() is exact, the checks are for the sums either side of it rounding
+	// onto the end of the range
+	inline float wrap(float a, float lo) {
+		float d = fmodf(a - lo, 360);
+		if(d < 0) d += 360;
+		if(d >= 360) d = 0;
+		return lo + d;
+	}
+
+	// a difference less than a turn and a half either way brought round to [-180, 180) - a compare and an add,
+	// no divide
+	inline float shortcut(float d) {
+		return d >= 180 ? d - 360 : (d < -180 ? d + 360 : d);
+	}
+
+	// wrap() brings a commanded angle into the convention, error() is the shortest turn from measured to target
+	template<Convention C> struct Axis;
+
+	// a target and a measurement in the same turn are less than a turn apart, so the error is one shortcut().
+	// The targets have to go through wrap() for that, when they're set rather than every tick
+	template<> struct Axis<Unsigned> {
+		static float wrap(float a) { return angle::wrap(a, 0); }
+		static float error(float target, float measured) { return shortcut(target - measured); }
+	};
+
+	template<> struct Axis<Signed> {
+		static float wrap(float a) { return angle::wrap(a, -180); }
+		static float error(float target, float measured) { return shortcut(target - measured); }
+	};
+
+	// the measurement can be any number of turns from the target. Most ticks it's within a turn and a half, the
+	// rest take the full wrap(). Targets are left alone, one turn is as good as another
+	template<> struct Axis<Continuous> {
+		static float wrap(float a) { return a; }
+		static float error(float target, float measured) {
+			float d = target - measured;
+			return fabsf(d) < 540 ? shortcut(d) : angle::wrap(d, -180);
+		}
+	};
+}
+
+#endif
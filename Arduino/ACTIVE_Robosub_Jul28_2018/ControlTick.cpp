@@ -0,0 +1,82 @@
+#include "ControlTick.h"
+
+const uint16_t ControlTick::MIN_HZ = 10;
+const uint16_t ControlTick::MAX_HZ = 1000;
+
+volatile uint32_t ControlTick::fired = 0;
+volatile uint32_t ControlTick::fired_us = 0;
+
+ControlTick::ControlTick() : rate_hz(0), period_us(0), taken(0), start_us(0), prev_start_us(0), have_prev(false) {
+  takeStats();
+}
+
+void ControlTick::isr() {
+  fired_us = micros();
+  fired = fired + 1;
+}
+
+bool ControlTick::begin(uint16_t hz) {
+  if(hz < MIN_HZ || hz > MAX_HZ) return false;
+
+  timer.end();
+  rate_hz = hz;
+  period_us = 1000000UL / hz;
+
+  noInterrupts();
+  taken = fired; // nothing waiting from before the restart
+  interrupts();
+  have_prev = false;
+  takeStats();
+
+  return timer.begin(isr, period_us);
+}
+
+void ControlTick::end() {
+  timer.end();
+  rate_hz = 0;
+}
+
+bool ControlTick::due() {
+  // both written by the interrupt, read them together
+  noInterrupts();
+  uint32_t count = fired;
+  uint32_t at = fired_us;
+  interrupts();
+
+  if(count == taken) return false;
+
+  stats.missed += count - taken - 1;
+  taken = count;
+
+  start_us = micros();
+  uint32_t latency = start_us - at;
+  stats.latency_sum += latency;
+  if(latency > stats.latency_max) stats.latency_max = latency;
+
+  if(have_prev) {
+    uint32_t interval = start_us - prev_start_us;
+    if(interval < stats.interval_min) stats.interval_min = interval;
+    if(interval > stats.interval_max) stats.interval_max = interval;
+  }
+  prev_start_us = start_us;
+  have_prev = true;
+
+  return true;
+}
+
+void ControlTick::done() {
+  uint32_t work = micros() - start_us;
+  stats.work_sum += work;
+  if(work > stats.work_max) stats.work_max = work;
+  ++stats.ticks;
+}
+
+ControlTick::Stats ControlTick::takeStats() {
+  Stats out = stats;
+  stats.ticks = stats.missed = 0;
+  stats.latency_max = stats.latency_sum = 0;
+  stats.interval_min = 0xFFFFFFFF;
+  stats.interval_max = 0;
+  stats.work_max = stats.work_sum = 0;
+  return out;
+}
@@ -0,0 +1,65 @@
+#ifndef CONTROL_TICK_H
+#define CONTROL_TICK_H
+
+#include <Arduino.h>
+#include <IntervalTimer.h>
+
+// fixed rate tick for the control loop, off one of the Teensy's PIT timers
+//
+// the interrupt only timestamps the tick - loop() runs the tick's work as soon as due()
+// says one is waiting, so the control code and the interpreter never run on top of each
+// other and nothing they share needs guarding. How late the work starts is bounded by the
+// longest piece of background work, and measured:
+//   latency  ~ us from the interrupt to due() picking it up
+//   interval ~ us between the starts of two ticks, the period when there is no jitter
+//   work     ~ us from due() to done()
+// only one ControlTick can be running, it owns the interrupt
+class ControlTick {
+public:
+  struct Stats {
+    uint32_t ticks;  // run since the last takeStats()
+    uint32_t missed; // fired while the one before was still waiting, those are dropped
+    uint32_t latency_max, latency_sum;
+    uint32_t interval_min, interval_max;
+    uint32_t work_max, work_sum;
+  };
+
+  ControlTick();
+
+  // (re)starts the timer, false if the rate is out of MIN_HZ - MAX_HZ
+  bool begin(uint16_t hz);
+  void end(void);
+
+  // true once per tick, call as often as possible from loop() and run the tick's work when it is
+  bool due(void);
+  // call when the tick's work is finished
+  void done(void);
+
+  uint16_t getRate(void) { return rate_hz; }
+  uint32_t getPeriodMicros(void) { return period_us; }
+
+  // stats since the last call, and start over
+  Stats takeStats(void);
+
+  const static uint16_t MIN_HZ;
+  const static uint16_t MAX_HZ;
+
+private:
+  static void isr(void);
+
+  // written by the interrupt
+  static volatile uint32_t fired;    // interrupts since begin()
+  static volatile uint32_t fired_us; // micros() at the last one
+
+  IntervalTimer timer;
+  uint16_t rate_hz;
+  uint32_t period_us;
+
+  uint32_t taken; // value of fired at the last tick run
+  uint32_t start_us, prev_start_us;
+  bool have_prev;
+
+  Stats stats;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+// signed Q-format number in 32 bits with FRAC fractional bits, ie Fixed<16> is Q15.16:
+// +-32767 with a resolution of 1/65536. Add and subtract are plain integer ops, multiply
+// goes through 64 bits (a single SMULL on the Cortex-M4) and rounds to nearest.
+// Nothing saturates - keep values inside the range, the PID clamps its sums for that.
+template<uint8_t FRAC>
+class Fixed {
+public:
+	static const int32_t ONE = (int32_t)1 << FRAC;
+
+	Fixed() : raw(0) {}
+	Fixed(float f) : raw((int32_t)(f * ONE + (f >= 0 ? 0.5f : -0.5f))) {}
+	Fixed(int i) : raw((int32_t)i << FRAC) {}
+
+	static Fixed fromRaw(int32_t r) { Fixed f; f.raw = r; return f; }
+	int32_t getRaw() const { return raw; }
+	float toFloat() const { return (float)raw / ONE; }
+
+	Fixed operator+(Fixed o) const { return fromRaw(raw + o.raw); }
+	Fixed operator-(Fixed o) const { return fromRaw(raw - o.raw); }
+	Fixed operator-() const { return fromRaw(-raw); }
+	Fixed operator*(Fixed o) const {
+		return fromRaw((int32_t)(((int64_t)raw * o.raw + (ONE >> 1)) >> FRAC));
+	}
+	Fixed& operator+=(Fixed o) { raw += o.raw; return *this; }
+	Fixed& operator-=(Fixed o) { raw -= o.raw; return *this; }
+	Fixed& operator*=(Fixed o) { return *this = *this * o; }
+
+	bool operator<(Fixed o) const { return raw < o.raw; }
+	bool operator>(Fixed o) const { return raw > o.raw; }
+	bool operator<=(Fixed o) const { return raw <= o.raw; }
+	bool operator>=(Fixed o) const { return raw >= o.raw; }
+	bool operator==(Fixed o) const { return raw == o.raw; }
+	bool operator!=(Fixed o) const { return raw != o.raw; }
+
+private:
+	int32_t raw;
+};
+
+typedef Fixed<16> q16;
+
+// so code templated on the number type can get a float back out of either
+inline float toFloat(float f) { return f; }
+template<uint8_t FRAC>
+inline float toFloat(Fixed<FRAC> f) { return f.toFloat(); }
+
+#endif
@@ -0,0 +1,161 @@
+#include "Fusion.h"
+
+#include <string.h>
+
+Fusion::Fusion() : kp(1), ki(0), updates(0) {
+  setPeriodMicros(5000);
+  reset();
+}
+
+void Fusion::setPeriodMicros(uint32_t us) {
+  period_us = us;
+  dt = us * 1e-6f;
+  half_dt = 0.5f * dt;
+}
+
+void Fusion::setGains(float _kp, float _ki) {
+  kp = _kp;
+  ki = _ki;
+  if(ki == 0) integral[0] = integral[1] = integral[2] = 0;
+}
+
+void Fusion::reset() {
+  q[0] = 1;
+  q[1] = q[2] = q[3] = 0;
+  integral[0] = integral[1] = integral[2] = 0;
+  started = false;
+}
+
+void Fusion::update(float gx, float gy, float gz, float ax, float ay, float az) {
+  float n = ax * ax + ay * ay + az * az;
+  if(n == 0) { // free fall or no reading, the gyro alone this time
+    step(gx, gy, gz, 0, 0, 0);
+    return;
+  }
+  if(!started) start(ax, ay, az, 0, 0, 0);
+
+  n = invSqrt(n);
+  ax *= n; ay *= n; az *= n;
+
+  // gravity as the current attitude expects to see it, the error is how far that is from what was measured
+  float vx = 2 * (q[1] * q[3] - q[0] * q[2]);
+  float vy = 2 * (q[0] * q[1] + q[2] * q[3]);
+  float vz = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+  step(gx, gy, gz, ay * vz - az * vy, az * vx - ax * vz, ax * vy - ay * vx);
+}
+
+void Fusion::update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz) {
+  float na = ax * ax + ay * ay + az * az;
+  float nm = mx * mx + my * my + mz * mz;
+  if(na == 0 || nm == 0) { // without both, as much as the accelerometer can do alone
+    update(gx, gy, gz, ax, ay, az);
+    return;
+  }
+  if(!started) start(ax, ay, az, mx, my, mz);
+
+  na = invSqrt(na);
+  ax *= na; ay *= na; az *= na;
+  nm = invSqrt(nm);
+  mx *= nm; my *= nm; mz *= nm;
+
+  float q0q0 = q[0] * q[0], q0q1 = q[0] * q[1], q0q2 = q[0] * q[2], q0q3 = q[0] * q[3];
+  float q1q1 = q[1] * q[1], q1q2 = q[1] * q[2], q1q3 = q[1] * q[3];
+  float q2q2 = q[2] * q[2], q2q3 = q[2] * q[3];
+  float q3q3 = q[3] * q[3];
+
+  // the earth's field turned into the earth frame, flattened onto north (bx) and down (bz) so the
+  // magnetometer only ever corrects heading
+  float hx = 2 * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+  float hy = 2 * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+  float h2 = hx * hx + hy * hy;
+  float bx = h2 * invSqrt(h2);
+  float bz = 2 * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+
+  // gravity and the field as the current attitude expects to see them
+  float vx = 2 * (q1q3 - q0q2);
+  float vy = 2 * (q0q1 + q2q3);
+  float vz = q0q0 - q1q1 - q2q2 + q3q3;
+  float wx = 2 * (bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2));
+  float wy = 2 * (bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3));
+  float wz = 2 * (bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2));
+
+  step(gx, gy, gz,
+    (ay * vz - az * vy) + (my * wz - mz * wy),
+    (az * vx - ax * vz) + (mz * wx - mx * wz),
+    (ax * vy - ay * vx) + (mx * wy - my * wx));
+}
+
+void Fusion::getEuler(float& yaw, float& pitch, float& roll) {
+  float q0q0 = q[0] * q[0], q1q1 = q[1] * q[1], q2q2 = q[2] * q[2], q3q3 = q[3] * q[3];
+  // atan2() doesn't mind the quaternion's length being off by invSqrt()'s error, asin() does
+  float s = 2 * (q[1] * q[3] - q[0] * q[2]) / (q0q0 + q1q1 + q2q2 + q3q3);
+  s = s > 1 ? 1 : (s < -1 ? -1 : s); // a hair past 1 at +-90 pitch makes asin() NaN
+  yaw = atan2f(2 * (q[1] * q[2] + q[0] * q[3]), q0q0 + q1q1 - q2q2 - q3q3) * (float)RAD_TO_DEG;
+  pitch = -asinf(s) * (float)RAD_TO_DEG;
+  roll = atan2f(2 * (q[0] * q[1] + q[2] * q[3]), q0q0 - q1q1 - q2q2 + q3q3) * (float)RAD_TO_DEG;
+}
+
+float Fusion::invSqrt(float x) {
+  // the float's bits read as an integer are close to its log2, halving and negating that is the first guess,
+  // then one Newton step. The constants are Moroz et al.'s, which keep the error under 0.07% either side where
+  // the usual 0x5F3759DF is up to 0.18% low every time. memcpy rather than a cast through a pointer, gcc
+  // turns it into a register move either way
+  uint32_t i;
+  float y;
+  memcpy(&i, &x, sizeof(i));
+  i = 0x5F1FFFF9 - (i >> 1);
+  memcpy(&y, &i, sizeof(y));
+  return 0.703952253f * y * (2.38924456f - x * y * y);
+}
+
+// roll and pitch from gravity, and yaw from the field levelled by them when there's a magnetometer - rather than
+// spending the first seconds swinging over from level and north
+void Fusion::start(float ax, float ay, float az, float mx, float my, float mz) {
+  float roll = atan2f(ay, az);
+  float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+  float yaw = 0;
+  if(mx != 0 || my != 0 || mz != 0) {
+    float north = mx * cosf(pitch) + (my * sinf(roll) + mz * cosf(roll)) * sinf(pitch);
+    float east = my * cosf(roll) - mz * sinf(roll);
+    yaw = atan2f(-east, north);
+  }
+  float cr = cosf(0.5f * roll), sr = sinf(0.5f * roll);
+  float cp = cosf(0.5f * pitch), sp = sinf(0.5f * pitch);
+  float cy = cosf(0.5f * yaw), sy = sinf(0.5f * yaw);
+  q[0] = cr * cp * cy + sr * sp * sy;
+  q[1] = sr * cp * cy - cr * sp * sy;
+  q[2] = cr * sp * cy + sr * cp * sy;
+  q[3] = cr * cp * sy - sr * sp * cy;
+  started = true;
+}
+
+// gyro in degrees/s, corrected by the error (unit vectors crossed, so about radians) and integrated over one tick
+void Fusion::step(float gx, float gy, float gz, float ex, float ey, float ez) {
+  gx *= (float)DEG_TO_RAD;
+  gy *= (float)DEG_TO_RAD;
+  gz *= (float)DEG_TO_RAD;
+  if(ki > 0) {
+    integral[0] += ki * ex * dt;
+    integral[1] += ki * ey * dt;
+    integral[2] += ki * ez * dt;
+    gx += integral[0];
+    gy += integral[1];
+    gz += integral[2];
+  }
+  gx = (gx + kp * ex) * half_dt;
+  gy = (gy + kp * ey) * half_dt;
+  gz = (gz + kp * ez) * half_dt;
+
+  float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  q0 += -q1 * gx - q2 * gy - q3 * gz;
+  q1 += q[0] * gx + q2 * gz - q3 * gy;
+  q2 += q[0] * gy - q[1] * gz + q3 * gx;
+  q3 += q[0] * gz + q[1] * gy - q[2] * gx;
+
+  float n = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  q[0] = q0 * n;
+  q[1] = q1 * n;
+  q[2] = q2 * n;
+  q[3] = q3 * n;
+  ++updates;
+}
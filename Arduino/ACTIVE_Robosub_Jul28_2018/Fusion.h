@@ -0,0 +1,54 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <Arduino.h>
+
+// attitude from a gyro and accelerometer, and a magnetometer when there is one, with a Mahony filter (the same
+// one quaternionFilters.h has). It is stepped once per control tick, so the time step is fixed and set with the
+// tick rate rather than measured every update. update() is only the filter, a quaternion and some multiplies -
+// the trig to get Euler angles is left to getEuler(), for whoever needs them
+//
+// everything is in the sensor's frame, x y z right handed: gyro in degrees/s, accel and mag in any unit (only
+// their direction is used). Euler angles are in degrees, z-y-x order - yaw about z and roll about x are +-180,
+// pitch about y is +-90
+class Fusion {
+public:
+  Fusion();
+
+  void setPeriodMicros(uint32_t us);
+  uint32_t getPeriodMicros(void) { return period_us; }
+  // kp pulls the gyro towards the accelerometer (and mag), 1/kp is about the time constant in seconds. ki
+  // learns the gyro bias, 0 to leave it to the gyro calibration
+  void setGains(float _kp, float _ki);
+  float getKp(void) { return kp; }
+  float getKi(void) { return ki; }
+
+  // the next update starts over from the accelerometer (and mag)
+  void reset(void);
+
+  void update(float gx, float gy, float gz, float ax, float ay, float az);
+  void update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz);
+
+  // unit quaternion w x y z, sensor frame to earth frame
+  const float* getQuaternion(void) { return q; }
+  void getEuler(float& yaw, float& pitch, float& roll);
+  // +1 every update, so a caller can tell when the Euler angles it has are stale
+  uint32_t getUpdates(void) { return updates; }
+
+  // 1 / sqrt(x) to within 0.07%, the bit trick with one Newton step - no divide and no square root
+  static float invSqrt(float x);
+
+private:
+  void start(float ax, float ay, float az, float mx, float my, float mz);
+  void step(float gx, float gy, float gz, float ex, float ey, float ez);
+
+  float q[4];
+  float integral[3];
+  float kp, ki;
+  float dt, half_dt;
+  uint32_t period_us;
+  uint32_t updates;
+  bool started;
+};
+
+#endif
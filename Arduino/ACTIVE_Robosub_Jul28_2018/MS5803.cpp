@@ -3,8 +3,9 @@
 const uint8_t MS5803::OSR_flags[] = {
   0x00, 0x02, 0x04, 0x06, 0x08
 };
-const uint8_t MS5803::OSR_delays[] = {
-  1, 2, 3, 5, 10
+// maximum conversion times from the datasheet
+const uint16_t MS5803::OSR_conversion_us[] = {
+  600, 1170, 2280, 4540, 9040
 };
 
 MS5803::MS5803(uint16_t _addr, uint8_t _model = 5) {
@@ -45,41 +46,77 @@ void MS5803::begin() {
   Serial.println();
 }
 
-// one is inclined to take the simplicity of this for granted
-// that is, if they're not writing the library... XD
-void MS5803::update(uint8_t osr) {
-  // credit to Luke Miller for the neurotic casting to prevent rollover
-  
-  // begin uncompensated pressure conversion
-  Wire.beginTransmission(addr);
-  Wire.write(MS5803_D1 | OSR_flags[osr]);
-  Wire.endTransmission();
-  // wait for conversion to complete
-  delay(OSR_delays[osr]);
-  // call ADC read
-  Wire.beginTransmission(addr);
-  Wire.write(MS5803_ADC_READ);
-  Wire.endTransmission();
-  // read 24 bits
-  Wire.requestFrom(addr, 3);
-  if(Wire.available() == 3) { for(uint8_t i = 0; i < 3; i++) data[i] = Wire.read(); }
-  // pack bits into 32-bit int
-  D1 = (data[0] * 65536) + (data[1] * 256) + data[2];
+// conversion command -> (wait) -> ADC read, for D1 and then D2, one step per call
+bool MS5803::update(uint8_t osr) {
+  uint32_t now = micros();
+
+  switch(state) {
+    case State::Idle:
+      conversion_osr = osr;
+      if(startConversion(MS5803_D1)) state = State::ConvertingD1;
+      return false;
+
+    case State::ConvertingD1:
+      if(now - conversion_start < OSR_conversion_us[conversion_osr]) return false;
+      if(!readADC(D1) || !startConversion(MS5803_D2)) {
+        state = State::Idle; // start over on the next pass
+        return false;
+      }
+      state = State::ConvertingD2;
+      return false;
+
+    case State::ConvertingD2:
+    {
+      if(now - conversion_start < OSR_conversion_us[conversion_osr]) return false;
+      bool ok = readADC(D2);
+
+      // keep the sensor busy, the next sample is converting while this one is used
+      conversion_osr = osr;
+      state = (startConversion(MS5803_D1) ? State::ConvertingD1 : State::Idle);
+
+      if(!ok) return false;
+      compute();
+      ++sample_count;
+      return true;
+    }
+  }
+  return false;
+}
+
+MS5803::State MS5803::getState() {
+  return state;
+}
 
-  // begin uncompensated temperature conversion
+uint32_t MS5803::getSampleCount() {
+  return sample_count;
+}
+
+bool MS5803::startConversion(uint8_t cmd) {
   Wire.beginTransmission(addr);
-  Wire.write(MS5803_D2 | OSR_flags[osr]);
-  Wire.endTransmission();
-  delay(OSR_delays[osr]);
-  // call ADC read
+  Wire.write(cmd | OSR_flags[conversion_osr]);
+  if(Wire.endTransmission() != 0) return false;
+  conversion_start = micros();
+  return true;
+}
+
+// a conversion read before it is done (or never started) comes back as 0
+bool MS5803::readADC(uint32_t& value) {
   Wire.beginTransmission(addr);
   Wire.write(MS5803_ADC_READ);
-  Wire.endTransmission();
+  if(Wire.endTransmission() != 0) return false;
   // read 24 bits
   Wire.requestFrom(addr, 3);
-  if(Wire.available() == 3) { for(uint8_t i = 0; i < 3; i++) data[i] = Wire.read(); }
+  if(Wire.available() != 3) return false;
+  for(uint8_t i = 0; i < 3; i++) data[i] = Wire.read();
   // pack bits into 32-bit int
-  D2 = (data[0] * 65536) + (data[1] * 256) + data[2];
+  value = (data[0] * 65536) + (data[1] * 256) + data[2];
+  return value != 0;
+}
+
+// one is inclined to take the simplicity of this for granted
+// that is, if they're not writing the library... XD
+void MS5803::compute() {
+  // credit to Luke Miller for the neurotic casting to prevent rollover
 
   // calculate temperature
   dT = (int32_t)D2 - ((int32_t)coeffs[MS5803_COEF_TREF] * 256); // 2^8
@@ -24,11 +24,11 @@
 // oversampling setup data indexes (note the array below)
 // allows OSR to be changed during runtime
 // also notes max conversion times for a given OSR
-#define MS5803_OSR_256  (0) // 1 ms
-#define MS5803_OSR_512  (1) // 2 ms
-#define MS5803_OSR_1024 (2) // 3 ms
-#define MS5803_OSR_2048 (3) // 5 ms
-#define MS5803_OSR_4096 (4) // 10 ms
+#define MS5803_OSR_256  (0) // 0.60 ms
+#define MS5803_OSR_512  (1) // 1.17 ms
+#define MS5803_OSR_1024 (2) // 2.28 ms
+#define MS5803_OSR_2048 (3) // 4.54 ms
+#define MS5803_OSR_4096 (4) // 9.04 ms
 
 // reset ADC
 #define MS5803_RESET (0x1E)
@@ -39,12 +39,26 @@
 
 #define MS5803_ADC_READ (0x00)
 
+// update() never waits for the sensor. A sample takes two conversions (D1 = pressure,
+// D2 = temperature) and each pass does whatever is due:
+//   Idle          -> start D1
+//   ConvertingD1  -> once the conversion time is up, read D1 and start D2
+//   ConvertingD2  -> once the conversion time is up, read D2, compute, start the next D1
+// so the sensor is always converting and a fresh sample is ready every two conversion
+// times, as long as update() is called at least that often. update() returns true on the
+// pass that produced a new sample.
 class MS5803 {
 public:
+  enum class State : uint8_t {
+    Idle, ConvertingD1, ConvertingD2
+  };
+
   MS5803(uint16_t, uint8_t);
 
   void begin();
-  void update(uint8_t);
+  bool update(uint8_t);
+  State getState();
+  uint32_t getSampleCount(); // samples computed since boot
   float getPressure();
   int32_t getPressureI();
   float getTemperature();
@@ -52,7 +66,16 @@ public:
   
 private:
   const static uint8_t OSR_flags[];
-  const static uint8_t OSR_delays[];
+  const static uint16_t OSR_conversion_us[];
+
+  bool startConversion(uint8_t cmd);
+  bool readADC(uint32_t& value);
+  void compute();
+
+  State state = State::Idle;
+  uint8_t conversion_osr = 0;
+  uint32_t conversion_start = 0; // micros()
+  uint32_t sample_count = 0;
 
   uint8_t model;
   uint16_t addr;
@@ -0,0 +1,55 @@
+#include "Mixer.h"
+
+const uint8_t Mixer::GROUP_END[Mixer::GROUPS] = { dof::Pitch, dof::Surge, dof::Count };
+const char* const Mixer::GROUP_NAMES[Mixer::GROUPS] = { "depth", "attitude", "surge" };
+
+Mixer::Mixer(float _limit, const float (&matrix)[thr::Count][dof::Count], Mode _mode) : limit(_limit), mode(_mode) {
+  for(uint8_t t = 0; t < thr::Count; ++t) setRow(t, matrix[t]);
+  for(uint8_t g = 0; g < GROUPS; ++g) scale[g] = 1;
+}
+
+void Mixer::setRow(uint8_t thruster, const float (&row)[dof::Count]) {
+  for(uint8_t d = 0; d < dof::Count; ++d) m[thruster][d] = row[d];
+}
+
+void Mixer::mix(const float (&demand)[dof::Count], float (&power)[thr::Count]) {
+  if(mode == Clip) {
+    for(uint8_t t = 0; t < thr::Count; ++t) {
+      float sum = 0;
+      for(uint8_t d = 0; d < dof::Count; ++d) sum += m[t][d] * demand[d];
+      power[t] = constrain(sum, -limit, limit);
+    }
+    for(uint8_t g = 0; g < GROUPS; ++g) scale[g] = 1;
+    return;
+  }
+
+  for(uint8_t t = 0; t < thr::Count; ++t) power[t] = 0;
+
+  uint8_t first = 0;
+  for(uint8_t g = 0; g < GROUPS; ++g) {
+    // this group's part of matrix * demand
+    float part[thr::Count];
+    for(uint8_t t = 0; t < thr::Count; ++t) {
+      float sum = 0;
+      for(uint8_t d = first; d < GROUP_END[g]; ++d) sum += m[t][d] * demand[d];
+      part[t] = sum;
+    }
+    first = GROUP_END[g];
+
+    // the most of it that keeps every thruster within the limit, given what's already there
+    float s = 1;
+    for(uint8_t t = 0; t < thr::Count; ++t) {
+      float fit = s;
+      if(part[t] > 0) fit = (limit - power[t]) / part[t];
+      else if(part[t] < 0) fit = (-limit - power[t]) / part[t];
+      if(fit < s) s = fit;
+    }
+    if(s < 0) s = 0;
+
+    for(uint8_t t = 0; t < thr::Count; ++t) power[t] += s * part[t];
+    scale[g] = s;
+  }
+
+  // rounding can leave a hair over
+  for(uint8_t t = 0; t < thr::Count; ++t) power[t] = constrain(power[t], -limit, limit);
+}
@@ -0,0 +1,49 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <Arduino.h>
+
+#include "control_ids.h"
+
+// turns a demand per degree of freedom (dof::Id) into a power per thruster (thr::Id) through a
+// mixing matrix, power = matrix * demand, keeping every power within +-limit
+//
+// how it gets there when the thrusters can't do everything asked of them is the mode:
+//   Clip     ~ mixes everything and clips each thruster, so whatever saturates first loses out -
+//              with a high thrust_base that's the yaw correction on the side thrusters
+//   Priority ~ mixes one group at a time, depth then attitude then surge, and scales a group's
+//              demand down to what still fits once the groups before it are in. Depth always gets
+//              what it asks for, and surge gives way to keep the heading
+class Mixer {
+public:
+  enum Mode {
+    Clip, Priority
+  };
+
+  // the priority groups, as ranges of dof ids
+  const static uint8_t GROUPS = 3;
+  const static uint8_t GROUP_END[GROUPS]; // one past the last dof of each group
+  const static char* const GROUP_NAMES[GROUPS];
+
+  // matrix[thruster][dof]
+  Mixer(float _limit, const float (&matrix)[thr::Count][dof::Count], Mode _mode = Priority);
+
+  void mix(const float (&demand)[dof::Count], float (&power)[thr::Count]);
+
+  void setRow(uint8_t thruster, const float (&row)[dof::Count]);
+  float getEntry(uint8_t thruster, uint8_t d) { return m[thruster][d]; }
+
+  void setMode(Mode _mode) { mode = _mode; }
+  Mode getMode(void) { return mode; }
+
+  // fraction of each group's demand the last mix() passed on, 1 unless it had to be scaled down
+  float getScale(uint8_t group) { return scale[group]; }
+
+private:
+  float m[thr::Count][dof::Count];
+  float limit;
+  Mode mode;
+  float scale[GROUPS];
+};
+
+#endif
@@ -13,19 +13,29 @@ public:
 	NBDelayCallback() : NBDelayCallback(500, NULL) {}
 
 	void touch(bool force_reset = false) {
-		if(isComplete() || force_reset) {
-			start = millis();
+		touch(millis(), force_reset);
+	}
+	void touch(unsigned long now, bool force_reset = false) {
+		if(isComplete(now) || force_reset) {
+			start = now;
 		}
 	}
 
 	bool isComplete() {
-		return ( millis() > start + length ); // if (now) is later than (start + length)
+		return isComplete(millis());
+	}
+	bool isComplete(unsigned long now) {
+		return ( now - start > length ); // if (now) is later than (start + length), safe across millis() rollover
 	}
 
 	void update() {
-		if(enabled && isComplete()) {
+		update(millis());
+	}
+	// when servicing several delays, read millis() once and pass it to each
+	void update(unsigned long now) {
+		if(enabled && isComplete(now)) {
 			if(callback) callback();
-			touch();
+			touch(now);
 		}
 	}
 
@@ -0,0 +1,258 @@
+#ifndef PID_CORE_H
+#define PID_CORE_H
+
+#include <stdint.h>
+
+#include "FixedPoint.h"
+
+/*
+The PID_v1_strang algorithm (same terms, same anti-windup, same Reverse/POnMeasure
+options) without its costs on the Teensy 3.5:
+	- the number type is a template parameter, float or a Fixed<> Q-format type. The
+	  M4's FPU is single precision only, every double op in PID_v1_strang is a library call
+	- time is passed in, so one millis() read at the top of the loop serves every controller,
+	  or the caller runs them off its own fixed rate timer with step()
+	- PIDBank<T, N> keeps N controllers that share a period as arrays of each term and
+	  steps them all in one pass, instead of N objects each checking the clock
+
+	PIDBank<float, 4> pid(50, PIDBase::Reverse, { { -50, 50 }, { -80, 80 }, ... });
+	pid[0].setTunings(2, 0.1, 0.5);
+	pid[0].setMode(PIDBase::Automatic);
+	pid[0].setInput(error);
+	pid.compute(millis());
+	float out = pid[0].getOutput();
+
+PIDCore<T> is a single controller with the PID_v1_strang interface, for use outside a bank.
+*/
+
+struct PIDBase {
+	enum Mode {
+		Manual, Automatic
+	};
+	// action mode of controller: Direct increases output when error is positive, Reverse decreases it
+	enum Direction {
+		Direct, Reverse
+	};
+	enum PropOn { // Kp * [measurement || error]
+		POnMeasure, POnError
+	};
+	struct Limits {
+		float out_min, out_max;
+	};
+};
+
+template<typename T, uint8_t N>
+class PIDBank : public PIDBase {
+public:
+	// step() masks, a bit per controller
+	static const uint32_t ALL = 0xFFFFFFFF;
+	static uint32_t only(uint8_t i) { return (uint32_t)1 << i; }
+
+	PIDBank(uint16_t _period_ms, Direction dir, const Limits (&limits)[N], PropOn on_what = POnError)
+		: direction(dir), period_ms(_period_ms), period_us(_period_ms * 1000UL), prev_ms(0 - (uint32_t)_period_ms) {
+		for(uint8_t i = 0; i < N; ++i) init(i, limits[i], on_what);
+	}
+	// every controller with the same limits
+	PIDBank(uint16_t _period_ms, Direction dir, Limits limits, PropOn on_what = POnError)
+		: direction(dir), period_ms(_period_ms), period_us(_period_ms * 1000UL), prev_ms(0 - (uint32_t)_period_ms) {
+		for(uint8_t i = 0; i < N; ++i) init(i, limits, on_what);
+	}
+
+	// steps every controller in Automatic once a period has passed since the last step,
+	// returns whether it did
+	bool compute(uint32_t now_ms) {
+		if(now_ms - prev_ms < period_ms) return false; // safe across millis() rollover
+		prev_ms = now_ms;
+		step();
+		return true;
+	}
+
+	// steps every controller in Automatic now, for a caller that keeps the period itself.
+	// Only the controllers with their bit set in mask (1 << i) are stepped, for one whose
+	// input isn't new every step - it keeps its terms until the next step that includes it,
+	// and its own period (setPeriodMicros(i, us)) should be the time between those
+	void step(uint32_t mask = ALL) {
+		// every channel is computed and the ones not stepped thrown away, so the loop has no
+		// branches and the compiler is free to unroll it
+		for(uint8_t i = 0; i < N; ++i) {
+			T error = setpoint[i] - input[i];
+			T d_input = input[i] - prev_input[i];
+
+			// POnError puts Kp on the error, POnMeasure takes it off the sum as the input moves
+			T p_error = p_on_error[i] ? error : T(0);
+			T p_input = p_on_error[i] ? T(0) : d_input;
+
+			T sum = clamp(output_sum[i] + Ki[i] * error - Kp[i] * p_input, out_min[i], out_max[i]);
+			T out = clamp(Kp[i] * p_error + sum - Kd[i] * d_input, out_min[i], out_max[i]);
+
+			if(automatic[i] && (mask >> i & 1)) {
+				output_sum[i] = sum;
+				output[i] = out;
+				prev_input[i] = input[i];
+			}
+		}
+	}
+
+	// the gains are kept in the units they were entered in, per second, whatever the period.
+	// Sets every controller's period, and compute()'s
+	void setPeriodMicros(uint32_t _period_us) {
+		if(_period_us == 0) return;
+		period_us = _period_us;
+		period_ms = (_period_us + 500) / 1000;
+		if(period_ms == 0) period_ms = 1;
+		for(uint8_t i = 0; i < N; ++i) setPeriodMicros(i, _period_us);
+	}
+	uint32_t getPeriodMicros(void) const { return period_us; }
+
+	// one controller's period, for one that step() is told to skip some of the time
+	void setPeriodMicros(uint8_t i, uint32_t _period_us) {
+		if(_period_us == 0) return;
+		channel_us[i] = _period_us;
+		setTunings(i, disp_Kp[i], disp_Ki[i], disp_Kd[i]);
+	}
+	uint32_t getPeriodMicros(uint8_t i) const { return channel_us[i]; }
+
+	void setTunings(uint8_t i, float _Kp, float _Ki, float _Kd, PropOn on_what) {
+		p_on_error[i] = (on_what == POnError);
+		setTunings(i, _Kp, _Ki, _Kd);
+	}
+	void setTunings(uint8_t i, float _Kp, float _Ki, float _Kd) {
+		if(_Kp < 0 || _Ki < 0 || _Kd < 0) return;
+
+		disp_Kp[i] = _Kp; disp_Ki[i] = _Ki; disp_Kd[i] = _Kd;
+
+		// folded into the gains once here rather than every step
+		float period_sec = channel_us[i] / 1000000.0f;
+		float sign = (direction == Reverse) ? -1.0f : 1.0f;
+		Kp[i] = T(sign * _Kp);
+		Ki[i] = T(sign * _Ki * period_sec);
+		Kd[i] = T(sign * _Kd / period_sec);
+	}
+
+	void setMode(uint8_t i, Mode new_mode, bool on_manual_zero_output = true) {
+		bool to_auto = (new_mode == Automatic);
+		if(to_auto == automatic[i]) return;
+		if(to_auto) {
+			// pick up from wherever the output was left so it doesn't jump
+			output_sum[i] = clamp(output[i], out_min[i], out_max[i]);
+			prev_input[i] = input[i];
+		} else if(on_manual_zero_output) {
+			output[i] = T(0);
+		}
+		automatic[i] = to_auto;
+	}
+
+	void setOutputLimits(uint8_t i, float _out_min, float _out_max) {
+		if(_out_min >= _out_max) return;
+		out_min[i] = T(_out_min);
+		out_max[i] = T(_out_max);
+		if(automatic[i]) {
+			output[i] = clamp(output[i], out_min[i], out_max[i]);
+			output_sum[i] = clamp(output_sum[i], out_min[i], out_max[i]);
+		}
+	}
+
+	// one controller of the bank, with the per-controller half of the PID_v1_strang interface
+	class Channel {
+	public:
+		Channel(PIDBank& _bank, uint8_t _i) : bank(_bank), i(_i) {}
+
+		void setMode(Mode new_mode, bool on_manual_zero_output = true) { bank.setMode(i, new_mode, on_manual_zero_output); }
+		Mode getMode() const { return bank.automatic[i] ? Automatic : Manual; }
+
+		void setTunings(float _Kp, float _Ki, float _Kd, PropOn on_what) { bank.setTunings(i, _Kp, _Ki, _Kd, on_what); }
+		void setTunings(float _Kp, float _Ki, float _Kd) { bank.setTunings(i, _Kp, _Ki, _Kd); }
+		float getKp() const { return bank.disp_Kp[i]; }
+		float getKi() const { return bank.disp_Ki[i]; }
+		float getKd() const { return bank.disp_Kd[i]; }
+
+		void setOutputLimits(float _out_min, float _out_max) { bank.setOutputLimits(i, _out_min, _out_max); }
+
+		void setPeriodMicros(uint32_t _period_us) { bank.setPeriodMicros(i, _period_us); }
+		uint32_t getPeriodMicros() const { return bank.getPeriodMicros(i); }
+
+		void setSetpoint(T val) { bank.setpoint[i] = val; }
+		void setInput(T val) { bank.input[i] = val; }
+		bool setOutput(T val) {
+			if(bank.automatic[i]) return false;
+			bank.output[i] = val;
+			return true;
+		}
+
+		T getSetpoint() const { return bank.setpoint[i]; }
+		T getInput() const { return bank.input[i]; }
+		T getOutput() const { return bank.output[i]; }
+	private:
+		PIDBank& bank;
+		uint8_t i;
+	};
+
+	Channel operator[](uint8_t i) { return Channel(*this, i); }
+	uint8_t size() const { return N; }
+
+private:
+	void init(uint8_t i, Limits limits, PropOn on_what) {
+		setpoint[i] = input[i] = output[i] = output_sum[i] = prev_input[i] = T(0);
+		automatic[i] = false;
+		out_min[i] = T(limits.out_min);
+		out_max[i] = T(limits.out_max);
+		channel_us[i] = period_us;
+		setTunings(i, 0, 0, 0, on_what);
+	}
+
+	static T clamp(T val, T lo, T hi) { return val < lo ? lo : (val > hi ? hi : val); }
+
+	// one array per term, indexed by controller
+	T setpoint[N], input[N], output[N];
+	T output_sum[N], prev_input[N];
+	T out_min[N], out_max[N];
+	T Kp[N], Ki[N], Kd[N]; // corrected for the period and direction
+	float disp_Kp[N], disp_Ki[N], disp_Kd[N]; // as entered
+	uint32_t channel_us[N]; // what each one's gains are corrected for
+	bool p_on_error[N];
+	bool automatic[N];
+
+	Direction direction;
+	uint16_t period_ms; // for compute()
+	uint32_t period_us; // the bank's, what setPeriodMicros() last set them all to
+	uint32_t prev_ms;
+};
+
+template<typename T>
+class PIDCore : public PIDBank<T, 1> {
+	typedef PIDBank<T, 1> Bank;
+	typedef PIDBase::Limits Limits;
+public:
+	PIDCore(float out_min, float out_max, uint16_t period_ms, PIDBase::Direction dir = PIDBase::Direct,
+		PIDBase::PropOn on_what = PIDBase::POnError, float Kp = 0, float Ki = 0, float Kd = 0)
+		: Bank(period_ms, dir, Limits { out_min, out_max }, on_what) {
+		setTunings(Kp, Ki, Kd);
+	}
+
+	bool compute(T set, T in, uint32_t now_ms) {
+		setSetpoint(set);
+		setInput(in);
+		return Bank::compute(now_ms);
+	}
+	using Bank::compute;
+
+	void setMode(PIDBase::Mode new_mode, bool on_manual_zero_output = true) { channel().setMode(new_mode, on_manual_zero_output); }
+	PIDBase::Mode getMode() { return channel().getMode(); }
+	void setTunings(float _Kp, float _Ki, float _Kd, PIDBase::PropOn on_what) { channel().setTunings(_Kp, _Ki, _Kd, on_what); }
+	void setTunings(float _Kp, float _Ki, float _Kd) { channel().setTunings(_Kp, _Ki, _Kd); }
+	float getKp() { return channel().getKp(); }
+	float getKi() { return channel().getKi(); }
+	float getKd() { return channel().getKd(); }
+	void setOutputLimits(float _out_min, float _out_max) { channel().setOutputLimits(_out_min, _out_max); }
+	void setSetpoint(T val) { channel().setSetpoint(val); }
+	void setInput(T val) { channel().setInput(val); }
+	bool setOutput(T val) { return channel().setOutput(val); }
+	T getSetpoint() { return channel().getSetpoint(); }
+	T getInput() { return channel().getInput(); }
+	T getOutput() { return channel().getOutput(); }
+
+private:
+	typename Bank::Channel channel() { return (*this)[0]; }
+};
+
+#endif
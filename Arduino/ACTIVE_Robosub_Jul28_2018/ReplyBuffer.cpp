@@ -0,0 +1,33 @@
+#include "ReplyBuffer.h"
+
+size_t ReplyBuffer::write(uint8_t b) {
+  return write(&b, 1);
+}
+
+size_t ReplyBuffer::write(const uint8_t* buffer, size_t size) {
+  size_t room = SIZE - len;
+  if(size > room) {
+    size = room;
+    truncated = true;
+  }
+  memcpy(buf + len, buffer, size);
+  len += size;
+  buf[len] = '\0';
+  return size;
+}
+
+void ReplyBuffer::send(Print& out) {
+  if(truncated) {
+    out.write((const uint8_t*)buf, len);
+    out.println("...");
+  } else {
+    out.println(buf);
+  }
+  clear();
+}
+
+void ReplyBuffer::clear() {
+  len = 0;
+  truncated = false;
+  buf[0] = '\0';
+}
@@ -0,0 +1,40 @@
+#ifndef REPLY_BUFFER_H
+#define REPLY_BUFFER_H
+
+#include <Arduino.h>
+
+// a line of output built up in a fixed buffer and sent in one go, in place of String concatenation.
+// It's a Print, so anything Serial.print() takes formats the same way - floats with 2 decimals
+//   reply.add("CMD thrust -> thrust_base = ", thrust_base).send();
+// what doesn't fit in SIZE is dropped and the line ends in "..."
+class ReplyBuffer : public Print {
+public:
+  const static uint16_t SIZE = 192;
+
+  ReplyBuffer() : len(0), truncated(false) { buf[0] = '\0'; }
+
+  ReplyBuffer& add(void) { return *this; }
+  template<typename T, typename... Rest>
+  ReplyBuffer& add(const T& first, const Rest&... rest) {
+    print(first);
+    return add(rest...);
+  }
+
+  // prints the line to out and starts a new one
+  void send(Print& out = Serial);
+  void clear(void);
+
+  const char* c_str(void) const { return buf; }
+  uint16_t length(void) const { return len; }
+
+  using Print::write;
+  virtual size_t write(uint8_t b);
+  virtual size_t write(const uint8_t* buffer, size_t size);
+
+private:
+  char buf[SIZE + 1];
+  uint16_t len;
+  bool truncated;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "Telemetry.h"
+
+#include <stddef.h>
+
+static_assert(sizeof(Telemetry::Frame) == Telemetry::SIZE, "telemetry frame has padding, the layout in Telemetry.h is off");
+static_assert(offsetof(Telemetry::Frame, power) == 48 && offsetof(Telemetry::Frame, crc) == 58, "telemetry frame layout moved");
+
+Telemetry::Frame Telemetry::frame __attribute__((aligned(4)));
+
+Telemetry::Telemetry() : seq(0), enabled(false) {}
+
+Telemetry::Frame& Telemetry::next() {
+  memset(&frame, 0, sizeof(frame));
+  frame.sync[0] = SYNC0;
+  frame.sync[1] = SYNC1;
+  frame.version = VERSION;
+  frame.length = SIZE;
+  frame.seq = seq++;
+  return frame;
+}
+
+const uint8_t* Telemetry::finish() {
+  frame.crc = crc16((const uint8_t*)&frame, offsetof(Frame, crc));
+  return (const uint8_t*)&frame;
+}
+
+uint16_t Telemetry::crc16(const uint8_t* data, uint8_t len) {
+  // four bits at a time from a 32 byte table, half the work of a bit at a time without a 512 byte table
+  static const uint16_t table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+  };
+  uint16_t crc = 0xFFFF;
+  while(len--) {
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (*data >> 4)];
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (*data++ & 0x0F)];
+  }
+  return crc;
+}
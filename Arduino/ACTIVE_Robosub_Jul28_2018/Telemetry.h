@@ -0,0 +1,70 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+#include "control_ids.h"
+
+// binary telemetry, one frame per control tick, built in a static word aligned buffer and sent with a
+// single write - at 60 bytes it goes out in one 64 byte USB packet
+//
+// Frame layout, little endian, every field at its natural alignment so the struct is the wire format
+// on the Teensy and on the Pi alike (Brain decodes it in include/Comms/TelemetryFrame.hpp):
+//   0  uint8   sync, 0xA5 0x5A - never in the text lines around the frames, which are 7 bit ASCII
+//   2  uint8   version
+//   3  uint8   length, bytes in the whole frame
+//   4  uint32  seq, +1 every frame built whether it was sent or not, so gaps are frames lost
+//   8  uint32  time, millis() the sensors were read at
+//   12 float   pressure (mbar), temperature (C)
+//   20 float   yaw, pitch, roll (degrees)
+//   32 float   PID output per axis::Id
+//   48 int8    thruster power per thr::Id
+//   54 uint8   PID controllers running, bit per axis::Id
+//   55 uint8   flags, FRESH_PRESSURE
+//   56 uint16  kill switch ADC count
+//   58 uint16  CRC-16/CCITT-FALSE of bytes 0 - 57
+class Telemetry {
+public:
+  struct Frame {
+    uint8_t sync[2];
+    uint8_t version;
+    uint8_t length;
+    uint32_t seq;
+    uint32_t time_ms;
+    float pressure, temperature;
+    float yaw, pitch, roll;
+    float pid_out[axis::Count];
+    int8_t power[thr::Count];
+    uint8_t pid_auto;
+    uint8_t flags;
+    uint16_t kill_adc;
+    uint16_t crc;
+  };
+
+  const static uint8_t SYNC0 = 0xA5;
+  const static uint8_t SYNC1 = 0x5A;
+  const static uint8_t VERSION = 1;
+  const static uint8_t SIZE = 60;
+
+  // flags
+  const static uint8_t FRESH_PRESSURE = 0x01; // pressure and temperature are a new sample this tick
+
+  Telemetry();
+
+  // the frame to fill in for this tick, header and seq already set
+  Frame& next(void);
+  // seals the frame with its CRC, send SIZE bytes from here
+  const uint8_t* finish(void);
+
+  void setEnabled(bool _enabled) { enabled = _enabled; }
+  bool isEnabled(void) { return enabled; }
+
+  static uint16_t crc16(const uint8_t* data, uint8_t len);
+
+private:
+  static Frame frame;
+  uint32_t seq;
+  bool enabled;
+};
+
+#endif
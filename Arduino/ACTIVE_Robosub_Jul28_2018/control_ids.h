@@ -0,0 +1,45 @@
+#ifndef CONTROL_IDS_H
+#define CONTROL_IDS_H
+
+#include <Arduino.h>
+
+// ids of the PID controllers, thrusters and mixer inputs, which index the arrays holding them
+// the control loop uses these directly, names are only looked up by the interpreter
+
+namespace axis {
+	enum Id : uint8_t {
+		Yaw, Pitch, Roll, Pressure,
+		Count
+	};
+}
+
+namespace thr {
+	enum Id : uint8_t {
+		VertFL, VertBL, VertFR, VertBR, ThrustL, ThrustR,
+		Count
+	};
+}
+
+// the degrees of freedom the mixer takes a demand for, in the order their demand is met when the thrusters
+// can't do all of it: depth, then attitude, then surge
+namespace dof {
+	enum Id : uint8_t {
+		Heave, Pitch, Roll, Yaw, Surge,
+		Count
+	};
+}
+
+// in id order, which is also the order they're printed in
+const char* const axis_names[axis::Count] = { "yaw", "pitch", "roll", "pressure" };
+const char* const thruster_names[thr::Count] = { "vert_fl", "vert_bl", "vert_fr", "vert_br", "thrust_l", "thrust_r" };
+const char* const dof_names[dof::Count] = { "heave", "pitch", "roll", "yaw", "surge" };
+
+// index of name in names, -1 if it isn't there
+inline int8_t lookupId(const char* const* names, uint8_t count, const char* name) {
+	for(uint8_t i = 0; i < count; ++i) {
+		if(strcmp(name, names[i]) == 0) return i;
+	}
+	return -1;
+}
+
+#endif
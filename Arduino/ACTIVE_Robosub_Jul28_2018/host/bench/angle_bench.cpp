@@ -0,0 +1,298 @@
+/*
+Checks the attitude controllers' angle errors (AngleError.h) for every IMU
+convention, against the answer worked out in double:
+	- wrap() puts any angle, including the floats either side of every turn,
+	  into the convention's range without moving it off its heading
+	- error() for every target and measurement on a 1/4 degree grid of the
+	  range (Unsigned, Signed) or of three turns either way (Continuous) is in
+	  [-180, 180) and the same heading as target - measured, ie the short way round
+Then runs the sketch (MPU6050, so yaw is Continuous) and checks the yaw
+controller's input is the short way round to targets set by 'pid', the pilot
+keys and 'lock', with the sub half a turn and then a turn and a half from where
+it started, and that the pitch target is wrapped when it is set.
+
+Then times error() for each convention against the angleWrapShortcut() in
+double the sketch used to have, which the BNO055 #if never actually ran.
+
+usage: make bench, or bin/angle_bench [repeats]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../sketch.h"
+#include "../sim/MS5803Model.h"
+#include "../sim/MPU6050Model.h"
+#include "../../AngleError.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static sim::MS5803Model depth_sensor;
+static sim::MPU6050Model imu;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	++failures;
+	std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+// how far apart two angles are as headings, ie with whole turns taken out
+static double apart(double a, double b) {
+	return std::fabs(std::remainder(a - b, 360.0));
+}
+
+// a few float steps at the size of x, what a float sum near x can be off by
+static double ulps(double x) {
+	float f = (float)std::fabs(x) + 360;
+	return 4.0 * (std::nextafter(f, 2 * f) - f);
+}
+
+static std::string show(double a, double b, double r) {
+	char buf[96];
+	std::snprintf(buf, sizeof(buf), "%.9g, %.9g -> %.9g", a, b, r);
+	return buf;
+}
+
+// ********************************
+// AngleError.h
+// ********************************
+
+// whole degrees to a turn past the ends, in 1/64 steps, and the floats either side of every turn and half turn
+static std::vector<float> wrapInputs(void) {
+	std::vector<float> in;
+	for(int i = -1440 * 64; i <= 1440 * 64; ++i) in.push_back(i / 64.f);
+	for(int k = -20; k <= 20; ++k) {
+		float edge = 180.f * k;
+		float down = edge, up = edge;
+		for(int i = 0; i < 8; ++i) {
+			down = std::nextafter(down, -1e9f);
+			up = std::nextafter(up, 1e9f);
+			in.push_back(down);
+			in.push_back(up);
+		}
+	}
+	for(float big : { 1e5f, 123456.7f, 1e7f, 3.4e38f }) {
+		in.push_back(big);
+		in.push_back(-big);
+	}
+	in.push_back(1e-30f);
+	in.push_back(-1e-30f);
+	in.push_back(-0.f);
+	return in;
+}
+
+template<angle::Convention C>
+static void checkWrap(const char* name, float lo, float hi) {
+	unsigned bad = 0;
+	std::string first;
+	for(float a : wrapInputs()) {
+		float r = angle::Axis<C>::wrap(a);
+		// past 2^24 a float has no fraction and 360 apart is a handful of steps, only the range can be held to
+		bool ok = r >= lo && r < hi && (std::fabs(a) > 1e6 || apart(r, a) <= ulps(a));
+		if(!ok && bad++ == 0) first = show(a, 0, r);
+	}
+	check(bad == 0, (std::string(name) + "::wrap()").c_str(), std::to_string(bad) + " wrong, first " + first);
+}
+
+// every pair of targets and measurements, the error has to be in [-180, 180) and the same heading as target - measured
+template<angle::Convention C>
+static unsigned long checkError(const char* name, const std::vector<float>& targets, const std::vector<float>& measured) {
+	unsigned long bad = 0;
+	std::string first;
+	for(float t : targets) {
+		for(float m : measured) {
+			float e = angle::Axis<C>::error(t, m);
+			bool ok = e >= -180 && e < 180 && apart(e, (double)t - m) <= ulps(t) + ulps(m);
+			if(!ok && bad++ == 0) first = show(t, m, e);
+		}
+	}
+	check(bad == 0, (std::string(name) + "::error()").c_str(), std::to_string(bad) + " wrong, first " + first);
+	return (unsigned long)targets.size() * measured.size();
+}
+
+// lo up to hi in steps, with the floats next to the ends and the half turn between them
+static std::vector<float> grid(float lo, float hi, float step) {
+	std::vector<float> g;
+	for(int i = 0; lo + i * step < hi; ++i) g.push_back(lo + i * step);
+	g.push_back(std::nextafter(lo, hi));
+	g.push_back(std::nextafter(hi, lo));
+	g.push_back(std::nextafter(lo + 180, lo));
+	g.push_back(std::nextafter(lo + 180, hi));
+	return g;
+}
+
+static void checkAngleError(void) {
+	checkWrap<angle::Unsigned>("Unsigned", 0, 360);
+	checkWrap<angle::Signed>("Signed", -180, 180);
+	for(float a : wrapInputs()) {
+		if(angle::Axis<angle::Continuous>::wrap(a) != a) {
+			check(false, "Continuous::wrap() leaves targets alone", show(a, 0, angle::Axis<angle::Continuous>::wrap(a)));
+			break;
+		}
+	}
+
+	unsigned long pairs = 0;
+	std::vector<float> unsigned_grid = grid(0, 360, 0.25f);
+	pairs += checkError<angle::Unsigned>("Unsigned", unsigned_grid, unsigned_grid);
+
+	// atan2() can come out at exactly 180, the top of the range the targets are wrapped short of
+	std::vector<float> signed_grid = grid(-180, 180, 0.25f);
+	std::vector<float> signed_measured = signed_grid;
+	signed_measured.push_back(180);
+	pairs += checkError<angle::Signed>("Signed", signed_grid, signed_measured);
+
+	// targets as set, measurements from wherever the turns have got to
+	std::vector<float> continuous_grid = grid(-1080, 1080, 0.375f);
+	pairs += checkError<angle::Continuous>("Continuous", continuous_grid, continuous_grid);
+
+	// targets set from anything, through wrap() as the sketch does, against the measurements in range
+	std::vector<float> any;
+	for(int i = -2000; i <= 2000; ++i) any.push_back(i * 1.37f);
+	std::vector<float> any_unsigned, any_signed;
+	for(float a : any) {
+		any_unsigned.push_back(angle::Axis<angle::Unsigned>::wrap(a));
+		any_signed.push_back(angle::Axis<angle::Signed>::wrap(a));
+	}
+	pairs += checkError<angle::Unsigned>("Unsigned, wrapped targets", any_unsigned, grid(0, 360, 1));
+	pairs += checkError<angle::Signed>("Signed, wrapped targets", any_signed, grid(-180, 180, 1));
+
+	std::printf("AngleError.h: %lu target and measurement pairs\n", pairs);
+}
+
+// ********************************
+// Sketch
+// ********************************
+
+static const unsigned IDLE_US = 5; // see loop_bench
+
+static void loopOnce(void) {
+	std::uint64_t before = sim::now();
+	loop();
+	if(sim::now() == before) sim::advance(IDLE_US);
+}
+
+static void runFor(unsigned ms) {
+	std::uint64_t until = sim::now() + (std::uint64_t)ms * 1000;
+	while(sim::now() < until) loopOnce();
+}
+
+static std::string command(const std::string& line) {
+	sim::serialInput(line + "\n");
+	while(sim::serialPending() > 0) loopOnce();
+	loopOnce();
+	return sim::serialOutput();
+}
+
+// turns the sub about its yaw at 90 degrees/s for ms, then gives the filter a moment
+static void turn(float degrees) {
+	imu.setGyro(0, 0, degrees < 0 ? 90.f : -90.f); // the MPU6050's z is the sub's yaw inverted
+	runFor((unsigned)(std::fabs(degrees) / 90 * 1000));
+	imu.setGyro(0, 0, 0);
+	runFor(50);
+}
+
+// the input as of the next tick, after whatever was just changed
+static void checkYawInput(const char* what, float expected) {
+	runFor(20);
+	char buf[96];
+	float in = pid[axis::Yaw].getInput();
+	std::snprintf(buf, sizeof(buf), "input %.2f, expected %.2f (yaw %.2f, target %.2f)", in, expected, orientation().yaw(), pid_target[axis::Yaw]);
+	check(std::fabs(in - expected) < 1, what, buf);
+}
+
+static void checkSketch(void) {
+	depth_sensor.setPressure(1013.25f);
+	sim::setAnalog(22, 4095);
+	imu.setAccel(0, 0, 1);
+	setup();
+	runFor(100);
+	command("SAFE");
+
+	// half a turn less 10, so 170 is 20 to the left rather than 340 to the right
+	turn(-170);
+	command("pid yaw 170");
+	checkYawInput("short way to a target across 180", -20);
+
+	// a whole turn further on, the yaw doesn't wrap on the MPU6050 but the error does
+	turn(-360);
+	checkYawInput("short way with the yaw a turn and a half round", -20);
+	command("pid yaw +20");
+	checkYawInput("relative target", 0);
+
+	// pilot mode locks yaw where it is, then the keys step the target - 6 small steps to the right
+	command("mode pilot");
+	for(int i = 0; i < 6; ++i) command("l");
+	command("q");
+	checkYawInput("pilot steps", 30);
+
+	command("pid yaw lock");
+	checkYawInput("locked", 0);
+
+	// pitch is Signed, so a target past 180 is wrapped as it's set and the reply has it wrapped
+	std::string reply = command("pid pitch 190");
+	check(std::fabs(pid_target[axis::Pitch] + 170) < 1e-3f && reply.find("-> -170.00") != std::string::npos, "pitch target wrapped", reply);
+	runFor(20);
+	float e = pid[axis::Pitch].getInput();
+	check(std::fabs(e + 170 + orientation().pitch()) < 1, "pitch error", std::to_string(e));
+	command("pid pitch 0");
+}
+
+// ********************************
+// Timing
+// ********************************
+
+// as it was in the sketch
+static double angleWrapShortcut(double angle) {
+	if(angle > 180) angle -= 360; else if(angle < -180) angle += 360;
+	return angle;
+}
+
+template<typename F>
+static double timeErrors(const std::vector<float>& targets, const std::vector<float>& measured, int repeats, F&& error) {
+	volatile float sink = 0;
+	clock_type::time_point start = clock_type::now();
+	for(int r = 0; r < repeats; ++r) {
+		float sum = 0;
+		for(std::size_t i = 0; i < targets.size(); ++i) sum += error(targets[i], measured[i]);
+		sink = sink + sum;
+	}
+	return std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / ((double)repeats * targets.size());
+}
+
+int main(int argc, char* argv[]) {
+	int repeats = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+	checkAngleError();
+	checkSketch();
+	std::printf("angle error: %s\n", failures == 0 ? "ok" : "FAILED");
+
+	// a tick's worth of headings apart, over the whole range of each convention
+	std::srand(1);
+	std::vector<float> t_unsigned, m_unsigned, t_signed, m_signed, t_cont, m_cont;
+	for(int i = 0; i < 4096; ++i) {
+		float a = std::rand() / (RAND_MAX + 1.f), b = std::rand() / (RAND_MAX + 1.f);
+		t_unsigned.push_back(360 * a);
+		m_unsigned.push_back(360 * b);
+		t_signed.push_back(360 * a - 180);
+		m_signed.push_back(360 * b - 180);
+		t_cont.push_back(2160 * a - 1080);
+		m_cont.push_back(2160 * b - 1080);
+	}
+	std::printf("host ns per error, %d x 4096\n", repeats);
+	std::printf("  %-34s %6.2f\n", "angleWrapShortcut(), double", timeErrors(t_unsigned, m_unsigned, repeats,
+		[](float t, float m) { return (float)angleWrapShortcut((double)t - m); }));
+	std::printf("  %-34s %6.2f\n", "Axis<Unsigned>::error()", timeErrors(t_unsigned, m_unsigned, repeats,
+		[](float t, float m) { return angle::Axis<angle::Unsigned>::error(t, m); }));
+	std::printf("  %-34s %6.2f\n", "Axis<Signed>::error()", timeErrors(t_signed, m_signed, repeats,
+		[](float t, float m) { return angle::Axis<angle::Signed>::error(t, m); }));
+	std::printf("  %-34s %6.2f\n", "Axis<Continuous>::error()", timeErrors(t_cont, m_cont, repeats,
+		[](float t, float m) { return angle::Axis<angle::Continuous>::error(t, m); }));
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/*
+Checks the command interpreter runs without the heap and times it:
+	- a serial session through every command, the pilot keys, test mode and the
+	  loggers makes no allocation once it has been through once - the host
+	  String allocates for any length, as the Teensy's does, and operator new
+	  is counted here, so a String or a container left in the path fails it
+	- lines that are too long or have too many words are refused, not cut short
+	- host ns per parseCommand(), per command - the command table is looked up
+	  by hash, so the first and last entries and an unknown word should cost
+	  about the same
+
+usage: make bench, or bin/cmd_bench [repeats]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../sketch.h"
+
+using clock_type = std::chrono::steady_clock;
+
+// ********************************
+// Allocation counting
+// ********************************
+
+static bool counting = false;
+static unsigned long allocations = 0;
+
+void* operator new(std::size_t size) {
+	if(counting) ++allocations;
+	void* p = std::malloc(size ? size : 1);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// ********************************
+// Session
+// ********************************
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	++failures;
+	std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+static const unsigned IDLE_US = 5; // see loop_bench
+
+static void loopOnce(void) {
+	std::uint64_t before = sim::now();
+	loop();
+	if(sim::now() == before) sim::advance(IDLE_US);
+}
+
+// sends a line and runs loop() until it has been handled and long enough after for the loggers to
+// print, counting what that allocates
+static std::string command(const std::string& line, unsigned long& allocated) {
+	sim::serialInput(line + "\n");
+	unsigned long before = allocations;
+	counting = true;
+	while(sim::serialPending() > 0) loopOnce();
+	std::uint64_t until = sim::now() + 300000;
+	while(sim::now() < until) loopOnce();
+	counting = false;
+	allocated = allocations - before;
+	return sim::serialOutput();
+}
+
+static bool contains(const std::string& text, const char* what) {
+	return text.find(what) != std::string::npos;
+}
+
+// everything the interpreter does, in an order that ends where it started
+static const std::vector<std::pair<std::string, const char*>> session = {
+	{ "help", "Quick help" },
+	{ "pid yaw read", "CMD config.pid.yaw.read: " },
+	{ "pid yaw +5", "CMD config.pid.yaw -> " },
+	{ "pid yaw -5", "CMD config.pid.yaw -> " },
+	{ "pid pressure 1012.5", "CMD config.pid.pressure -> 1012.50" },
+	{ "pid pressure lock", "CMD config.pid.pressure.lock -> " },
+	{ "pid roll stop", "CMD config.pid.roll.stop -> roll controller stopped." },
+	{ "pid roll start", "CMD config.pid.roll.start -> roll controller started." },
+	{ "pid pitch tune 1.5,0.25,0.1", "CMD config.pid.pitch.tune -> p = 1.50, i = 0.25, d = 0.10" },
+	{ "pid pitch tune read", "CMD config.pid.pitch.tune.read: p = 1.50" },
+	{ "pid tune read", "   pressure: p = " },
+	{ "pid stop", "CMD config.pid.stop -> All PID controllers stopped." },
+	{ "pid start", "CMD config.pid.start -> All PID controllers started." },
+	{ "thrust 20", "CMD thrust -> thrust_base = 20.00" },
+	{ "thrust 500", "CMD thrust -> thrust_base = 100.00" },
+	{ "thrust stop", "CMD thrust.stop -> thrust_base = 0" },
+	{ "vars pilot read", "   lim_base: 80.00" },
+	{ "vars pilot jump_yaw 15", "CMD config.vars.pilot.jump_yaw -> 15.00" },
+	{ "vars pilot jump_yaw read", "CMD config.vars.pilot.jump_yaw.read: 15.00" },
+	{ "vars test power read", "CMD config.vars.test.power.read: 20.00" },
+	{ "mixer read", "   thrust_r: heave = 0.00 pitch = 0.00 roll = 0.00 yaw = -1.00 surge = 1.00" },
+	{ "mixer vert_fl 1,-1,1,0,0", "CMD mixer.vert_fl -> heave = 1.00 pitch = -1.00 roll = 1.00 yaw = 0.00 surge = 0.00" },
+	{ "mixer clip", "CMD mixer -> clip" },
+	{ "mixer priority", "CMD mixer -> priority" },
+	{ "tick 250", "CMD tick -> 250 Hz" },
+	{ "tick read", "CMD tick.read: 250 Hz" },
+	{ "tick 200", "CMD tick -> 200 Hz" },
+	{ "fusion tune read", "CMD config.fusion.tune.read: kp = 10.00, ki = 0.00" },
+	{ "fusion tune 5,0.5", "CMD config.fusion.tune -> kp = 5.00, ki = 0.50" },
+	{ "fusion tune 10,0", "CMD config.fusion.tune -> kp = 10.00, ki = 0.00" },
+	{ "heap read", "CMD heap.read: " },
+	{ "log sensors start", "CMD config.log.sensors.start -> Logging for sensors enabled." },
+	{ "log thr start", "CMD config.log.thr.start -> Logging for thr enabled." },
+	{ "log pid start", "INFO log.pid..." },
+	{ "log tick start", "CMD config.log.tick.start -> Logging for tick enabled." },
+	{ "log telemetry start", "CMD config.log.telemetry.start -> Logging for telemetry enabled." },
+	{ "log imu_cal start", "INFO log.imu_cal..." },
+	{ "log stop", "CMD config.log.stop -> All loggers disabled." },
+	{ "~~cmd~s~thrust 10", ">> thrust 10" },
+	{ "mode pilot", "CMD config.mode -> Pilot" },
+	{ "i", "CMD pilot.Forward @ " },
+	{ ",", "CMD pilot.Reverse @ " },
+	{ "k", "CMD pilot.Halt" },
+	{ "J", "CMD pilot.Left -> " },
+	{ "L", "CMD pilot.Right -> " },
+	{ "j", "CMD pilot.Left -> " },
+	{ "l", "CMD pilot.Right -> " },
+	{ "u", "CMD pilot.Ascend -> " },
+	{ "m", "CMD pilot.Descend -> " },
+	{ "q", "CMD pilot.Quit" },
+	{ "mode test", "CMD config.mode -> Test." },
+	{ "list", "CMD test.list: [ vert_fl vert_bl vert_fr vert_br thrust_l thrust_r  ]" },
+	{ "thrust", "CMD test.set -> [ thrust_l thrust_r ] to 20.00" },
+	{ "x", "CMD test.stop" },
+	{ "exit", "CMD test.Quit -> Config." },
+	{ "a b c d e f g", "ERROR Bad syntax" },
+	{ std::string(100, 'z'), "ERROR Command longer than 63 chars, dropped." },
+	{ "stop", "CMD stop -> Made safe." }
+};
+
+static void runSession(bool first) {
+	for(const auto& c : session) {
+		unsigned long allocated;
+		std::string out = command(c.first, allocated);
+		check(contains(out, c.second), ("'" + c.first.substr(0, 20) + "'").c_str(), "expected \"" + std::string(c.second) + "\", got \"" + out + "\"");
+		if(!first) check(allocated == 0, ("'" + c.first.substr(0, 20) + "' allocates").c_str(), std::to_string(allocated) + " times");
+	}
+}
+
+// ********************************
+// Timing
+// ********************************
+
+static double percentile(std::vector<double> v, double p) {
+	std::sort(v.begin(), v.end());
+	return v[std::min(v.size() - 1, (std::size_t)(p * (v.size() - 1) + 0.5))];
+}
+
+int main(int argc, char* argv[]) {
+	int repeats = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+	sim::setAnalog(22, 4095); // kill switch in
+	setup();
+	sim::serialOutput();
+	unsigned long allocated;
+	command("SAFE", allocated);
+
+	runSession(true); // the simulation's own buffers grow on the first pass
+	runSession(false);
+	std::printf("session: %s\n", failures == 0 ? "ok" : "FAILED");
+
+	// config commands that leave things as they found them, timed one parseCommand() at a time with the
+	// tick off - replies go to the simulated port and are thrown away
+	control_tick.end();
+	allocations = 0;
+	const char* timed[] = {
+		"pid", "x", "unknown", "pid yaw read", "pid yaw +0", "pid pitch tune 1.5,0.25,0.1", "pid tune read",
+		"thrust 0", "vars pilot step_yaw read", "mixer read", "log pid stop", "heap read"
+	};
+	std::printf("%d repeats, host ns per parseCommand()\n", repeats);
+	std::printf("  %-32s %8s %8s %8s\n", "", "p50", "p99", "max");
+	std::vector<double> ns(repeats);
+	char line[64];
+	for(const char* t : timed) {
+		for(int k = 0; k < repeats; ++k) {
+			std::strcpy(line, t);
+			counting = true;
+			clock_type::time_point start = clock_type::now();
+			parseCommand(line);
+			ns[k] = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+			counting = false;
+			sim::serialOutput();
+		}
+		std::printf("  %-32s %8.0f %8.0f %8.0f\n", t, percentile(ns, 0.5), percentile(ns, 0.99), percentile(ns, 1));
+	}
+	sim::serialOutput();
+	check(allocations == 0, "parseCommand() allocates", std::to_string(allocations) + " times");
+
+	std::strcpy(line, "heap read");
+	parseCommand(line);
+	std::printf("%s", sim::serialOutput().c_str());
+
+	return failures == 0 ? 0 : 1;
+}
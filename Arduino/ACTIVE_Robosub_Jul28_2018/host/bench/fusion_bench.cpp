@@ -0,0 +1,498 @@
+/*
+Replays IMU logs through Fusion and the filters it replaced, and prints how far
+each one's attitude is from the truth and what an update costs:
+	Fusion        ~ Fusion.h at the gains setup() boots with, fixed time step, Euler angles
+	                converted once per update here so the errors can be taken
+	complementary ~ what MPU6050_tockn computes, the MPU6050 path before Fusion
+	Mahony        ~ quaternionFilters' MahonyQuaternionUpdate() on the measured
+	                time step and the trig readMPU9250() ran after every update,
+	                the MPU9250 path before Fusion (logs with a magnetometer only)
+Errors are taken after the first 5 s, so the filters have settled. Yaw from a
+filter without a magnetometer is taken relative to where it started.
+
+With no logs given it makes its own at 200 Hz, from known motion with gyro
+bias and noise, and fails when Fusion's error on them is over the limits. It
+also checks invSqrt() against 1/sqrt(), and the sketch on the simulated MPU6050:
+the time step follows the tick rate, and yaw, pitch and roll come out on the
+sub's axes with yaw carrying on past +-180.
+
+A log is CSV, '#' starts a comment, and the first line names the columns:
+	t,gx,gy,gz,ax,ay,az[,mx,my,mz][,yaw,pitch,roll]
+t in seconds, gyro in degrees/s, accel and mag in any unit, all in the sensor's
+frame. yaw,pitch,roll are the true attitude in degrees, z-y-x order as
+Fusion::getEuler() gives it, from a reference IMU or a rig - without them only
+the cost is printed. The filters step once per line at the log's median
+interval.
+
+usage: make bench, or bin/fusion_bench [log.csv ...] [--repeats n]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../sketch.h"
+#include "../sim/MPU6050Model.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static sim::MPU6050Model imu;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	++failures;
+	std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+static const double SETTLE_S = 5;
+
+// ********************************
+// Logs
+// ********************************
+
+struct Sample {
+	double t;
+	float g[3], a[3], m[3];
+	float truth[3]; // yaw, pitch, roll
+};
+
+struct Log {
+	std::string name;
+	std::vector<Sample> samples;
+	bool mag, truth;
+	double period_s;
+};
+
+static double medianPeriod(const std::vector<Sample>& s) {
+	std::vector<double> dt;
+	for(std::size_t i = 1; i < s.size(); ++i) dt.push_back(s[i].t - s[i - 1].t);
+	if(dt.empty()) return 0.005;
+	std::nth_element(dt.begin(), dt.begin() + dt.size() / 2, dt.end());
+	return dt[dt.size() / 2];
+}
+
+static bool readLog(const char* path, Log& log) {
+	std::ifstream in(path);
+	if(!in) return false;
+	log.name = path;
+	std::vector<std::string> columns;
+	std::string line;
+	while(std::getline(in, line)) {
+		line = line.substr(0, line.find('#'));
+		if(line.find_first_not_of(" \t\r") == std::string::npos) continue;
+		std::vector<std::string> fields;
+		std::stringstream ss(line);
+		for(std::string f; std::getline(ss, f, ',');) fields.push_back(f.substr(f.find_first_not_of(" \t") == std::string::npos ? 0 : f.find_first_not_of(" \t")));
+		if(columns.empty()) {
+			columns = fields;
+			for(std::string& c : columns) c.erase(c.find_last_not_of(" \t\r") + 1);
+			continue;
+		}
+		Sample s = {};
+		for(std::size_t i = 0; i < columns.size() && i < fields.size(); ++i) {
+			static const char* names[] = { "t", "gx", "gy", "gz", "ax", "ay", "az", "mx", "my", "mz", "yaw", "pitch", "roll" };
+			float* slots[] = { nullptr, &s.g[0], &s.g[1], &s.g[2], &s.a[0], &s.a[1], &s.a[2], &s.m[0], &s.m[1], &s.m[2], &s.truth[0], &s.truth[1], &s.truth[2] };
+			for(int n = 0; n < 13; ++n) {
+				if(columns[i] != names[n]) continue;
+				if(n == 0) s.t = std::atof(fields[i].c_str()); else *slots[n] = (float)std::atof(fields[i].c_str());
+			}
+		}
+		log.samples.push_back(s);
+	}
+	auto has = [&columns](const char* c) { return std::find(columns.begin(), columns.end(), c) != columns.end(); };
+	log.mag = has("mx") && has("my") && has("mz");
+	log.truth = has("yaw") && has("pitch") && has("roll");
+	log.period_s = medianPeriod(log.samples);
+	return has("t") && has("gx") && has("gy") && has("gz") && has("ax") && has("ay") && has("az") && !log.samples.empty();
+}
+
+// --------------------------------
+// synthesized: attitude as a function of time, the gyro from its derivative, gravity and the earth's field
+// turned into the sensor frame
+// --------------------------------
+
+static const double D2R = M_PI / 180;
+
+// v in the earth frame to the sensor frame, for z-y-x Euler angles in radians
+static void toSensor(double yaw, double pitch, double roll, const double v[3], double out[3]) {
+	double cy = std::cos(yaw), sy = std::sin(yaw), cp = std::cos(pitch), sp = std::sin(pitch), cr = std::cos(roll), sr = std::sin(roll);
+	// rows of R^T, R = Rz(yaw) Ry(pitch) Rx(roll)
+	out[0] = cp * cy * v[0] + cp * sy * v[1] - sp * v[2];
+	out[1] = (sr * sp * cy - cr * sy) * v[0] + (sr * sp * sy + cr * cy) * v[1] + sr * cp * v[2];
+	out[2] = (cr * sp * cy + sr * sy) * v[0] + (cr * sp * sy - sr * cy) * v[1] + cr * cp * v[2];
+}
+
+typedef std::function<void(double t, double e[3])> Motion; // yaw, pitch, roll in degrees
+
+static Log synthesize(const char* name, double seconds, bool mag, Motion motion, unsigned seed) {
+	const double period = 0.005;
+	const double up[3] = { 0, 0, 1 }; // what a level accelerometer reads, 1 g up
+	const double dip = 60 * D2R;
+	const double field[3] = { std::cos(dip), 0, -std::sin(dip) }; // to the north along x, and down
+	std::mt19937 rng(seed);
+	std::normal_distribution<double> gyro_noise(0, 0.05), accel_noise(0, 0.01), mag_noise(0, 0.01);
+	const double bias[3] = { 0.03, -0.02, 0.02 }; // what calcGyroOffsets() leaves, degrees/s
+
+	Log log = { name, {}, mag, true, period };
+	for(double t = 0; t < seconds; t += period) {
+		double e[3], e0[3], e1[3];
+		const double h = 1e-4;
+		motion(t, e);
+		motion(t - h, e0);
+		motion(t + h, e1);
+		double yaw = e[0] * D2R, pitch = e[1] * D2R, roll = e[2] * D2R;
+		double dyaw = (e1[0] - e0[0]) / (2 * h), dpitch = (e1[1] - e0[1]) / (2 * h), droll = (e1[2] - e0[2]) / (2 * h);
+		// body rates from the Euler angle rates
+		double rate[3] = {
+			droll - dyaw * std::sin(pitch),
+			dpitch * std::cos(roll) + dyaw * std::cos(pitch) * std::sin(roll),
+			-dpitch * std::sin(roll) + dyaw * std::cos(pitch) * std::cos(roll)
+		};
+		double a[3], m[3];
+		toSensor(yaw, pitch, roll, up, a);
+		toSensor(yaw, pitch, roll, field, m);
+
+		Sample s;
+		s.t = t;
+		for(int i = 0; i < 3; ++i) {
+			s.g[i] = (float)(rate[i] + bias[i] + gyro_noise(rng));
+			s.a[i] = (float)(a[i] + accel_noise(rng));
+			s.m[i] = mag ? (float)(m[i] + mag_noise(rng)) : 0;
+			s.truth[i] = (float)e[i];
+		}
+		// the truth wrapped the way getEuler() gives it
+		s.truth[0] = (float)std::remainder(e[0], 360.0);
+		log.samples.push_back(s);
+	}
+	return log;
+}
+
+static std::vector<Log> synthesized(void) {
+	std::vector<Log> logs;
+	logs.push_back(synthesize("still, tilted", 20, false, [](double, double e[3]) {
+		e[0] = 0; e[1] = -7; e[2] = 12;
+	}, 1));
+	logs.push_back(synthesize("turning, rolling", 30, false, [](double t, double e[3]) {
+		// a full turn one way at 60 degrees/s, a pause, then 1.5 turns back, rocking all the while
+		double turn = t < 5 ? 0 : (t < 11 ? 60 * (t - 5) : (t < 15 ? 360 : std::max(-180.0, 360 - 60 * (t - 15))));
+		e[0] = turn;
+		e[1] = 3 * std::sin(2 * M_PI * 0.25 * t);
+		e[2] = 5 * std::sin(2 * M_PI * 0.4 * t);
+	}, 2));
+	logs.push_back(synthesize("swell, magnetometer", 30, true, [](double t, double e[3]) {
+		e[0] = 90 + 30 * std::sin(2 * M_PI * 0.05 * t);
+		e[1] = 10 * std::sin(2 * M_PI * 0.2 * t);
+		e[2] = 15 * std::sin(2 * M_PI * 0.3 * t);
+	}, 3));
+	return logs;
+}
+
+// ********************************
+// The filters
+// ********************************
+
+// attitude out in degrees, yaw pitch roll
+struct Filter {
+	const char* name;
+	std::function<void(void)> reset;
+	std::function<void(const Sample& s, double dt)> update;
+	std::function<void(float e[3])> euler;
+	bool needs_mag;
+	bool uses_mag; // has a heading of its own, otherwise yaw is compared from where it started
+};
+
+namespace legacy {
+	// MPU6050_tockn's update(), on the interval it measured
+	struct Complementary {
+		float angle_x, angle_y, angle_z;
+		bool started;
+
+		void reset(void) { angle_x = angle_y = angle_z = 0; started = false; }
+		void update(const float g[3], const float a[3], float interval) {
+			float angle_acc_x = atan2(a[1], sqrt(a[2] * a[2] + a[0] * a[0])) * 360 / 2.0 / PI;
+			float angle_acc_y = atan2(a[0], sqrt(a[2] * a[2] + a[1] * a[1])) * 360 / -2.0 / PI;
+			if(!started) { // begin() starts from the accelerometer
+				angle_x = angle_acc_x;
+				angle_y = angle_acc_y;
+				started = true;
+			}
+			angle_x = (0.98f * (angle_x + g[0] * interval)) + (0.02f * angle_acc_x);
+			angle_y = (0.98f * (angle_y + g[1] * interval)) + (0.02f * angle_acc_y);
+			angle_z += g[2] * interval;
+		}
+	};
+
+	// quaternionFilters.cpp's MahonyQuaternionUpdate(), gyro in radians/s
+	struct Mahony {
+		float q[4];
+		float eInt[3];
+
+		void reset(void) {
+			q[0] = 1; q[1] = q[2] = q[3] = 0;
+			eInt[0] = eInt[1] = eInt[2] = 0;
+		}
+		void update(float ax, float ay, float az, float gx, float gy, float gz, float mx, float my, float mz, float deltat) {
+			const float Kp = 2.0f * 5.0f, Ki = 0.0f;
+			float q1 = q[0], q2 = q[1], q3 = q[2], q4 = q[3];
+			float norm, hx, hy, bx, bz, vx, vy, vz, wx, wy, wz, ex, ey, ez, pa, pb, pc;
+			float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3, q1q4 = q1 * q4;
+			float q2q2 = q2 * q2, q2q3 = q2 * q3, q2q4 = q2 * q4;
+			float q3q3 = q3 * q3, q3q4 = q3 * q4, q4q4 = q4 * q4;
+
+			norm = sqrt(ax * ax + ay * ay + az * az);
+			if(norm == 0.0f) return;
+			norm = 1.0f / norm;
+			ax *= norm; ay *= norm; az *= norm;
+			norm = sqrt(mx * mx + my * my + mz * mz);
+			if(norm == 0.0f) return;
+			norm = 1.0f / norm;
+			mx *= norm; my *= norm; mz *= norm;
+
+			hx = 2.0f * mx * (0.5f - q3q3 - q4q4) + 2.0f * my * (q2q3 - q1q4) + 2.0f * mz * (q2q4 + q1q3);
+			hy = 2.0f * mx * (q2q3 + q1q4) + 2.0f * my * (0.5f - q2q2 - q4q4) + 2.0f * mz * (q3q4 - q1q2);
+			bx = sqrt((hx * hx) + (hy * hy));
+			bz = 2.0f * mx * (q2q4 - q1q3) + 2.0f * my * (q3q4 + q1q2) + 2.0f * mz * (0.5f - q2q2 - q3q3);
+
+			vx = 2.0f * (q2q4 - q1q3);
+			vy = 2.0f * (q1q2 + q3q4);
+			vz = q1q1 - q2q2 - q3q3 + q4q4;
+			wx = 2.0f * bx * (0.5f - q3q3 - q4q4) + 2.0f * bz * (q2q4 - q1q3);
+			wy = 2.0f * bx * (q2q3 - q1q4) + 2.0f * bz * (q1q2 + q3q4);
+			wz = 2.0f * bx * (q1q3 + q2q4) + 2.0f * bz * (0.5f - q2q2 - q3q3);
+
+			ex = (ay * vz - az * vy) + (my * wz - mz * wy);
+			ey = (az * vx - ax * vz) + (mz * wx - mx * wz);
+			ez = (ax * vy - ay * vx) + (mx * wy - my * wx);
+			if(Ki > 0.0f) {
+				eInt[0] += ex; eInt[1] += ey; eInt[2] += ez;
+			} else {
+				eInt[0] = eInt[1] = eInt[2] = 0.0f;
+			}
+			gx = gx + Kp * ex + Ki * eInt[0];
+			gy = gy + Kp * ey + Ki * eInt[1];
+			gz = gz + Kp * ez + Ki * eInt[2];
+
+			pa = q2; pb = q3; pc = q4;
+			q1 = q1 + (-q2 * gx - q3 * gy - q4 * gz) * (0.5f * deltat);
+			q2 = pa + (q1 * gx + pb * gz - pc * gy) * (0.5f * deltat);
+			q3 = pb + (q1 * gy - pa * gz + pc * gx) * (0.5f * deltat);
+			q4 = pc + (q1 * gz + pa * gy - pb * gx) * (0.5f * deltat);
+
+			norm = sqrt(q1 * q1 + q2 * q2 + q3 * q3 + q4 * q4);
+			norm = 1.0f / norm;
+			q[0] = q1 * norm; q[1] = q2 * norm; q[2] = q3 * norm; q[3] = q4 * norm;
+		}
+		// readMPU9250()'s conversion, run after every update
+		void euler(float e[3]) {
+			const float* Q = q;
+			e[0] = atan2(2.0f * (Q[1] * Q[2] + Q[0] * Q[3]), Q[0] * Q[0] + Q[1] * Q[1] - Q[2] * Q[2] - Q[3] * Q[3]) * RAD_TO_DEG;
+			e[1] = -asin(2.0f * (Q[1] * Q[3] - Q[0] * Q[2])) * RAD_TO_DEG;
+			e[2] = atan2(2.0f * (Q[0] * Q[1] + Q[2] * Q[3]), Q[0] * Q[0] - Q[1] * Q[1] - Q[2] * Q[2] + Q[3] * Q[3]) * RAD_TO_DEG;
+		}
+	};
+}
+
+static Fusion fusion_under_test;
+static const float BOOT_KP = 10, BOOT_KI = 0; // FUSION_KP/KI in the sketch, checkSketch() holds them to it
+static legacy::Complementary complementary;
+static legacy::Mahony mahony;
+static float mahony_euler[3];
+
+static std::vector<Filter> filters(const Log& log) {
+	const bool mag = log.mag;
+	std::vector<Filter> f;
+	f.push_back({ "Fusion",
+		[&log]() { fusion_under_test.reset(); fusion_under_test.setGains(BOOT_KP, BOOT_KI); fusion_under_test.setPeriodMicros((uint32_t)(log.period_s * 1e6 + 0.5)); },
+		[mag](const Sample& s, double) {
+			if(mag) fusion_under_test.update(s.g[0], s.g[1], s.g[2], s.a[0], s.a[1], s.a[2], s.m[0], s.m[1], s.m[2]);
+			else fusion_under_test.update(s.g[0], s.g[1], s.g[2], s.a[0], s.a[1], s.a[2]);
+		},
+		[](float e[3]) { fusion_under_test.getEuler(e[0], e[1], e[2]); },
+		false, mag });
+	f.push_back({ "complementary",
+		[]() { complementary.reset(); },
+		[](const Sample& s, double dt) { complementary.update(s.g, s.a, (float)dt); },
+		[](float e[3]) { e[0] = complementary.angle_z; e[1] = complementary.angle_y; e[2] = complementary.angle_x; },
+		false, false });
+	f.push_back({ "Mahony",
+		[]() { mahony.reset(); },
+		[](const Sample& s, double dt) {
+			mahony.update(s.a[0], s.a[1], s.a[2], s.g[0] * DEG_TO_RAD, s.g[1] * DEG_TO_RAD, s.g[2] * DEG_TO_RAD, s.m[0], s.m[1], s.m[2], (float)dt);
+			mahony.euler(mahony_euler);
+		},
+		[](float e[3]) { std::memcpy(e, mahony_euler, sizeof(mahony_euler)); },
+		true, true });
+	return f;
+}
+
+// ********************************
+// Replay
+// ********************************
+
+struct Errors {
+	double sum_sq[3] = { 0, 0, 0 };
+	double max[3] = { 0, 0, 0 };
+	long count = 0;
+
+	double rms(int i) const { return count ? std::sqrt(sum_sq[i] / count) : 0; }
+};
+
+static Errors replay(const Log& log, Filter& f) {
+	Errors err;
+	f.reset();
+	double yaw_offset = 0;
+	for(std::size_t i = 0; i < log.samples.size(); ++i) {
+		const Sample& s = log.samples[i];
+		double dt = i > 0 ? s.t - log.samples[i - 1].t : log.period_s;
+		f.update(s, dt);
+		float e[3];
+		f.euler(e);
+		if(i == 0) yaw_offset = f.uses_mag ? 0 : e[0] - s.truth[0];
+		if(!log.truth || s.t - log.samples.front().t < SETTLE_S) continue;
+		for(int k = 0; k < 3; ++k) {
+			double d = e[k] - s.truth[k] - (k == 0 ? yaw_offset : 0);
+			d = std::remainder(d, 360.0);
+			err.sum_sq[k] += d * d;
+			err.max[k] = std::max(err.max[k], std::fabs(d));
+		}
+		++err.count;
+	}
+	return err;
+}
+
+static double nsPerUpdate(const Log& log, Filter& f, int repeats, bool euler) {
+	f.reset();
+	float e[3] = { 0, 0, 0 }, sink = 0;
+	clock_type::time_point start = clock_type::now();
+	for(int r = 0; r < repeats; ++r) {
+		for(const Sample& s : log.samples) {
+			f.update(s, log.period_s);
+			if(euler) {
+				f.euler(e);
+				sink += e[0];
+			}
+		}
+	}
+	double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / ((double)repeats * log.samples.size());
+	return sink == 12345 ? 0 : ns; // keeps the Euler angles from being optimised away
+}
+
+// ********************************
+// The sketch on the simulated MPU6050
+// ********************************
+
+static const unsigned IDLE_US = 5; // see loop_bench
+
+static void runFor(unsigned ms) {
+	std::uint64_t until = sim::now() + (std::uint64_t)ms * 1000;
+	while(sim::now() < until) {
+		std::uint64_t before = sim::now();
+		loop();
+		if(sim::now() == before) sim::advance(IDLE_US);
+	}
+}
+
+static std::string show(EulerVector3& o) {
+	char buf[80];
+	std::snprintf(buf, sizeof(buf), "yaw %.2f pitch %.2f roll %.2f", o.yaw(), o.pitch(), o.roll());
+	return buf;
+}
+
+static void checkSketch(void) {
+	sim::setAnalog(22, 4095);
+	setup();
+	sim::serialOutput();
+	check(fusion.getPeriodMicros() == control_tick.getPeriodMicros(), "fusion steps at the tick's period", std::to_string(fusion.getPeriodMicros()));
+	check(fusion.getKp() == BOOT_KP && fusion.getKi() == BOOT_KI, "fusion boots at the gains benched here",
+		std::to_string(fusion.getKp()) + ", " + std::to_string(fusion.getKi()));
+
+	// rolled 10 degrees about the sensor's x, which is the sub's pitch
+	imu.setAccel(0, (float)std::sin(10 * D2R), (float)std::cos(10 * D2R));
+	runFor(6000);
+	EulerVector3& o = orientation();
+	check(std::fabs(o.pitch() - 10) < 0.2f && std::fabs(o.roll()) < 0.2f && std::fabs(o.yaw()) < 0.2f, "sensor x is the sub's pitch", show(o));
+
+	// pitched about the sensor's y, the sub's roll the other way
+	imu.setAccel((float)-std::sin(10 * D2R), 0, (float)std::cos(10 * D2R));
+	runFor(6000);
+	check(std::fabs(o.roll() + 10) < 0.2f && std::fabs(o.pitch()) < 0.2f, "sensor y is the sub's roll, inverted", show(orientation()));
+
+	// 1.5 turns about the sensor's z, yaw inverted and carrying on past -180
+	imu.setAccel(0, 0, 1);
+	runFor(6000);
+	imu.setGyro(0, 0, 90);
+	runFor(6000);
+	imu.setGyro(0, 0, 0);
+	runFor(100);
+	check(std::fabs(orientation().yaw() + 540) < 2, "yaw carries on past 180", show(orientation()));
+
+	sim::serialInput("SAFE\n");
+	runFor(100);
+	sim::serialInput("tick 100\n");
+	runFor(100);
+	check(fusion.getPeriodMicros() == 10000, "fusion follows the tick rate", std::to_string(fusion.getPeriodMicros()));
+	sim::serialInput("tick 200\n");
+	runFor(100);
+	sim::serialOutput();
+}
+
+int main(int argc, char* argv[]) {
+	int repeats = 20;
+	std::vector<Log> logs;
+	for(int i = 1; i < argc; ++i) {
+		if(std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+			repeats = std::atoi(argv[++i]);
+			continue;
+		}
+		Log log;
+		if(!readLog(argv[i], log)) {
+			std::printf("can't read a log from %s\n", argv[i]);
+			return 1;
+		}
+		logs.push_back(log);
+	}
+	const bool own_logs = logs.empty();
+	if(own_logs) logs = synthesized();
+
+	// invSqrt() against 1 / sqrt() over the range a quaternion's length and the sensor readings cover
+	double worst = 0;
+	for(float x = 1e-4f; x < 1e4f; x *= 1.001f) worst = std::max(worst, std::fabs(Fusion::invSqrt(x) * std::sqrt((double)x) - 1));
+	check(worst < 7e-4, "invSqrt() error", std::to_string(worst));
+	std::printf("invSqrt(): worst error %.3f%%\n", worst * 100);
+
+	std::printf("%-22s %-14s %7s %7s %7s %7s %7s %7s %9s %9s\n", "", "", "yaw", "pitch", "roll", "yaw", "pitch", "roll", "update", "+euler");
+	std::printf("%-22s %-14s %23s %23s %19s\n", "log", "filter", "rms error (deg)", "max error (deg)", "host ns");
+	for(const Log& log : logs) {
+		for(Filter& f : filters(log)) {
+			if(f.needs_mag && !log.mag) continue;
+			Errors err = replay(log, f);
+			double ns = nsPerUpdate(log, f, repeats, false);
+			double ns_euler = nsPerUpdate(log, f, repeats, true);
+			if(log.truth) {
+				std::printf("%-22s %-14s %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %9.1f %9.1f\n", log.name.c_str(), f.name,
+					err.rms(0), err.rms(1), err.rms(2), err.max[0], err.max[1], err.max[2], ns, ns_euler);
+			} else {
+				std::printf("%-22s %-14s %7s %7s %7s %7s %7s %7s %9.1f %9.1f\n", log.name.c_str(), f.name, "-", "-", "-", "-", "-", "-", ns, ns_euler);
+			}
+			if(own_logs && std::strcmp(f.name, "Fusion") == 0) {
+				check(err.rms(1) < 0.5 && err.rms(2) < 0.5 && err.max[1] < 1.5 && err.max[2] < 1.5, "Fusion pitch and roll", log.name);
+				check(err.rms(0) < 1.5 && err.max[0] < 3, "Fusion yaw", log.name);
+			}
+		}
+	}
+
+	checkSketch();
+	std::printf("fusion: %s\n", failures == 0 ? "ok" : "FAILED");
+	return failures == 0 ? 0 : 1;
+}
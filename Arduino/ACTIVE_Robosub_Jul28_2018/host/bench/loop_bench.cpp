@@ -0,0 +1,314 @@
+/*
+Runs the firmware on the host against the simulated sensors and checks a
+scripted serial session does what it does on the sub: replies to config and
+pilot commands, and the sensor -> PID -> mixer -> ESC chain pushing the right
+thrusters the right way when depth and heading are off target, and the depth
+controller's derivative holding steady across the MS5803's samples. Then it runs
+loop() as it is on the sub, with the control tick off its timer, and reports
+the tick's timing (a check fails if any tick was dropped), and times each part
+of loop() over many iterations:
+	host ns  ~ CPU time on this machine, for comparing implementations
+	sim us   ~ time the Teensy would spend waiting on I/O in that part (delay(),
+	           I2C at the bus clock, analogRead()) - machine independent, so it can
+	           be held to a budget
+
+usage: make bench, or bin/loop_bench [loops] [--budget part=us ...]
+	a budget fails the run when the part's worst sim us goes over it,
+	ie --budget readSensors=2500 --budget loop=3000
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../sketch.h"
+#include "../sim/MS5803Model.h"
+#include "../sim/MPU6050Model.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static const int PIN_ADC_KILL = 22;
+static const int PIN_THRUST_L = 2, PIN_THRUST_R = 5;
+static const int PIN_VERT[] = { 3, 4, 6, 7 }; // fl, bl, fr, br
+
+static sim::MS5803Model depth_sensor;
+static sim::MPU6050Model imu;
+
+// ********************************
+// Session
+// ********************************
+
+static int failures = 0;
+
+// a pass of loop() with nothing to do costs nothing in simulated time, charge it what it would on the
+// Teensy so the clock gets to the next tick
+static const unsigned IDLE_US = 5;
+
+static void loopOnce(void) {
+	std::uint64_t before = sim::now();
+	loop();
+	if(sim::now() == before) sim::advance(IDLE_US);
+}
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	++failures;
+	std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+// runs loop() until the simulated clock has moved on by ms
+static void runFor(unsigned ms) {
+	std::uint64_t until = sim::now() + (std::uint64_t)ms * 1000;
+	while(sim::now() < until) loopOnce();
+}
+
+// sends a line the way the serial monitor would and returns everything printed until it has been handled
+static std::string command(const std::string& line) {
+	sim::serialInput(line + "\n");
+	while(sim::serialPending() > 0) loopOnce();
+	loopOnce();
+	return sim::serialOutput();
+}
+
+static bool contains(const std::string& text, const char* what) {
+	return text.find(what) != std::string::npos;
+}
+
+static void expectReply(const std::string& line, const char* reply) {
+	std::string out = command(line);
+	check(contains(out, reply), ("'" + line + "'").c_str(), "expected \"" + std::string(reply) + "\", got \"" + out + "\"");
+}
+
+static int power(int pin) {
+	// back from the ESC pulse width to BLThruster's -100 to 100
+	return (sim::pwm(pin) - 1500) * 100 / 400;
+}
+
+static void runSession(void) {
+	depth_sensor.setPressure(1013.25f);
+	depth_sensor.setTemperature(21);
+	sim::setAnalog(PIN_ADC_KILL, 4095);
+
+	setup();
+	std::string boot = sim::serialOutput();
+	check(contains(boot, "BOOT Finished."), "boot", boot);
+	check(contains(boot, "Emergency stop activated"), "boot ends in EStop", boot);
+
+	runFor(100);
+	check(command("help").empty(), "commands other than SAFE are ignored while disabled");
+	expectReply("SAFE", "INFO System Enabled");
+	expectReply("pid pressure read", "CMD config.pid.pressure.read: 1010.00");
+	expectReply("pid pressure lock", "CMD config.pid.pressure.lock -> 1013.25");
+	expectReply("pid yaw +10", "CMD config.pid.yaw -> 10.00");
+	expectReply("pid yaw tune 2,0,0", "CMD config.pid.yaw.tune -> p = 2.00, i = 0.00, d = 0.00");
+	expectReply("pid pressure tune 3,0,0", "CMD config.pid.pressure.tune -> p = 3.00, i = 0.00, d = 0.00");
+	expectReply("vars pilot step_thrust read", "CMD config.vars.pilot.step_thrust.read: 20.00");
+	expectReply("thrust 30", "CMD thrust -> thrust_base = 30.00");
+	expectReply("tick read", "CMD tick.read: 200 Hz");
+	expectReply("tick 5000", "ERROR tick -> 5000 Hz is outside 10 - 1000");
+	expectReply("tick 65546", "ERROR tick -> 65546 Hz is outside 10 - 1000"); // 10 once narrowed to 16 bits
+	expectReply("tick -65336", "ERROR tick -> -65336 Hz is outside 10 - 1000");
+	expectReply("tick 99999999999999999999", "ERROR tick -> 99999999999999999999 Hz is outside 10 - 1000");
+	expectReply("tick 100", "CMD tick -> 100 Hz");
+	runFor(1000);
+	expectReply("tick read", "CMD tick.read: 100 Hz, 100 ticks, 0 missed");
+	expectReply("tick 200", "CMD tick -> 200 Hz");
+
+	// 10 degrees left of the yaw target and 5 mbar too shallow
+	depth_sensor.setPressure(1008.25f);
+	expectReply("pid start", "CMD config.pid.start -> All PID controllers started.");
+	runFor(200);
+	// proportional only, both controllers are Reverse acting on target - measured:
+	// yaw 10 * 2 = 20 more on the left, depth 5 * 3 = 15 on the verticals
+	check(power(PIN_THRUST_L) == 30 + 20 && power(PIN_THRUST_R) == 30 - 20, "yaw correction on the side thrusters",
+		std::to_string(power(PIN_THRUST_L)) + ", " + std::to_string(power(PIN_THRUST_R)));
+	for(int pin : PIN_VERT) {
+		check(power(pin) == 15, "depth correction on the vertical thrusters", "pin " + std::to_string(pin) + " at " + std::to_string(power(pin)));
+	}
+
+	// surge pushed up against the limit: the priority mixer backs it off so the yaw correction keeps its 20 either
+	// way, clipping each thruster leaves the left one nothing to give
+	expectReply("mixer read", "CMD mixer.read: priority");
+	expectReply("thrust 90", "CMD thrust -> thrust_base = 90.00");
+	runFor(100);
+	check(power(PIN_THRUST_L) == 100 && power(PIN_THRUST_R) == 60, "priority mixer keeps the yaw correction",
+		std::to_string(power(PIN_THRUST_L)) + ", " + std::to_string(power(PIN_THRUST_R)));
+	check(power(PIN_VERT[0]) == 15, "priority mixer leaves depth alone", std::to_string(power(PIN_VERT[0])));
+	expectReply("mixer clip", "CMD mixer -> clip");
+	runFor(100);
+	check(power(PIN_THRUST_L) == 100 && power(PIN_THRUST_R) == 70, "clip mixer clips",
+		std::to_string(power(PIN_THRUST_L)) + ", " + std::to_string(power(PIN_THRUST_R)));
+	expectReply("mixer priority", "CMD mixer -> priority");
+	expectReply("thrust 30", "CMD thrust -> thrust_base = 30.00");
+
+	expectReply("mode pilot", "CMD config.mode -> Pilot"); // locks depth and yaw where they are
+	expectReply("i", "CMD pilot.Forward @ 50.00");
+	expectReply("J", "CMD pilot.Left -> -30.00");
+	expectReply("m", "CMD pilot.Descend -> 1018.25");
+	expectReply("q", "CMD pilot.Quit -> Returning to Config mode.");
+
+	// descending at 10 mbar/s with derivative only: the depth controller steps on the MS5803's samples, every
+	// other tick, so its output holds at 10 rather than flipping between 0 and 20 tick to tick
+	expectReply("pid pressure tune 0,0,1", "CMD config.pid.pressure.tune -> p = 0.00, i = 0.00, d = 1.00");
+	float lowest = 1e9f, highest = -1e9f;
+	for(int t = 0; t < 120; ++t) {
+		depth_sensor.setPressure(1013.25f + 0.05f * t); // a tick's worth, 5 ms at 10 mbar/s
+		runFor(5);
+		if(t < 20) continue;
+		float out = pid[axis::Pressure].getOutput();
+		lowest = std::min(lowest, out);
+		highest = std::max(highest, out);
+	}
+	check(std::fabs(lowest - highest) < 1 && std::fabs(std::fabs(lowest) - 10) < 1, "depth derivative steady between samples",
+		std::to_string(lowest) + " to " + std::to_string(highest));
+	expectReply("pid pressure tune 3,0,0", "CMD config.pid.pressure.tune -> p = 3.00, i = 0.00, d = 0.00");
+
+	expectReply("stop", "CMD stop -> Made safe.");
+	runFor(100);
+	for(int pin : { PIN_THRUST_L, PIN_THRUST_R, PIN_VERT[0], PIN_VERT[1], PIN_VERT[2], PIN_VERT[3] }) {
+		check(sim::pwm(pin) == 1500, "thrusters off after stop", "pin " + std::to_string(pin) + " at " + std::to_string(sim::pwm(pin)));
+	}
+	expectReply("ESTOP", "CMD Emergency stop activated");
+
+	// the depth sensor is never read before its conversion is done
+	check(depth_sensor.earlyReads() == 0, "MS5803 read before the conversion finished", std::to_string(depth_sensor.earlyReads()) + " times");
+}
+
+// ********************************
+// Timing
+// ********************************
+
+struct Part {
+	const char* name;
+	void (*run)(void);
+	std::vector<double> host_ns;
+	std::vector<double> sim_us;
+};
+
+static double percentile(std::vector<double> v, double p) {
+	if(v.empty()) return 0;
+	std::sort(v.begin(), v.end());
+	return v[std::min(v.size() - 1, (std::size_t)(p * (v.size() - 1) + 0.5))];
+}
+
+static double mean(const std::vector<double>& v) {
+	double sum = 0;
+	for(double x : v) sum += x;
+	return v.empty() ? 0 : sum / v.size();
+}
+
+static double maximum(const std::vector<double>& v) {
+	return v.empty() ? 0 : *std::max_element(v.begin(), v.end());
+}
+
+int main(int argc, char* argv[]) {
+	int loops = 20000;
+	std::map<std::string, double> budgets;
+	for(int i = 1; i < argc; ++i) {
+		if(std::strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+			std::string spec = argv[++i];
+			std::size_t eq = spec.find('=');
+			if(eq == std::string::npos) {
+				std::printf("bad budget '%s', expected part=us\n", spec.c_str());
+				return 1;
+			}
+			budgets[spec.substr(0, eq)] = std::atof(spec.c_str() + eq + 1);
+		} else {
+			loops = std::atoi(argv[i]);
+		}
+	}
+
+	runSession();
+	std::printf("session: %s\n", failures == 0 ? "ok" : "FAILED");
+	if(failures > 0) return 1;
+
+	// the steady state on the sub: enabled, holding depth and heading, telemetry streaming
+	command("SAFE");
+	command("pid yaw tune 2,0.1,0.5");
+	command("pid pressure tune 3,0.2,1");
+	command("mode pilot");
+	command("q");
+	command("log telemetry start");
+	sim::serialOutput();
+
+	// the tick as it runs on the sub, paced by its timer with serial and logging in between
+	const int TICK_SECONDS = 10;
+	control_tick.takeStats();
+	runFor(TICK_SECONDS * 1000);
+	ControlTick::Stats ticks = control_tick.takeStats();
+	std::printf("%u ticks in %d s at %u Hz, %u missed | latency us: avg %.1f max %u | work us: avg %.0f max %u | interval us: %u - %u\n",
+		ticks.ticks, TICK_SECONDS, control_tick.getRate(), ticks.missed, (double)ticks.latency_sum / ticks.ticks, ticks.latency_max,
+		(double)ticks.work_sum / ticks.ticks, ticks.work_max, ticks.interval_min, ticks.interval_max);
+	if(ticks.missed > 0 || ticks.ticks < (unsigned)(TICK_SECONDS * control_tick.getRate() - 1)) {
+		std::printf("FAIL ticks dropped\n");
+		return 1;
+	}
+	sim::serialOutput();
+
+	std::vector<Part> parts = {
+		{ "readSensors", readSensors, {}, {} },
+		{ "readSerial", readSerial, {}, {} },
+		{ "updatePIDControllers", updatePIDControllers, {}, {} },
+		{ "updateThrusters", updateThrusters, {}, {} },
+		{ "bgLog", bgLog, {}, {} },
+		{ "loop", nullptr, {}, {} }
+	};
+	Part& whole = parts.back();
+	for(Part& p : parts) {
+		p.host_ns.reserve(loops);
+		p.sim_us.reserve(loops);
+	}
+
+	const std::uint64_t sim_start = sim::now(), blocked_start = sim::blocked();
+	const unsigned long conversions_start = depth_sensor.conversions();
+	for(int i = 0; i < loops; ++i) {
+		// something to hold on to: slow drift in depth and heading
+		depth_sensor.setPressure(1013.25f + 5 * std::sin(i * 0.001));
+		imu.setGyro(0, 0, 3 * std::cos(i * 0.002));
+
+		clock_type::time_point loop_start = clock_type::now();
+		std::uint64_t loop_sim = sim::now();
+		for(Part& p : parts) {
+			if(!p.run) continue;
+			clock_type::time_point start = clock_type::now();
+			std::uint64_t sim_before = sim::now();
+			p.run();
+			p.host_ns.push_back(std::chrono::duration<double, std::nano>(clock_type::now() - start).count());
+			p.sim_us.push_back(sim::now() - sim_before);
+		}
+		whole.host_ns.push_back(std::chrono::duration<double, std::nano>(clock_type::now() - loop_start).count());
+		whole.sim_us.push_back(sim::now() - loop_sim);
+		sim::serialOutput(); // the telemetry, nobody is reading it
+	}
+	const double sim_sec = (sim::now() - sim_start) / 1e6;
+
+	std::printf("%d loops, %.1f s simulated, %.0f Hz loop rate on the Teensy's I/O alone, %.0f%% of it in delay()\n",
+		loops, sim_sec, loops / sim_sec, 100.0 * (sim::blocked() - blocked_start) / (sim::now() - sim_start));
+	std::printf("%.0f pressure samples/s, %lu MS5803 reads before the conversion was done\n",
+		(depth_sensor.conversions() - conversions_start) / 2 / sim_sec, depth_sensor.earlyReads());
+	std::printf("%-22s %10s %10s %10s %10s   %10s %10s\n", "", "host ns", "p50", "p99", "max", "sim us", "max");
+	bool over = false;
+	for(const Part& p : parts) {
+		std::printf("%-22s %10.0f %10.0f %10.0f %10.0f   %10.1f %10.0f", p.name, mean(p.host_ns), percentile(p.host_ns, 0.5),
+			percentile(p.host_ns, 0.99), maximum(p.host_ns), mean(p.sim_us), maximum(p.sim_us));
+		auto budget = budgets.find(p.name);
+		if(budget != budgets.end()) {
+			bool ok = maximum(p.sim_us) <= budget->second;
+			std::printf("   budget %.0f %s", budget->second, ok ? "ok" : "OVER");
+			over = over || !ok;
+			budgets.erase(budget);
+		}
+		std::printf("\n");
+	}
+	for(const auto& b : budgets) {
+		std::printf("no part called %s\n", b.first.c_str());
+		over = true;
+	}
+	return over ? 1 : 0;
+}
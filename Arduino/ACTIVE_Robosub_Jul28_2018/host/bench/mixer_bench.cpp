@@ -0,0 +1,174 @@
+/*
+Checks Mixer on the firmware's matrix, then times it against the six sum and
+difference expressions updateThrusters() had before it:
+	- unsaturated, both modes give exactly what the old expressions did
+	- no power ever leaves +-100, for any demand
+	- Clip clips each thruster on its own, like BLThruster::setPower() did
+	- Priority: depth demand is never cut for attitude or surge, attitude never
+	  for surge - a group's result is the same whatever the groups after it ask
+	  for - and each group gets the largest share that fits
+
+usage: make bench, or bin/mixer_bench [mixes]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "../sketch.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static const float LIMIT = BLThruster::PWR_MAX;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	if(++failures <= 20) std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+typedef float Demand[dof::Count];
+typedef float Power[thr::Count];
+
+// the firmware's mixer as it booted, in the given mode
+static Mixer firmwareMixer(Mixer::Mode mode) {
+	float matrix[thr::Count][dof::Count];
+	for(uint8_t t = 0; t < thr::Count; ++t) {
+		for(uint8_t d = 0; d < dof::Count; ++d) matrix[t][d] = mixer.getEntry(t, d);
+	}
+	return Mixer(LIMIT, matrix, mode);
+}
+
+// updateThrusters() before the mixer, without the clipping
+static void legacyMix(const Demand& in, Power& out) {
+	out[thr::ThrustL] = in[dof::Surge] + in[dof::Yaw];
+	out[thr::ThrustR] = in[dof::Surge] - in[dof::Yaw];
+	out[thr::VertFL] = in[dof::Heave] - in[dof::Pitch] + in[dof::Roll];
+	out[thr::VertBL] = in[dof::Heave] + in[dof::Pitch] + in[dof::Roll];
+	out[thr::VertFR] = in[dof::Heave] - in[dof::Pitch] - in[dof::Roll];
+	out[thr::VertBR] = in[dof::Heave] + in[dof::Pitch] - in[dof::Roll];
+}
+
+static std::string show(const Power& p) {
+	std::string s;
+	for(uint8_t t = 0; t < thr::Count; ++t) s += std::string(t ? " " : "") + thruster_names[t] + "=" + std::to_string(p[t]);
+	return s;
+}
+
+// demands the PID limits allow: pressure and pitch +-80, roll +-30, yaw +-50, thrust_base +-100
+static void randomDemand(std::mt19937& rng, Demand& in, float spread = 1) {
+	static const float range[dof::Count] = { 80, 80, 30, 50, 100 };
+	std::uniform_real_distribution<float> u(-1, 1);
+	for(uint8_t d = 0; d < dof::Count; ++d) in[d] = spread * range[d] * u(rng);
+}
+
+static bool saturates(const Power& p) {
+	for(uint8_t t = 0; t < thr::Count; ++t) if(std::fabs(p[t]) > LIMIT) return true;
+	return false;
+}
+
+int main(int argc, char* argv[]) {
+	int mixes = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+	Mixer clip = firmwareMixer(Mixer::Clip), priority = firmwareMixer(Mixer::Priority);
+	std::mt19937 rng(2018);
+	const int CASES = 200000;
+
+	int unsaturated = 0;
+	for(int k = 0; k < CASES; ++k) {
+		Demand in;
+		randomDemand(rng, in, k % 2 ? 0.5f : 1);
+		Power legacy, c, p;
+		legacyMix(in, legacy);
+		clip.mix(in, c);
+		priority.mix(in, p);
+
+		for(uint8_t t = 0; t < thr::Count; ++t) {
+			check(std::fabs(c[t]) <= LIMIT && std::fabs(p[t]) <= LIMIT, "power within the limit", show(c) + " / " + show(p));
+			check(std::fabs(c[t] - constrain(legacy[t], -LIMIT, LIMIT)) < 1e-4f, "clip is the old mix clipped", show(c) + " vs " + show(legacy));
+		}
+
+		if(!saturates(legacy)) {
+			++unsaturated;
+			for(uint8_t t = 0; t < thr::Count; ++t) {
+				check(std::fabs(p[t] - legacy[t]) < 1e-4f, "priority is the old mix when nothing saturates", show(p) + " vs " + show(legacy));
+			}
+			for(uint8_t g = 0; g < Mixer::GROUPS; ++g) check(priority.getScale(g) == 1, "nothing scaled when nothing saturates");
+		}
+
+		// a group's share doesn't depend on what the groups after it ask for
+		float scales[Mixer::GROUPS];
+		for(uint8_t g = 0; g < Mixer::GROUPS; ++g) scales[g] = priority.getScale(g);
+		uint8_t first = 0;
+		for(uint8_t g = 0; g < Mixer::GROUPS; ++g) {
+			Demand upto;
+			for(uint8_t d = 0; d < dof::Count; ++d) upto[d] = d < Mixer::GROUP_END[g] ? in[d] : 0;
+			Power q;
+			priority.mix(upto, q);
+			for(uint8_t h = 0; h <= g; ++h) {
+				check(std::fabs(priority.getScale(h) - scales[h]) < 1e-5f, "earlier groups don't give way to later ones",
+					std::string(Mixer::GROUP_NAMES[h]) + " " + std::to_string(priority.getScale(h)) + " vs " + std::to_string(scales[h]));
+			}
+			// and a group that was scaled down has a thruster at the limit in the direction it was pushing
+			if(scales[g] < 1) {
+				bool at_limit = false;
+				for(uint8_t t = 0; t < thr::Count; ++t) {
+					float part = 0;
+					for(uint8_t d = first; d < Mixer::GROUP_END[g]; ++d) part += mixer.getEntry(t, d) * in[d];
+					if(part != 0 && std::fabs(q[t]) > LIMIT - 1e-3f && (q[t] > 0) == (part > 0)) at_limit = true;
+				}
+				check(at_limit, "a scaled down group got all the room there was", Mixer::GROUP_NAMES[g]);
+			}
+			first = Mixer::GROUP_END[g];
+		}
+	}
+
+	// the cases that motivated it
+	{
+		Demand in = { 0, 0, 0, 20, 90 }; // yaw 20 on top of thrust_base 90
+		Power c, p;
+		clip.mix(in, c);
+		priority.mix(in, p);
+		check(c[thr::ThrustL] - c[thr::ThrustR] == 30, "clip loses yaw authority", show(c));
+		check(std::fabs(p[thr::ThrustL] - p[thr::ThrustR] - 40) < 1e-4f, "priority keeps yaw authority", show(p));
+		check(std::fabs(priority.getScale(2) - 80.0f / 90) < 1e-5f, "surge backed off to 80/90", std::to_string(priority.getScale(2)));
+	}
+	{
+		Demand in = { 80, 40, 20, 0, 0 }; // deep dive while correcting pitch and roll
+		Power p;
+		priority.mix(in, p);
+		float heave = (p[thr::VertFL] + p[thr::VertBL] + p[thr::VertFR] + p[thr::VertBR]) / 4;
+		check(std::fabs(heave - 80) < 1e-4f, "priority keeps the depth demand", show(p));
+		check(priority.getScale(1) < 1 && priority.getScale(1) > 0, "and scales attitude into what's left", std::to_string(priority.getScale(1)));
+	}
+
+	std::printf("%d random demands (%d unsaturated): %s\n", CASES, unsaturated, failures == 0 ? "ok" : "FAILED");
+
+	// timing, on demands that saturate about half the time
+	static Demand inputs[1024];
+	for(Demand& in : inputs) randomDemand(rng, in);
+	volatile float sink = 0;
+	auto time = [&](const char* name, void (*fn)(Mixer*, const Demand&, Power&), Mixer* m) {
+		clock_type::time_point start = clock_type::now();
+		Power out;
+		for(int k = 0; k < mixes; ++k) {
+			fn(m, inputs[k & 1023], out);
+			sink = out[k % thr::Count];
+		}
+		std::printf("  %-28s %6.1f ns\n", name, std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / mixes);
+	};
+	std::printf("%d mixes, host ns per mix:\n", mixes);
+	time("old expressions, clipped", [](Mixer*, const Demand& in, Power& out) {
+		legacyMix(in, out);
+		for(uint8_t t = 0; t < thr::Count; ++t) out[t] = constrain(out[t], -LIMIT, LIMIT);
+	}, nullptr);
+	time("Mixer::Clip", [](Mixer* m, const Demand& in, Power& out) { m->mix(in, out); }, &clip);
+	time("Mixer::Priority", [](Mixer* m, const Demand& in, Power& out) { m->mix(in, out); }, &priority);
+	(void)sink;
+
+	return failures == 0 ? 0 : 1;
+}
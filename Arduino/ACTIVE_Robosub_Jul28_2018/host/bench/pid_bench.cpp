@@ -0,0 +1,262 @@
+/*
+Step responses of PIDCore.h against PID_v1_strang, the controller it replaces.
+Each implementation closes the loop around its own simulated plants (a mass with
+drag per axis) and the setpoints step half a second in; the trajectories and
+controller outputs have to stay within a tolerance of PID_v1_strang's, which
+runs in double:
+	float  ~ PIDBank<float, 4> and PIDCore<float>
+	q16    ~ PIDBank<q16, 4> and PIDCore<q16>, Q15.16 fixed point
+Two suites: the firmware's four controllers as it runs them (Reverse, error fed
+in as the input, one bank), and single PIDCore controllers on the options the
+firmware doesn't use (Direct, POnMeasure, setpoint and measurement fed in).
+
+Then times one step of four controllers. Host ns only compares the versions on
+this machine - the host FPU does double in hardware, the Teensy 3.5's does not.
+
+usage: make bench, or bin/pid_bench [steps]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../sketch.h"
+#include "../../PID_v1_strang.h"
+#include "../../PIDCore.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static const int AXES = 4;
+static const int PERIOD_MS = 50;
+static const int RUN_MS = 10000, STEP_AT_MS = 500;
+
+struct Axis {
+	const char* name;
+	float out_min, out_max;
+	float kp, ki, kd;
+	PIDBase::PropOn prop_on;
+	float step; // setpoint after STEP_AT_MS, 0 before
+};
+
+struct Suite {
+	const char* name;
+	PIDBase::Direction direction;
+	bool error_in; // the firmware's way: setpoint 0, input = target - measured
+	Axis axes[AXES];
+};
+
+static const Suite suites[] = {
+	{ "firmware", PIDBase::Reverse, true, {
+		{ "yaw",      -50, 50, 2, 0.1f, 0.5f, PIDBase::POnError, 30 },
+		{ "pitch",    -80, 80, 1, 0,    0.2f, PIDBase::POnError, 10 },
+		{ "roll",     -30, 30, 1, 0,    0.2f, PIDBase::POnError, -10 },
+		{ "pressure", -80, 80, 3, 0.2f, 1,    PIDBase::POnError, 20 }
+	}},
+	{ "options", PIDBase::Direct, false, {
+		{ "PI on measurement",  -100, 100, 1,     2,     0,     PIDBase::POnMeasure, 15 },
+		{ "PID on measurement", -100, 100, 1,     2,     0.1f,  PIDBase::POnMeasure, -25 },
+		{ "saturating PI",      -10,  10,  8,     2,     0,     PIDBase::POnError,   40 },
+		{ "small gains",        -1,   1,   0.05f, 0.02f, 0.02f, PIDBase::POnError,   1 }
+	}}
+};
+
+// a mass with drag pushed by the controller output
+struct Plant {
+	double x = 0, v = 0;
+	void step(double u, double dt) {
+		v += (20 * u - 8 * v) * dt;
+		x += v * dt;
+	}
+};
+
+struct Trace {
+	std::vector<double> y[AXES], u[AXES];
+};
+
+static float setpointAt(const Axis& a, int ms) {
+	return ms < STEP_AT_MS ? 0 : a.step;
+}
+
+// runs RUN_MS of 1 ms loops. in(i, measured, target) feeds controller i, compute(now) steps them,
+// out(i) reads them back
+template<typename In, typename Compute, typename Out>
+static Trace closeLoop(const Suite& s, In in, Compute compute, Out out) {
+	Trace t;
+	Plant plants[AXES];
+	for(int ms = 0; ms < RUN_MS; ++ms) {
+		for(int i = 0; i < AXES; ++i) in(i, (float)plants[i].x, setpointAt(s.axes[i], ms));
+		compute(millis());
+		for(int i = 0; i < AXES; ++i) {
+			double u = out(i);
+			plants[i].step(u, 0.001);
+			t.y[i].push_back(plants[i].x);
+			t.u[i].push_back(u);
+		}
+		sim::advance(1000);
+	}
+	return t;
+}
+
+static Trace runReference(const Suite& s) {
+	sim::reset(); // PID_v1_strang reads millis() itself
+	std::vector<PID> pids;
+	for(const Axis& a : s.axes) {
+		pids.push_back(PID(a.out_min, a.out_max, PERIOD_MS, (PID::Direction)s.direction, (PID::PropOn)a.prop_on));
+	}
+	// tuned after construction like the firmware does: PID_v1_strang's constructor applies the
+	// tunings before it has set the direction, so gains passed to it can come out with either sign
+	for(int i = 0; i < AXES; ++i) {
+		pids[i].setTunings(s.axes[i].kp, s.axes[i].ki, s.axes[i].kd);
+		pids[i].setMode(PID::Automatic);
+	}
+	return closeLoop(s,
+		[&](int i, float measured, float target) {
+			if(s.error_in) { pids[i].setSetpoint(0); pids[i].setInput(target - measured); }
+			else { pids[i].setSetpoint(target); pids[i].setInput(measured); }
+		},
+		[&](uint32_t) { for(PID& p : pids) p.compute(); },
+		[&](int i) { return pids[i].getOutput(); });
+}
+
+template<typename T>
+static Trace runBank(const Suite& s) {
+	sim::reset();
+	PIDBase::Limits limits[AXES];
+	for(int i = 0; i < AXES; ++i) limits[i] = { s.axes[i].out_min, s.axes[i].out_max };
+	PIDBank<T, AXES> bank(PERIOD_MS, s.direction, limits);
+	for(int i = 0; i < AXES; ++i) {
+		bank[i].setTunings(s.axes[i].kp, s.axes[i].ki, s.axes[i].kd, s.axes[i].prop_on);
+		bank[i].setMode(PIDBase::Automatic);
+	}
+	return closeLoop(s,
+		[&](int i, float measured, float target) {
+			if(s.error_in) { bank[i].setSetpoint(T(0)); bank[i].setInput(T(target - measured)); }
+			else { bank[i].setSetpoint(T(target)); bank[i].setInput(T(measured)); }
+		},
+		[&](uint32_t now) { bank.compute(now); },
+		[&](int i) { return toFloat(bank[i].getOutput()); });
+}
+
+template<typename T>
+static Trace runCore(const Suite& s) {
+	sim::reset();
+	std::vector<PIDCore<T>> pids;
+	for(const Axis& a : s.axes) {
+		pids.push_back(PIDCore<T>(a.out_min, a.out_max, PERIOD_MS, s.direction, a.prop_on, a.kp, a.ki, a.kd));
+	}
+	for(PIDCore<T>& p : pids) p.setMode(PIDBase::Automatic);
+	return closeLoop(s,
+		[&](int i, float measured, float target) {
+			if(s.error_in) { pids[i].setSetpoint(T(0)); pids[i].setInput(T(target - measured)); }
+			else { pids[i].setSetpoint(T(target)); pids[i].setInput(T(measured)); }
+		},
+		[&](uint32_t now) { for(PIDCore<T>& p : pids) p.compute(now); },
+		[&](int i) { return toFloat(pids[i].getOutput()); });
+}
+
+// overshoot past the step in % of it, and the time it takes to stay within 2% of it
+static void response(const std::vector<double>& y, float step, double& overshoot, int& settle_ms) {
+	double peak = 0;
+	settle_ms = STEP_AT_MS;
+	for(int ms = STEP_AT_MS; ms < (int)y.size(); ++ms) {
+		peak = std::max(peak, y[ms] / step);
+		if(std::fabs(y[ms] - step) > 0.02 * std::fabs(step)) settle_ms = ms + 1;
+	}
+	overshoot = 100 * std::max(0.0, peak - 1);
+	settle_ms -= STEP_AT_MS;
+}
+
+static int failures = 0;
+
+// worst difference from the reference over the run, the trajectory in fractions of the step and
+// the output in fractions of its range
+static void compare(const char* impl, const Suite& s, const Trace& ref, const Trace& t, double tolerance) {
+	for(int i = 0; i < AXES; ++i) {
+		const Axis& a = s.axes[i];
+		double dy = 0, du = 0;
+		for(std::size_t k = 0; k < ref.y[i].size(); ++k) {
+			dy = std::max(dy, std::fabs(t.y[i][k] - ref.y[i][k]) / std::fabs(a.step));
+			du = std::max(du, std::fabs(t.u[i][k] - ref.u[i][k]) / (a.out_max - a.out_min));
+		}
+		double overshoot; int settle_ms;
+		response(t.y[i], a.step, overshoot, settle_ms);
+		bool ok = dy <= tolerance && du <= tolerance;
+		std::printf("  %-14s %-20s %7.1f%% %8d ms   %10.2e %10.2e %s\n", impl, a.name, overshoot, settle_ms, dy, du, ok ? "" : "FAIL");
+		if(!ok) ++failures;
+	}
+}
+
+template<typename Fn>
+static double timeSteps(int steps, Fn step) {
+	clock_type::time_point start = clock_type::now();
+	for(int k = 0; k < steps; ++k) {
+		sim::advance(PERIOD_MS * 1000); // every call has a step due
+		step(millis());
+	}
+	return std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / steps;
+}
+
+int main(int argc, char* argv[]) {
+	int steps = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+	// float is held to what float can do over 10 s of integrating. q16 rounds the gains to 1/65536,
+	// which is ~1.5% of a Ki * period as small as "small gains" 0.001 - the worst case, at ~4e-3
+	const double TOL_FLOAT = 1e-4, TOL_Q16 = 5e-3;
+
+	for(const Suite& s : suites) {
+		std::printf("%s: step at %d ms, worst difference from PID_v1_strang over %d ms\n", s.name, STEP_AT_MS, RUN_MS);
+		std::printf("  %-14s %-20s %8s %11s   %10s %10s\n", "", "", "overshoot", "settle 2%", "trajectory", "output");
+		Trace ref = runReference(s);
+		compare("PID_v1_strang", s, ref, ref, 0);
+		compare("bank float", s, ref, runBank<float>(s), TOL_FLOAT);
+		compare("bank q16", s, ref, runBank<q16>(s), TOL_Q16);
+		compare("core float", s, ref, runCore<float>(s), TOL_FLOAT);
+		compare("core q16", s, ref, runCore<q16>(s), TOL_Q16);
+	}
+	std::printf("step responses: %s\n", failures == 0 ? "ok" : "FAILED");
+
+	// one step of the firmware's four controllers, inputs moving so nothing is constant folded
+	const Suite& fw = suites[0];
+	sim::reset();
+	std::vector<PID> legacy;
+	for(const Axis& a : fw.axes) legacy.push_back(PID(a.out_min, a.out_max, PERIOD_MS, PID::Reverse));
+	for(int i = 0; i < AXES; ++i) {
+		legacy[i].setTunings(fw.axes[i].kp, fw.axes[i].ki, fw.axes[i].kd);
+		legacy[i].setMode(PID::Automatic);
+	}
+	PIDBase::Limits limits[AXES];
+	for(int i = 0; i < AXES; ++i) limits[i] = { fw.axes[i].out_min, fw.axes[i].out_max };
+	PIDBank<float, AXES> bank_f(PERIOD_MS, PIDBase::Reverse, limits);
+	PIDBank<q16, AXES> bank_q(PERIOD_MS, PIDBase::Reverse, limits);
+	for(int i = 0; i < AXES; ++i) {
+		bank_f[i].setTunings(fw.axes[i].kp, fw.axes[i].ki, fw.axes[i].kd);
+		bank_q[i].setTunings(fw.axes[i].kp, fw.axes[i].ki, fw.axes[i].kd);
+		bank_f[i].setMode(PIDBase::Automatic);
+		bank_q[i].setMode(PIDBase::Automatic);
+	}
+	volatile float sink = 0;
+	int k = 0;
+	double ns_legacy = timeSteps(steps, [&](uint32_t) {
+		for(int i = 0; i < AXES; ++i) legacy[i].setInput(std::sin(++k * 0.01));
+		for(PID& p : legacy) p.compute();
+		sink = legacy[0].getOutput();
+	});
+	double ns_f = timeSteps(steps, [&](uint32_t now) {
+		for(int i = 0; i < AXES; ++i) bank_f[i].setInput(std::sin(++k * 0.01f));
+		bank_f.compute(now);
+		sink = bank_f[0].getOutput();
+	});
+	double ns_q = timeSteps(steps, [&](uint32_t now) {
+		for(int i = 0; i < AXES; ++i) bank_q[i].setInput(q16(std::sin(++k * 0.01f)));
+		bank_q.compute(now);
+		sink = toFloat(bank_q[0].getOutput());
+	});
+	(void)sink;
+	std::printf("%d steps of 4 controllers, host ns per step (sin() for the inputs included):\n", steps);
+	std::printf("  PID_v1_strang (double) %8.1f\n  PIDBank<float, 4>      %8.1f\n  PIDBank<q16, 4>        %8.1f\n", ns_legacy, ns_f, ns_q);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+Checks the binary telemetry frames (Telemetry.h) coming out of the firmware while
+it holds depth and heading:
+	- one frame per control tick, seq counting up by one, time_ms a tick apart
+	- every frame has the right header and CRC, and the text replies sent in
+	  between them are intact and stay 7 bit
+	- the last frame carries the controller outputs and thruster powers the
+	  firmware ended on
+	- with the USB buffer full frames are dropped, not waited for, and the gap in
+	  seq is exactly the ticks that went by
+Then times sendTelemetry() and prints the link bandwidth the frames take.
+
+usage: make bench, or bin/telemetry_bench [frames]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../sketch.h"
+#include "../sim/MS5803Model.h"
+#include "../sim/MPU6050Model.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static sim::MS5803Model depth_sensor;
+static sim::MPU6050Model imu;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	++failures;
+	std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+static const unsigned IDLE_US = 5; // see loop_bench
+
+static void loopOnce(void) {
+	std::uint64_t before = sim::now();
+	loop();
+	if(sim::now() == before) sim::advance(IDLE_US);
+}
+
+static void runFor(unsigned ms) {
+	std::uint64_t until = sim::now() + (std::uint64_t)ms * 1000;
+	while(sim::now() < until) loopOnce();
+}
+
+static std::string command(const std::string& line) {
+	sim::serialInput(line + "\n");
+	while(sim::serialPending() > 0) loopOnce();
+	loopOnce();
+	return sim::serialOutput();
+}
+
+// the serial stream pulled apart the way Brain's USBSerialLink does it
+struct Stream {
+	std::vector<Telemetry::Frame> frames;
+	std::string text;
+	int bad = 0; // sync bytes that didn't start a good frame
+};
+
+static Stream split(const std::string& out) {
+	Stream s;
+	std::size_t i = 0;
+	while(i < out.size()) {
+		if((std::uint8_t)out[i] != Telemetry::SYNC0) {
+			s.text += out[i++];
+			continue;
+		}
+		Telemetry::Frame f;
+		if(out.size() - i < Telemetry::SIZE) {
+			++s.bad;
+			break;
+		}
+		std::memcpy(&f, out.data() + i, Telemetry::SIZE);
+		if(f.sync[1] != Telemetry::SYNC1 || f.version != Telemetry::VERSION || f.length != Telemetry::SIZE
+			|| f.crc != Telemetry::crc16((const std::uint8_t*)out.data() + i, Telemetry::SIZE - 2)) {
+			++s.bad;
+			++i;
+			continue;
+		}
+		s.frames.push_back(f);
+		i += Telemetry::SIZE;
+	}
+	return s;
+}
+
+int main(int argc, char* argv[]) {
+	int timed = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+	// check value from the CRC-16/CCITT-FALSE catalogue, Brain checks its decoder against the same one
+	check(Telemetry::crc16((const std::uint8_t*)"123456789", 9) == 0x29B1, "crc16 check value");
+
+	depth_sensor.setPressure(1013.25f);
+	depth_sensor.setTemperature(21);
+	sim::setAnalog(22, 4095);
+	setup();
+	runFor(100);
+	command("SAFE");
+	command("pid yaw tune 2,0.1,0");
+	command("pid pressure tune 3,0.2,0");
+	command("mode pilot");
+	command("q");
+	command("thrust 30");
+	depth_sensor.setPressure(1008.25f); // 5 mbar shallow, so the depth controller has something to say
+	imu.setGyro(0, 0, 2);
+	sim::serialOutput();
+
+	// streaming, with a command in the middle
+	const unsigned SECONDS = 2;
+	std::string out = command("log telemetry start");
+	control_tick.takeStats();
+	runFor(SECONDS * 500);
+	sim::serialInput("pid pressure read\n");
+	runFor(SECONDS * 500);
+	ControlTick::Stats ticks = control_tick.takeStats();
+	out += sim::serialOutput();
+
+	Stream s = split(out);
+	check(s.bad == 0, "frames with a bad header or CRC", std::to_string(s.bad));
+	check(s.frames.size() == ticks.ticks, "a frame every tick", std::to_string(s.frames.size()) + " frames, " + std::to_string(ticks.ticks) + " ticks");
+	const std::uint32_t period_ms = 1000 / control_tick.getRate();
+	for(std::size_t k = 1; k < s.frames.size(); ++k) {
+		const Telemetry::Frame& a = s.frames[k - 1];
+		const Telemetry::Frame& b = s.frames[k];
+		if(b.seq != a.seq + 1) check(false, "seq counts up by one", std::to_string(a.seq) + " then " + std::to_string(b.seq));
+		std::uint32_t dt = b.time_ms - a.time_ms;
+		if(dt + 1 < period_ms || dt > period_ms + 1) check(false, "frames a tick apart", std::to_string(dt) + " ms");
+	}
+	check(s.text.find("CMD config.log.telemetry.start -> Logging for telemetry enabled.") != std::string::npos, "start reply", s.text);
+	check(s.text.find("CMD config.pid.pressure.read: ") != std::string::npos, "reply in between frames", s.text);
+	bool seven_bit = true;
+	for(char c : s.text) seven_bit = seven_bit && (std::uint8_t)c < 0x80;
+	check(seven_bit, "text stays 7 bit, so a sync byte is always a frame");
+
+	if(!s.frames.empty()) {
+		const Telemetry::Frame& last = s.frames.back();
+		for(std::uint8_t i = 0; i < axis::Count; ++i) {
+			check(last.pid_out[i] == pid[i].getOutput(), "last frame has the PID outputs", axis_names[i]);
+			check(((last.pid_auto >> i) & 1) == (pid[i].getMode() == PIDBase::Automatic), "last frame has the PID modes", axis_names[i]);
+		}
+		for(std::uint8_t i = 0; i < thr::Count; ++i) {
+			check(last.power[i] == thrusters[i].getPower(), "last frame has the thruster powers", thruster_names[i]);
+		}
+		check(last.pressure > 1008 && last.pressure < 1008.5f, "pressure", std::to_string(last.pressure));
+		check(last.power[thr::VertFL] != 0 && last.pid_out[axis::Pressure] != 0, "depth correction shows up");
+		check(last.kill_adc == 4095, "kill switch", std::to_string(last.kill_adc));
+		int fresh = 0;
+		for(const Telemetry::Frame& f : s.frames) fresh += (f.flags & Telemetry::FRESH_PRESSURE) != 0;
+		check(fresh > 0 && fresh < (int)s.frames.size(), "FRESH_PRESSURE on the ticks with a new sample", std::to_string(fresh));
+	}
+
+	// nobody reading: the USB buffer fills and frames are dropped without holding the tick up
+	std::uint32_t seq_before = s.frames.empty() ? 0 : s.frames.back().seq;
+	sim::setSerialRoom(Telemetry::SIZE - 1);
+	control_tick.takeStats();
+	runFor(200);
+	ControlTick::Stats blocked = control_tick.takeStats();
+	sim::setSerialRoom(sim::SERIAL_ROOM);
+	check(split(sim::serialOutput()).frames.empty(), "nothing sent with the buffer full");
+	check(blocked.missed == 0, "no ticks missed with the buffer full", std::to_string(blocked.missed));
+	runFor(20);
+	Stream after = split(sim::serialOutput());
+	check(!after.frames.empty() && after.frames.front().seq == seq_before + blocked.ticks + 1, "the gap in seq is the frames dropped",
+		after.frames.empty() ? "no frames" : std::to_string(after.frames.front().seq - seq_before - 1) + " vs " + std::to_string(blocked.ticks));
+
+	std::printf("%zu frames in %u s at %u Hz, %u dropped while the buffer was full: %s\n", s.frames.size(), SECONDS,
+		control_tick.getRate(), blocked.ticks, failures == 0 ? "ok" : "FAILED");
+
+	// cost of a frame, building it and the CRC - the write goes to the simulated port
+	const unsigned rate = control_tick.getRate();
+	control_tick.end();
+	clock_type::time_point start = clock_type::now();
+	for(int k = 0; k < timed; ++k) {
+		sendTelemetry();
+		if(k % 1024 == 0) sim::serialOutput();
+	}
+	double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / timed;
+	std::printf("sendTelemetry(): %.0f host ns per frame, %u bytes per frame, %.1f kB/s at %u Hz\n",
+		ns, Telemetry::SIZE, Telemetry::SIZE * rate / 1000.0, rate);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include "Arduino.h"
+
+#include <cctype>
+#include <cstdio>
+
+SimSerial Serial;
+
+// ********************************
+// String
+// ********************************
+
+namespace {
+	std::string toBase(unsigned long value, unsigned char base) {
+		if(base < 2 || base > 16) base = 10;
+		char digits[sizeof(unsigned long) * 8 + 1];
+		int i = sizeof(digits);
+		do {
+			digits[--i] = "0123456789ABCDEF"[value % base];
+			value /= base;
+		} while(value > 0);
+		return std::string(digits + i, sizeof(digits) - i);
+	}
+
+	std::string toSignedBase(long value, unsigned char base) {
+		// like the Teensy core, only base 10 gets a sign, the others print the two's complement bits
+		if(base == 10 && value < 0) return "-" + toBase(0UL - (unsigned long)value, base);
+		return toBase((unsigned long)value, base);
+	}
+
+	std::string toFixed(double value, unsigned char decimal_places) {
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "%.*f", (int)decimal_places, value);
+		return buffer;
+	}
+}
+
+String::String(unsigned char value, unsigned char base) : s(toBase(value, base)) {}
+String::String(int value, unsigned char base) : s(base == 10 ? toSignedBase(value, base) : toBase((unsigned int)value, base)) {}
+String::String(unsigned int value, unsigned char base) : s(toBase(value, base)) {}
+String::String(long value, unsigned char base) : s(toSignedBase(value, base)) {}
+String::String(unsigned long value, unsigned char base) : s(toBase(value, base)) {}
+String::String(float value, unsigned char decimal_places) : s(toFixed(value, decimal_places)) {}
+String::String(double value, unsigned char decimal_places) : s(toFixed(value, decimal_places)) {}
+
+bool String::equalsIgnoreCase(const String& other) const {
+	if(s.size() != other.s.size()) return false;
+	for(std::size_t i = 0; i < s.size(); ++i) {
+		if(std::tolower((unsigned char)s[i]) != std::tolower((unsigned char)other.s[i])) return false;
+	}
+	return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+	return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+}
+
+String String::substring(unsigned int begin, unsigned int end) const {
+	// Arduino swaps the ends if they're given backwards and clamps them to the length
+	if(begin > end) std::swap(begin, end);
+	if(begin >= s.size()) return String();
+	if(end > s.size()) end = s.size();
+	return String(s.substr(begin, end - begin));
+}
+
+void String::trim(void) {
+	std::size_t first = 0, last = s.size();
+	while(first < last && std::isspace((unsigned char)s[first])) ++first;
+	while(last > first && std::isspace((unsigned char)s[last - 1])) --last;
+	s = s.substr(first, last - first);
+}
+
+void String::toLowerCase(void) {
+	for(char& c : s) c = std::tolower((unsigned char)c);
+}
+
+void String::toUpperCase(void) {
+	for(char& c : s) c = std::toupper((unsigned char)c);
+}
+
+// ********************************
+// Print
+// ********************************
+
+std::size_t Print::printNumber(unsigned long value, int base) {
+	if(base < 2 || base > 16) base = 10;
+	char digits[sizeof(unsigned long) * 8];
+	int i = sizeof(digits);
+	do {
+		digits[--i] = "0123456789ABCDEF"[value % base];
+		value /= base;
+	} while(value > 0);
+	return write((const std::uint8_t*)digits + i, sizeof(digits) - i);
+}
+
+std::size_t Print::printSigned(long value) {
+	if(value >= 0) return printNumber(value, DEC);
+	return print('-') + printNumber(0UL - (unsigned long)value, DEC);
+}
+
+std::size_t Print::print(double value, int digits) {
+	char buffer[64];
+	int n = std::snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+	return write((const std::uint8_t*)buffer, n < (int)sizeof(buffer) ? n : sizeof(buffer) - 1);
+}
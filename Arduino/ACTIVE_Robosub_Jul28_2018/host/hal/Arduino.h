@@ -0,0 +1,212 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+Host stand-in for the part of the Arduino/Teensyduino core the firmware uses.
+Along with Wire.h, Servo.h, IntervalTimer.h, ArduinoSTL.h and MPU6050_tockn.h in this directory
+it is the hardware abstraction layer of the host build: the firmware sources
+compile unchanged against it, and everything that would touch hardware goes to
+the simulation in host/sim/Sim.h instead.
+
+Behaviour follows the Teensy core where the firmware can tell the difference -
+String formats floats with 2 decimals, millis() and micros() wrap at 32 bits,
+constrain() is a macro and map() works in long. String keeps its characters on
+the heap however short they are and Print formats numbers without one, so a
+host program counting allocations sees the ones the firmware would make.
+*/
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+
+#include "../sim/Sim.h"
+
+#ifndef ARDUINO
+#define ARDUINO 10805
+#endif
+
+typedef std::uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define F(string_literal) (string_literal)
+
+using std::abs;
+
+// ********************************
+// Time and pins
+// ********************************
+
+inline std::uint32_t millis(void) { return (std::uint32_t)(sim::now() / 1000); }
+inline std::uint32_t micros(void) { return (std::uint32_t)sim::now(); }
+inline void delay(std::uint32_t ms) { sim::block((std::uint64_t)ms * 1000); }
+inline void delayMicroseconds(std::uint32_t us) { sim::block(us); }
+
+// the simulation holds timer interrupts while they are off
+inline void noInterrupts(void) { sim::setInterrupts(false); }
+inline void interrupts(void) { sim::setInterrupts(true); }
+
+inline void pinMode(std::uint8_t, std::uint8_t) {}
+inline void digitalWrite(std::uint8_t pin, std::uint8_t value) { sim::setDigital(pin, value); }
+inline int digitalRead(std::uint8_t pin) { return sim::digital(pin); }
+inline int analogRead(std::uint8_t pin) {
+	sim::advance(sim::ANALOG_READ_US);
+	return sim::analog(pin);
+}
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+	return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// ********************************
+// String
+// ********************************
+
+class String {
+public:
+	String(const char* cstr = "") : s(cstr ? cstr : "") { onHeap(); }
+	String(const String& other) : s(other.s) { onHeap(); }
+	String(String&& other) : s(std::move(other.s)) { onHeap(); }
+	explicit String(const std::string& str) : s(str) { onHeap(); }
+	// not explicit, as on the Teensy
+	String(char c) : s(1, c) { onHeap(); }
+	String(unsigned char value, unsigned char base = 10);
+	String(int value, unsigned char base = 10);
+	String(unsigned int value, unsigned char base = 10);
+	String(long value, unsigned char base = 10);
+	String(unsigned long value, unsigned char base = 10);
+	String(float value, unsigned char decimal_places = 2);
+	String(double value, unsigned char decimal_places = 2);
+
+	String& operator=(const String& other) = default;
+	String& operator=(String&& other) = default;
+	String& operator=(const char* cstr) { s = (cstr ? cstr : ""); return *this; }
+
+	unsigned int length(void) const { return s.size(); }
+	const char* c_str(void) const { return s.c_str(); }
+	void reserve(unsigned int size) { s.reserve(size); }
+
+	bool concat(const String& other) { s += other.s; return true; }
+	String& operator+=(const String& other) { s += other.s; return *this; }
+	String& operator+=(const char* cstr) { s += cstr; return *this; }
+	String& operator+=(char c) { s += c; return *this; }
+	template<typename T> String& operator+=(T value) { s += String(value).s; return *this; }
+
+	bool equals(const String& other) const { return s == other.s; }
+	bool equalsIgnoreCase(const String& other) const;
+	int compareTo(const String& other) const { return s.compare(other.s); }
+	bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+	bool endsWith(const String& suffix) const;
+
+	char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+	char operator[](unsigned int i) const { return charAt(i); }
+	char& operator[](unsigned int i) { return s[i]; }
+
+	int indexOf(char c, unsigned int from = 0) const { return found(s.find(c, from)); }
+	int indexOf(const String& str, unsigned int from = 0) const { return found(s.find(str.s, from)); }
+	int lastIndexOf(char c) const { return found(s.rfind(c)); }
+	int lastIndexOf(const String& str) const { return found(s.rfind(str.s)); }
+
+	String substring(unsigned int begin) const { return substring(begin, s.size()); }
+	String substring(unsigned int begin, unsigned int end) const;
+
+	void trim(void);
+	void toLowerCase(void);
+	void toUpperCase(void);
+	void remove(unsigned int index, unsigned int count = (unsigned int)-1) { if(index < s.size()) s.erase(index, count); }
+
+	long toInt(void) const { return std::atol(s.c_str()); }
+	float toFloat(void) const { return (float)std::atof(s.c_str()); }
+
+	friend bool operator==(const String& a, const String& b) { return a.s == b.s; }
+	friend bool operator!=(const String& a, const String& b) { return a.s != b.s; }
+	friend bool operator<(const String& a, const String& b) { return a.s < b.s; }
+	friend bool operator>(const String& a, const String& b) { return a.s > b.s; }
+
+private:
+	static int found(std::size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+	// the Teensy's String allocates for anything, std::string would keep up to 15 chars inline
+	void onHeap(void) { if(s.capacity() < 16) s.reserve(16); }
+	std::string s;
+};
+
+// Arduino's StringSumHelper, the right hand side is appended the way String(rhs) would print it
+inline String operator+(const String& lhs, const String& rhs) { String out(lhs); out += rhs; return out; }
+inline String operator+(const String& lhs, const char* rhs) { String out(lhs); out += rhs; return out; }
+inline String operator+(const char* lhs, const String& rhs) { String out(lhs); out += rhs; return out; }
+inline String operator+(const String& lhs, char rhs) { String out(lhs); out += rhs; return out; }
+template<typename T> String operator+(const String& lhs, T rhs) { String out(lhs); out += String(rhs); return out; }
+
+// ********************************
+// Print and Serial
+// ********************************
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual std::size_t write(std::uint8_t b) { return write(&b, 1); }
+	virtual std::size_t write(const std::uint8_t* buffer, std::size_t size) = 0;
+	std::size_t write(const char* str) { return write((const std::uint8_t*)str, std::strlen(str)); }
+
+	std::size_t print(const char* str) { return write(str); }
+	std::size_t print(const String& str) { return write((const std::uint8_t*)str.c_str(), str.length()); }
+	std::size_t print(char c) { return write((std::uint8_t)c); }
+	// formatted the way String would, on the stack as the Teensy's Print does
+	std::size_t print(unsigned char value, int base = DEC) { return printNumber(value, base); }
+	std::size_t print(int value, int base = DEC) { return base == DEC ? printSigned(value) : printNumber((unsigned int)value, base); }
+	std::size_t print(unsigned int value, int base = DEC) { return printNumber(value, base); }
+	std::size_t print(long value, int base = DEC) { return base == DEC ? printSigned(value) : printNumber((unsigned long)value, base); }
+	std::size_t print(unsigned long value, int base = DEC) { return printNumber(value, base); }
+	std::size_t print(double value, int digits = 2);
+
+	std::size_t println(void) { return write("\r\n"); }
+	template<typename T> std::size_t println(const T& value) { return print(value) + println(); }
+	template<typename T> std::size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+private:
+	std::size_t printNumber(unsigned long value, int base);
+	std::size_t printSigned(long value);
+};
+
+// the Teensy's USB serial, reading from and writing to the simulated port
+class SimSerial : public Print {
+public:
+	void begin(unsigned long) {}
+	bool dtr(void) { return true; }
+	explicit operator bool() { return true; }
+
+	int available(void) { return (int)sim::serialPending(); }
+	int availableForWrite(void) { return sim::serialRoom(); }
+	int read(void) { return sim::serialRead(); }
+	void flush(void) {}
+
+	using Print::write;
+	std::size_t write(const std::uint8_t* buffer, std::size_t size) override {
+		sim::serialWrite(buffer, size);
+		return size;
+	}
+};
+
+extern SimSerial Serial;
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef HOST_ARDUINO_STL_H
+#define HOST_ARDUINO_STL_H
+
+// ArduinoSTL brings the standard library to the Teensy, the host already has it
+#include <vector>
+#include <map>
+
+#endif
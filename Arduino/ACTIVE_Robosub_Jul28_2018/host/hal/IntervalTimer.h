@@ -0,0 +1,28 @@
+#ifndef HOST_INTERVAL_TIMER_H
+#define HOST_INTERVAL_TIMER_H
+
+#include "Arduino.h"
+
+// host stand-in for the Teensy's IntervalTimer, a timer in the simulation that calls the function
+// as the simulated clock passes each period (sim::startTimer)
+class IntervalTimer {
+public:
+	IntervalTimer() : id(-1) {}
+	~IntervalTimer() { end(); }
+
+	bool begin(void (*funct)(void), unsigned int microseconds) {
+		end();
+		id = sim::startTimer(microseconds, funct);
+		return id >= 0;
+	}
+	void end(void) {
+		if(id >= 0) sim::stopTimer(id);
+		id = -1;
+	}
+	void priority(std::uint8_t) {}
+
+private:
+	int id;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "MPU6050_tockn.h"
+
+namespace {
+	const byte SMPLRT_DIV = 0x19;
+	const byte CONFIG = 0x1A;
+	const byte GYRO_CONFIG = 0x1B;
+	const byte ACCEL_CONFIG = 0x1C;
+	const byte PWR_MGMT_1 = 0x6B;
+	const byte ACCEL_XOUT_H = 0x3B;
+	const byte GYRO_XOUT_H = 0x43;
+
+	const float ACCEL_LSB = 16384.0f; // +-2 g
+	const float GYRO_LSB = 65.5f; // +-500 degrees/s
+}
+
+MPU6050::MPU6050(TwoWire& w, float _acc_coef, float _gyro_coef) : wire(&w), acc_coef(_acc_coef), gyro_coef(_gyro_coef),
+	raw_acc_x(0), raw_acc_y(0), raw_acc_z(0), raw_temp(0), raw_gyro_x(0), raw_gyro_y(0), raw_gyro_z(0),
+	gyro_x_offset(0), gyro_y_offset(0), gyro_z_offset(0),
+	temp(0), acc_x(0), acc_y(0), acc_z(0), gyro_x(0), gyro_y(0), gyro_z(0),
+	angle_gyro_x(0), angle_gyro_y(0), angle_gyro_z(0), angle_acc_x(0), angle_acc_y(0),
+	angle_x(0), angle_y(0), angle_z(0), interval(0), pre_interval(0) {}
+
+void MPU6050::begin(void) {
+	writeMPU6050(SMPLRT_DIV, 0x00);
+	writeMPU6050(CONFIG, 0x00);
+	writeMPU6050(GYRO_CONFIG, 0x08);
+	writeMPU6050(ACCEL_CONFIG, 0x00);
+	writeMPU6050(PWR_MGMT_1, 0x01);
+	update();
+	angle_gyro_x = 0;
+	angle_gyro_y = 0;
+	angle_x = getAccAngleX();
+	angle_y = getAccAngleY();
+	pre_interval = millis();
+}
+
+void MPU6050::writeMPU6050(byte reg, byte data) {
+	wire->beginTransmission(ADDRESS);
+	wire->write(reg);
+	wire->write(data);
+	wire->endTransmission();
+}
+
+byte MPU6050::readMPU6050(byte reg) {
+	wire->beginTransmission(ADDRESS);
+	wire->write(reg);
+	wire->endTransmission(true);
+	wire->requestFrom(ADDRESS, 1);
+	return wire->read();
+}
+
+void MPU6050::calcGyroOffsets(bool console, std::uint16_t delay_before, std::uint16_t delay_after) {
+	float x = 0, y = 0, z = 0;
+	std::int16_t rx, ry, rz;
+
+	delay(delay_before);
+	if(console) Serial.println("Calculating gyro offsets, DO NOT MOVE MPU6050");
+	for(int i = 0; i < 3000; i++) {
+		wire->beginTransmission(ADDRESS);
+		wire->write(GYRO_XOUT_H);
+		wire->endTransmission(false);
+		wire->requestFrom(ADDRESS, 6);
+
+		rx = readWord();
+		ry = readWord();
+		rz = readWord();
+
+		x += ((float)rx) / GYRO_LSB;
+		y += ((float)ry) / GYRO_LSB;
+		z += ((float)rz) / GYRO_LSB;
+	}
+	gyro_x_offset = x / 3000;
+	gyro_y_offset = y / 3000;
+	gyro_z_offset = z / 3000;
+	if(console) Serial.println("Done!");
+	delay(delay_after);
+}
+
+// the library reads a word as wire->read() << 8 | wire->read(), which leaves the order of the reads to the compiler
+std::int16_t MPU6050::readWord(void) {
+	int high = wire->read();
+	return (std::int16_t)((high << 8) | wire->read());
+}
+
+void MPU6050::update(void) {
+	wire->beginTransmission(ADDRESS);
+	wire->write(ACCEL_XOUT_H);
+	wire->endTransmission(false);
+	wire->requestFrom(ADDRESS, 14);
+
+	raw_acc_x = readWord();
+	raw_acc_y = readWord();
+	raw_acc_z = readWord();
+	raw_temp = readWord();
+	raw_gyro_x = readWord();
+	raw_gyro_y = readWord();
+	raw_gyro_z = readWord();
+
+	temp = (raw_temp + 12412.0) / 340.0;
+
+	acc_x = ((float)raw_acc_x) / ACCEL_LSB;
+	acc_y = ((float)raw_acc_y) / ACCEL_LSB;
+	acc_z = ((float)raw_acc_z) / ACCEL_LSB;
+
+	angle_acc_x = atan2(acc_y, sqrt(acc_z * acc_z + acc_x * acc_x)) * 360 / 2.0 / PI;
+	angle_acc_y = atan2(acc_x, sqrt(acc_z * acc_z + acc_y * acc_y)) * 360 / -2.0 / PI;
+
+	gyro_x = ((float)raw_gyro_x) / GYRO_LSB - gyro_x_offset;
+	gyro_y = ((float)raw_gyro_y) / GYRO_LSB - gyro_y_offset;
+	gyro_z = ((float)raw_gyro_z) / GYRO_LSB - gyro_z_offset;
+
+	interval = (millis() - pre_interval) * 0.001;
+
+	angle_gyro_x += gyro_x * interval;
+	angle_gyro_y += gyro_y * interval;
+	angle_gyro_z += gyro_z * interval;
+
+	angle_x = (gyro_coef * (angle_x + gyro_x * interval)) + (acc_coef * angle_acc_x);
+	angle_y = (gyro_coef * (angle_y + gyro_y * interval)) + (acc_coef * angle_acc_y);
+	angle_z = angle_gyro_z;
+
+	pre_interval = millis();
+}
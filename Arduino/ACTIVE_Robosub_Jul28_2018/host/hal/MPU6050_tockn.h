@@ -0,0 +1,74 @@
+#ifndef HOST_MPU6050_TOCKN_H
+#define HOST_MPU6050_TOCKN_H
+
+#include "Arduino.h"
+#include "Wire.h"
+
+/*
+Host stand-in for the MPU6050_tockn library with the same interface and the
+same math: it talks to the sensor through Wire (sim::MPU6050Model answers on
+the host) and runs the library's complementary filter, 98% integrated gyro and
+2% accelerometer angle for x and y, integrated gyro alone for z.
+*/
+
+class MPU6050 {
+public:
+	MPU6050(TwoWire& w) : MPU6050(w, 0.02f, 0.98f) {}
+	MPU6050(TwoWire& w, float acc_coef, float gyro_coef);
+
+	void begin(void);
+	void calcGyroOffsets(bool console = false, std::uint16_t delay_before = 1000, std::uint16_t delay_after = 3000);
+	void setGyroOffsets(float x, float y, float z) { gyro_x_offset = x; gyro_y_offset = y; gyro_z_offset = z; }
+	float getGyroXoffset(void) { return gyro_x_offset; }
+	float getGyroYoffset(void) { return gyro_y_offset; }
+	float getGyroZoffset(void) { return gyro_z_offset; }
+
+	void update(void);
+
+	void writeMPU6050(byte reg, byte data);
+	byte readMPU6050(byte reg);
+
+	std::int16_t getRawAccX(void) { return raw_acc_x; }
+	std::int16_t getRawAccY(void) { return raw_acc_y; }
+	std::int16_t getRawAccZ(void) { return raw_acc_z; }
+	std::int16_t getRawTemp(void) { return raw_temp; }
+	std::int16_t getRawGyroX(void) { return raw_gyro_x; }
+	std::int16_t getRawGyroY(void) { return raw_gyro_y; }
+	std::int16_t getRawGyroZ(void) { return raw_gyro_z; }
+
+	float getTemp(void) { return temp; }
+	float getAccX(void) { return acc_x; }
+	float getAccY(void) { return acc_y; }
+	float getAccZ(void) { return acc_z; }
+	float getGyroX(void) { return gyro_x; }
+	float getGyroY(void) { return gyro_y; }
+	float getGyroZ(void) { return gyro_z; }
+
+	float getAccAngleX(void) { return angle_acc_x; }
+	float getAccAngleY(void) { return angle_acc_y; }
+	float getGyroAngleX(void) { return angle_gyro_x; }
+	float getGyroAngleY(void) { return angle_gyro_y; }
+	float getGyroAngleZ(void) { return angle_gyro_z; }
+
+	float getAngleX(void) { return angle_x; }
+	float getAngleY(void) { return angle_y; }
+	float getAngleZ(void) { return angle_z; }
+
+private:
+	static const std::uint8_t ADDRESS = 0x68;
+
+	std::int16_t readWord(void);
+
+	TwoWire* wire;
+	float acc_coef, gyro_coef;
+
+	std::int16_t raw_acc_x, raw_acc_y, raw_acc_z, raw_temp, raw_gyro_x, raw_gyro_y, raw_gyro_z;
+	float gyro_x_offset, gyro_y_offset, gyro_z_offset;
+	float temp, acc_x, acc_y, acc_z, gyro_x, gyro_y, gyro_z;
+	float angle_gyro_x, angle_gyro_y, angle_gyro_z, angle_acc_x, angle_acc_y;
+	float angle_x, angle_y, angle_z;
+	float interval;
+	std::uint32_t pre_interval;
+};
+
+#endif
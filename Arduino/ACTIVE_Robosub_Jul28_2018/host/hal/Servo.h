@@ -0,0 +1,33 @@
+#ifndef HOST_SERVO_H
+#define HOST_SERVO_H
+
+#include "Arduino.h"
+
+// host stand-in for Servo, the pulse width written is kept per pin in the simulation (sim::pwm)
+class Servo {
+public:
+	Servo() : pin(-1), us(1500) {}
+
+	std::uint8_t attach(int _pin) {
+		pin = _pin;
+		sim::setPwm(pin, us);
+		return 1;
+	}
+	void detach(void) {
+		sim::setPwm(pin, 0);
+		pin = -1;
+	}
+	bool attached(void) const { return pin >= 0; }
+
+	void writeMicroseconds(int _us) {
+		us = _us;
+		if(pin >= 0) sim::setPwm(pin, us);
+	}
+	int readMicroseconds(void) const { return us; }
+
+private:
+	int pin;
+	int us;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(int _address) {
+	address = (std::uint8_t)_address;
+	tx_count = 0;
+}
+
+std::size_t TwoWire::write(std::uint8_t b) {
+	if(tx_count >= BUFFER_LENGTH) return 0;
+	tx[tx_count++] = b;
+	return 1;
+}
+
+std::size_t TwoWire::write(const std::uint8_t* bytes, std::size_t count) {
+	std::size_t written = 0;
+	while(written < count && write(bytes[written])) ++written;
+	return written;
+}
+
+std::uint8_t TwoWire::endTransmission(bool) {
+	sim::i2cTransfer(tx_count);
+	sim::I2CDevice* device = sim::device(address);
+	if(!device) return 2;
+	device->receive(tx, tx_count);
+	return 0;
+}
+
+std::uint8_t TwoWire::requestFrom(int _address, int count, bool) {
+	rx_count = rx_index = 0;
+	if(count < 0) count = 0;
+	if((std::size_t)count > BUFFER_LENGTH) count = BUFFER_LENGTH;
+
+	sim::I2CDevice* device = sim::device((std::uint8_t)_address);
+	if(!device) {
+		sim::i2cTransfer(0);
+		return 0;
+	}
+	rx_count = device->request(rx, count);
+	sim::i2cTransfer(rx_count);
+	return (std::uint8_t)rx_count;
+}
@@ -0,0 +1,42 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+/*
+Host stand-in for Wire. Transactions go to whatever sim::I2CDevice is attached at
+the address, and take as long on the simulated clock as they would on the bus
+(100 kHz unless setClock() says otherwise). endTransmission() returns 2 (address
+not acknowledged) and requestFrom() 0 when nothing is attached, as with an
+unplugged sensor.
+*/
+
+class TwoWire {
+public:
+	TwoWire() : address(0), tx_count(0), rx_count(0), rx_index(0) {}
+
+	void begin(void) {}
+	void setClock(std::uint32_t hz) { sim::setI2CClock(hz); }
+
+	void beginTransmission(int address);
+	std::size_t write(std::uint8_t b);
+	std::size_t write(const std::uint8_t* bytes, std::size_t count);
+	std::uint8_t endTransmission(bool stop = true);
+
+	std::uint8_t requestFrom(int address, int count, bool stop = true);
+	int available(void) { return (int)(rx_count - rx_index); }
+	int read(void) { return rx_index < rx_count ? rx[rx_index++] : -1; }
+
+private:
+	static const std::size_t BUFFER_LENGTH = 32; // the Teensy's Wire buffer
+
+	std::uint8_t address;
+	std::uint8_t tx[BUFFER_LENGTH];
+	std::size_t tx_count;
+	std::uint8_t rx[BUFFER_LENGTH];
+	std::size_t rx_count, rx_index;
+};
+
+extern TwoWire Wire;
+
+#endif
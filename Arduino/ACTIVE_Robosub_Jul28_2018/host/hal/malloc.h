@@ -0,0 +1,37 @@
+#ifndef HOST_MALLOC_H
+#define HOST_MALLOC_H
+
+/*
+Host stand-in for newlib's <malloc.h>: mallinfo() as the Teensy has it, with
+size_t fields. glibc has deprecated its own int mallinfo() for mallinfo2(), so
+its declarations are renamed out of the way and this answers from mallinfo2().
+The numbers are the host allocator's, for the whole program - only the shape of
+the call is the Teensy's.
+*/
+
+#include <cstddef>
+
+#define mallinfo glibc_mallinfo
+#include_next <malloc.h>
+#undef mallinfo
+
+struct mallinfo {
+	std::size_t arena;    // bytes the heap has been grown to
+	std::size_t ordblks;  // free chunks
+	std::size_t smblks;
+	std::size_t hblks;
+	std::size_t hblkhd;
+	std::size_t usmblks;
+	std::size_t fsmblks;
+	std::size_t uordblks; // bytes allocated
+	std::size_t fordblks; // bytes free
+	std::size_t keepcost;
+};
+
+inline struct mallinfo mallinfo(void) {
+	struct mallinfo2 m = mallinfo2();
+	struct mallinfo out = { m.arena, m.ordblks, m.smblks, m.hblks, m.hblkhd, m.usmblks, m.fsmblks, m.uordblks, m.fordblks, m.keepcost };
+	return out;
+}
+
+#endif
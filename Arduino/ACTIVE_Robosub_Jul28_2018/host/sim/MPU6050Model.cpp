@@ -0,0 +1,64 @@
+#include "MPU6050Model.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace sim;
+
+namespace {
+	const std::uint8_t REG_GYRO_CONFIG = 0x1B;
+	const std::uint8_t REG_ACCEL_CONFIG = 0x1C;
+	const std::uint8_t REG_ACCEL_XOUT_H = 0x3B;
+	const std::uint8_t REG_TEMP_OUT_H = 0x41;
+	const std::uint8_t REG_GYRO_XOUT_H = 0x43;
+	const std::uint8_t REG_WHO_AM_I = 0x75;
+
+	std::int16_t saturate(float value) {
+		value = std::round(value);
+		if(value > 32767) return 32767;
+		if(value < -32768) return -32768;
+		return (std::int16_t)value;
+	}
+}
+
+MPU6050Model::MPU6050Model(std::uint8_t _address) : address(_address), pointer(0), temperature(20) {
+	std::memset(registers, 0, sizeof(registers));
+	registers[REG_WHO_AM_I] = 0x68;
+	setAccel(0, 0, 1);
+	setGyro(0, 0, 0);
+	sim::attach(address, this);
+}
+
+MPU6050Model::~MPU6050Model() {
+	if(sim::device(address) == this) sim::attach(address, nullptr);
+}
+
+void MPU6050Model::receive(const std::uint8_t* bytes, std::size_t count) {
+	if(count == 0) return;
+	pointer = bytes[0] & 0x7F;
+	// anything after the register address is written from there on
+	for(std::size_t i = 1; i < count; ++i) registers[(pointer + i - 1) & 0x7F] = bytes[i];
+}
+
+std::size_t MPU6050Model::request(std::uint8_t* bytes, std::size_t count) {
+	for(std::size_t i = 0; i < count; ++i) bytes[i] = readRegister((pointer + i) & 0x7F);
+	pointer = (pointer + count) & 0x7F;
+	return count;
+}
+
+std::uint8_t MPU6050Model::readRegister(std::uint8_t reg) const {
+	if(reg < REG_ACCEL_XOUT_H || reg >= REG_GYRO_XOUT_H + 6) return registers[reg];
+
+	// full scale select is bits 3 and 4, each step doubles the range
+	const float accel_lsb = 16384.0f / (1 << ((registers[REG_ACCEL_CONFIG] >> 3) & 3));
+	const float gyro_lsb = 131.0f / (1 << ((registers[REG_GYRO_CONFIG] >> 3) & 3));
+
+	std::int16_t value;
+	int word = (reg - REG_ACCEL_XOUT_H) / 2;
+	if(reg < REG_TEMP_OUT_H) value = saturate(accel[word] * accel_lsb);
+	else if(reg < REG_GYRO_XOUT_H) value = saturate((temperature - 36.53f) * 340.0f);
+	else value = saturate(gyro[word - 4] * gyro_lsb);
+
+	std::uint16_t bits = (std::uint16_t)value;
+	return ((reg - REG_ACCEL_XOUT_H) % 2 == 0) ? (bits >> 8) : (bits & 0xFF);
+}
@@ -0,0 +1,44 @@
+#ifndef MPU6050_MODEL_H
+#define MPU6050_MODEL_H
+
+#include "Sim.h"
+
+/*
+Register level model of an MPU6050 on the simulated I2C bus. The test sets what
+the sensor is measuring, in g and degrees per second in the sensor's frame,
+and reads of ACCEL_XOUT_H (0x3B) onwards return it scaled by the full scale
+ranges written to ACCEL_CONFIG and GYRO_CONFIG, big endian, as the real part
+does. Only the registers the firmware touches are meaningful, the rest read
+back what was written.
+
+	sim::MPU6050Model imu;            // attaches itself at 0x68
+	imu.setAccel(0, 0, 1);            // level
+	imu.setGyro(0, 0, 90);            // turning at 90 degrees/s about z
+*/
+
+namespace sim {
+	class MPU6050Model : public I2CDevice {
+	public:
+		static const std::uint8_t ADDRESS = 0x68;
+
+		MPU6050Model(std::uint8_t address = ADDRESS);
+		~MPU6050Model();
+
+		void setAccel(float x, float y, float z) { accel[0] = x; accel[1] = y; accel[2] = z; }
+		void setGyro(float x, float y, float z) { gyro[0] = x; gyro[1] = y; gyro[2] = z; }
+		void setTemperature(float c) { temperature = c; }
+
+		void receive(const std::uint8_t* bytes, std::size_t count) override;
+		std::size_t request(std::uint8_t* bytes, std::size_t count) override;
+
+	private:
+		std::uint8_t readRegister(std::uint8_t reg) const;
+
+		std::uint8_t address;
+		std::uint8_t registers[128];
+		std::uint8_t pointer;
+		float accel[3], gyro[3], temperature;
+	};
+}
+
+#endif
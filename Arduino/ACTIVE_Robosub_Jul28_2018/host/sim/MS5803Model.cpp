@@ -0,0 +1,93 @@
+#include "MS5803Model.h"
+
+#include <cmath>
+
+using namespace sim;
+
+namespace {
+	const std::uint8_t CMD_RESET = 0x1E;
+	const std::uint8_t CMD_ADC_READ = 0x00;
+	const std::uint8_t CMD_D1 = 0x40;
+	const std::uint8_t CMD_D2 = 0x50;
+	const std::uint8_t CMD_PROM_READ = 0xA0;
+
+	// factory calibration, C1 to C6 in PROM words 1 to 6
+	const std::uint16_t C1 = 46372, C2 = 43981, C3 = 29059, C4 = 27842, C5 = 31553, C6 = 28165;
+}
+
+std::uint32_t MS5803Model::conversionTime(int osr_index) {
+	static const std::uint32_t times[] = { 600, 1170, 2280, 4540, 9040 }; // datasheet maximums
+	if(osr_index < 0) osr_index = 0;
+	if(osr_index > 4) osr_index = 4;
+	return times[osr_index];
+}
+
+MS5803Model::MS5803Model(std::uint8_t _address) : address(_address), pressure(1013.25f), temperature(20),
+	converting(false), ready_at(0), conversion(0), out_count(0), conversion_count(0), early_reads(0) {
+	const std::uint16_t words[8] = { 0, C1, C2, C3, C4, C5, C6, 0 };
+	for(int i = 0; i < 8; ++i) prom[i] = words[i];
+	sim::attach(address, this);
+}
+
+MS5803Model::~MS5803Model() {
+	if(sim::device(address) == this) sim::attach(address, nullptr);
+}
+
+void MS5803Model::receive(const std::uint8_t* bytes, std::size_t count) {
+	if(count == 0) return;
+	const std::uint8_t cmd = bytes[0];
+
+	if(cmd == CMD_RESET) {
+		converting = false;
+		out_count = 0;
+
+	} else if(cmd == CMD_ADC_READ) {
+		// the result can be read once, and reads 0 while the conversion is still running
+		std::uint32_t value = 0;
+		if(converting) {
+			if(sim::now() >= ready_at) value = conversion;
+			else ++early_reads;
+		}
+		converting = false;
+		out[0] = value >> 16;
+		out[1] = value >> 8;
+		out[2] = value;
+		out_count = 3;
+
+	} else if((cmd & 0xF0) == CMD_D1 || (cmd & 0xF0) == CMD_D2) {
+		const int osr_index = (cmd & 0x0F) / 2;
+		converting = true;
+		ready_at = sim::now() + conversionTime(osr_index);
+		conversion = ((cmd & 0xF0) == CMD_D1 ? rawPressure() : rawTemperature());
+		++conversion_count;
+
+	} else if((cmd & 0xF0) == CMD_PROM_READ) {
+		std::uint16_t word = prom[(cmd >> 1) & 7];
+		out[0] = word >> 8;
+		out[1] = word & 0xFF;
+		out_count = 2;
+	}
+}
+
+std::size_t MS5803Model::request(std::uint8_t* bytes, std::size_t count) {
+	std::size_t n = (count < out_count ? count : out_count);
+	for(std::size_t i = 0; i < n; ++i) bytes[i] = out[i];
+	out_count = 0;
+	return n;
+}
+
+// the datasheet's first order equations run backwards, in the same integer types as MS5803::update()
+std::uint32_t MS5803Model::rawTemperature(void) const {
+	std::int64_t temp = std::llround(temperature * 100); // 0.01 C
+	std::int64_t dT = (temp - 2000) * 8388608 / C6; // 2^23
+	return (std::uint32_t)(dT + (std::int64_t)C5 * 256);
+}
+
+std::uint32_t MS5803Model::rawPressure(void) const {
+	std::int32_t dT = (std::int32_t)rawTemperature() - ((std::int32_t)C5 * 256);
+	std::int64_t off = ((std::int64_t)C2 * 262144) + ((C4 * (std::int64_t)dT) / 32);
+	std::int64_t sens = ((std::int64_t)C1 * 131072) + ((C3 * (std::int64_t)dT) / 128);
+	std::int64_t p = std::llround(pressure * 100); // 0.01 mbar
+	// rounded up so the truncating divisions on the way back land on p
+	return (std::uint32_t)(((p * 32768 + off) * 2097152 + sens - 1) / sens);
+}
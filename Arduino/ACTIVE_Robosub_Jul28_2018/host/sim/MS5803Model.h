@@ -0,0 +1,58 @@
+#ifndef MS5803_MODEL_H
+#define MS5803_MODEL_H
+
+#include "Sim.h"
+
+/*
+Command level model of an MS5803-05BA on the simulated I2C bus. It answers the
+reset, PROM read, D1/D2 conversion and ADC read commands with raw values that
+the datasheet's first order compensation turns back into the pressure and
+temperature set here (exactly, at 20 C and above - below that the second order
+correction the firmware applies moves the result a little).
+
+A conversion takes the datasheet's maximum time for its oversampling ratio on
+the simulated clock. An ADC read before it is done returns 0, like the real
+part, so firmware that doesn't wait long enough reads garbage here too.
+*/
+
+namespace sim {
+	class MS5803Model : public I2CDevice {
+	public:
+		static const std::uint8_t ADDRESS = 0x77;
+
+		MS5803Model(std::uint8_t address = ADDRESS);
+		~MS5803Model();
+
+		void setPressure(float mbar) { pressure = mbar; }
+		void setTemperature(float c) { temperature = c; }
+
+		// conversion time of each OSR setting (256 to 4096), microseconds
+		static std::uint32_t conversionTime(int osr_index);
+
+		unsigned long conversions(void) const { return conversion_count; }
+		unsigned long earlyReads(void) const { return early_reads; } // ADC reads that came before the conversion was done
+
+		void receive(const std::uint8_t* bytes, std::size_t count) override;
+		std::size_t request(std::uint8_t* bytes, std::size_t count) override;
+
+	private:
+		std::uint32_t rawTemperature(void) const;
+		std::uint32_t rawPressure(void) const;
+
+		std::uint8_t address;
+		float pressure, temperature;
+
+		std::uint16_t prom[8];
+
+		bool converting;
+		std::uint64_t ready_at;
+		std::uint32_t conversion; // result of the last conversion
+
+		std::uint8_t out[3]; // what the next requestFrom() reads
+		std::size_t out_count;
+
+		unsigned long conversion_count, early_reads;
+	};
+}
+
+#endif
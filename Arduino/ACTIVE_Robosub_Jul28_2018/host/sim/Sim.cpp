@@ -0,0 +1,145 @@
+#include "Sim.h"
+
+#include <deque>
+
+namespace {
+	std::uint64_t clock_us = 0;
+	std::uint64_t blocked_us = 0;
+
+	std::deque<std::uint8_t> rx;
+	std::string tx;
+	int tx_room = sim::SERIAL_ROOM;
+
+	int analog_pins[sim::PIN_COUNT] = {};
+	int digital_pins[sim::PIN_COUNT] = {};
+	int pwm_pins[sim::PIN_COUNT] = {};
+
+	struct Timer {
+		void (*isr)(void);
+		std::uint32_t period_us;
+		std::uint64_t next_us;
+		bool held; // came due with interrupts off
+	};
+	Timer timers[sim::TIMER_COUNT] = {};
+	bool interrupts_on = true;
+	bool in_isr = false;
+
+	sim::I2CDevice* devices[128] = {};
+	std::uint32_t i2c_hz = 100000; // Wire's default
+	sim::Counters counts = {};
+
+	bool validPin(int pin) { return pin >= 0 && pin < sim::PIN_COUNT; }
+
+	void fire(Timer& t) {
+		if(!interrupts_on || in_isr) {
+			t.held = true;
+			return;
+		}
+		t.held = false;
+		in_isr = true;
+		t.isr();
+		in_isr = false;
+	}
+
+	// moves the clock to until, stopping at every timer deadline on the way
+	void moveClock(std::uint64_t until) {
+		for(;;) {
+			Timer* first = nullptr;
+			for(Timer& t : timers) {
+				if(t.isr && t.next_us <= until && (!first || t.next_us < first->next_us)) first = &t;
+			}
+			if(!first) break;
+			if(first->next_us > clock_us) clock_us = first->next_us;
+			first->next_us += first->period_us;
+			fire(*first);
+		}
+		if(until > clock_us) clock_us = until;
+	}
+}
+
+std::uint64_t sim::now(void) { return clock_us; }
+void sim::advance(std::uint64_t us) { moveClock(clock_us + us); }
+std::uint64_t sim::blocked(void) { return blocked_us; }
+void sim::block(std::uint64_t us) {
+	moveClock(clock_us + us);
+	blocked_us += us;
+	++counts.delays;
+}
+
+int sim::startTimer(std::uint32_t period_us, void (*isr)(void)) {
+	if(!isr || period_us == 0) return -1;
+	for(int id = 0; id < TIMER_COUNT; ++id) {
+		if(!timers[id].isr) {
+			timers[id] = { isr, period_us, clock_us + period_us, false };
+			return id;
+		}
+	}
+	return -1;
+}
+void sim::stopTimer(int id) {
+	if(id >= 0 && id < TIMER_COUNT) timers[id] = Timer();
+}
+void sim::setInterrupts(bool enabled) {
+	interrupts_on = enabled;
+	if(!enabled) return;
+	for(Timer& t : timers) {
+		if(t.isr && t.held) fire(t);
+	}
+}
+
+void sim::serialInput(const std::string& bytes) { rx.insert(rx.end(), bytes.begin(), bytes.end()); }
+std::size_t sim::serialPending(void) { return rx.size(); }
+int sim::serialRead(void) {
+	if(rx.empty()) return -1;
+	int c = rx.front();
+	rx.pop_front();
+	return c;
+}
+void sim::serialWrite(const std::uint8_t* bytes, std::size_t count) { tx.append((const char*)bytes, count); }
+int sim::serialRoom(void) { return tx_room; }
+void sim::setSerialRoom(int bytes) { tx_room = bytes; }
+std::string sim::serialOutput(void) {
+	// a copy, so tx keeps its buffer and the firmware's prints don't allocate on the host once it's grown
+	std::string out(tx);
+	tx.clear();
+	return out;
+}
+
+void sim::setAnalog(int pin, int value) { if(validPin(pin)) analog_pins[pin] = value; }
+int sim::analog(int pin) {
+	++counts.analog_reads;
+	return validPin(pin) ? analog_pins[pin] : 0;
+}
+void sim::setDigital(int pin, int value) { if(validPin(pin)) digital_pins[pin] = value; }
+int sim::digital(int pin) { return validPin(pin) ? digital_pins[pin] : 0; }
+void sim::setPwm(int pin, int us) { if(validPin(pin)) pwm_pins[pin] = us; }
+int sim::pwm(int pin) { return validPin(pin) ? pwm_pins[pin] : 0; }
+
+void sim::attach(std::uint8_t address, I2CDevice* device) { devices[address & 0x7F] = device; }
+sim::I2CDevice* sim::device(std::uint8_t address) { return devices[address & 0x7F]; }
+
+void sim::setI2CClock(std::uint32_t hz) { if(hz > 0) i2c_hz = hz; }
+void sim::i2cTransfer(std::size_t count) {
+	// 9 clocks a byte (8 bits and the ack) plus start and stop, rounded up to whole microseconds
+	std::uint64_t clocks = 9 * (count + 1) + 2;
+	moveClock(clock_us + (clocks * 1000000 + i2c_hz - 1) / i2c_hz);
+	++counts.i2c_transactions;
+	counts.i2c_bytes += count;
+}
+
+const sim::Counters& sim::counters(void) { return counts; }
+
+void sim::reset(void) {
+	clock_us = blocked_us = 0;
+	rx.clear();
+	tx.clear();
+	tx_room = SERIAL_ROOM;
+	for(int i = 0; i < PIN_COUNT; ++i) analog_pins[i] = digital_pins[i] = pwm_pins[i] = 0;
+	i2c_hz = 100000;
+	counts = Counters();
+	interrupts_on = true;
+	for(Timer& t : timers) {
+		t.next_us = t.period_us;
+		t.held = false;
+	}
+}
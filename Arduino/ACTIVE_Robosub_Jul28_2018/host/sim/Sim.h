@@ -0,0 +1,112 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/*
+The simulated hardware behind the host HAL (host/hal/). The firmware never sees
+this - it calls millis(), Wire, Serial and Servo as it would on the Teensy, and
+the HAL forwards to the state kept here. Benches and tests drive it directly:
+
+	sim::serialInput("SAFE\n");          // as if typed into the serial monitor
+	loop();
+	std::string reply = sim::serialOutput(); // everything printed since the last call
+	int us = sim::pwm(3);                 // last pulse width written to the servo on pin 3
+
+Time only moves when something on the firmware side would take time on the
+Teensy: delay(), I2C transfers at the bus clock and analogRead(). CPU time is
+not simulated, so now() measures how long the firmware is stuck on I/O, which
+is the same on every machine - blocked() is how much of that was spent in
+delay(). Benches measure CPU time with the host's clock separately.
+*/
+
+namespace sim {
+	// ********************************
+	// clock
+	// ********************************
+
+	std::uint64_t now(void); // microseconds since reset()
+	void advance(std::uint64_t us);
+	std::uint64_t blocked(void); // microseconds spent in delay() since reset()
+	void block(std::uint64_t us); // advance() and count it as blocked
+
+	// ********************************
+	// timers
+	// ********************************
+
+	// periodic interrupts, IntervalTimer's. A timer fires whenever the clock moves past one
+	// of its deadlines, with now() at the deadline - in the middle of a delay() or an I2C
+	// transfer, as it would on the Teensy. While interrupts are off it is held until they
+	// are turned back on
+	const int TIMER_COUNT = 4; // PIT channels on the Teensy 3.5
+	int startTimer(std::uint32_t period_us, void (*isr)(void)); // -1 when all are in use
+	void stopTimer(int id);
+	void setInterrupts(bool enabled); // noInterrupts() and interrupts()
+
+	// ********************************
+	// serial
+	// ********************************
+
+	void serialInput(const std::string& bytes);
+	std::size_t serialPending(void); // input not yet read by the firmware
+	int serialRead(void); // -1 when there is nothing to read
+	void serialWrite(const std::uint8_t* bytes, std::size_t count);
+	std::string serialOutput(void); // returns and clears what was written
+	// room left in the Teensy's USB transmit buffer, Serial.availableForWrite() - the host is
+	// taken to keep up unless a bench says otherwise
+	const int SERIAL_ROOM = 12 * 64; // 12 packets
+	int serialRoom(void);
+	void setSerialRoom(int bytes);
+
+	// ********************************
+	// pins
+	// ********************************
+
+	const int PIN_COUNT = 64;
+
+	void setAnalog(int pin, int value);
+	int analog(int pin);
+	void setDigital(int pin, int value);
+	int digital(int pin);
+	void setPwm(int pin, int us);
+	int pwm(int pin); // 0 if nothing is attached
+
+	// ********************************
+	// I2C
+	// ********************************
+
+	// a device on the bus, one transaction at a time
+	class I2CDevice {
+	public:
+		virtual ~I2CDevice() {}
+		// the bytes written between beginTransmission() and endTransmission()
+		virtual void receive(const std::uint8_t* bytes, std::size_t count) = 0;
+		// fill up to count bytes for requestFrom(), returns how many the device sent
+		virtual std::size_t request(std::uint8_t* bytes, std::size_t count) = 0;
+	};
+
+	void attach(std::uint8_t address, I2CDevice* device); // nullptr detaches
+	I2CDevice* device(std::uint8_t address);
+
+	void setI2CClock(std::uint32_t hz);
+	// advances the clock by the time a transaction of count bytes (plus the address) takes on the bus
+	void i2cTransfer(std::size_t count);
+
+	struct Counters {
+		unsigned long i2c_transactions, i2c_bytes;
+		unsigned long delays; // delay() and delayMicroseconds() calls
+		unsigned long analog_reads;
+	};
+	const Counters& counters(void);
+
+	// analogRead() on a Teensy 3.5 at the default resolution and averaging
+	const unsigned ANALOG_READ_US = 9;
+
+	// back to time 0, no input or output, all pins 0, counters cleared
+	// attached I2C devices and running timers stay, the timers counting from 0
+	void reset(void);
+}
+
+#endif
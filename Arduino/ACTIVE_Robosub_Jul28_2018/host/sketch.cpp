@@ -0,0 +1,2 @@
+// the firmware sketch as one translation unit of the host build, see sketch.h
+#include "../ACTIVE_Robosub_Jul28_2018.ino"
@@ -0,0 +1,46 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <ArduinoSTL.h>
+#include <Arduino.h>
+
+#include "../BLThruster.h"
+#include "../PIDCore.h"
+#include "../control_ids.h"
+#include "../ControlTick.h"
+#include "../Mixer.h"
+#include "../Telemetry.h"
+#include "../Fusion.h"
+#include "../EulerVector3.h"
+
+/*
+What the host programs can reach of the sketch (sketch.cpp compiles the .ino
+unchanged). Everything else is observed the way it would be on the sub - what
+it prints on Serial, the pulse widths on the thruster pins and the sensor
+models it reads - see sim/Sim.h.
+*/
+
+void setup(void);
+void loop(void);
+
+// the pieces of loop(), so they can be timed one at a time
+void controlTick(void); // run when control_tick is due: these three
+void readSensors(void);
+EulerVector3& orientation(void); // converted from fusion on the first call after an update
+void updatePIDControllers(void);
+void updateThrusters(void);
+void sendTelemetry(void); // and this one while telemetry is on
+void readSerial(void); // and in the background
+void bgLog(void);
+
+void parseCommand(char* cmd); // split in place
+
+extern PIDBank<float, axis::Count> pid;
+extern float pid_target[axis::Count];
+extern BLThruster thrusters[thr::Count];
+extern float thrust_base;
+extern ControlTick control_tick;
+extern Mixer mixer;
+extern Fusion fusion; // the host build has the MPU6050
+
+#endif
@@ -11,8 +11,7 @@ void setupIMU() {
       IMU_SETUP_GOOD = true;
       break;
     }
-    String msg = "BOOT\tIMU Init - Attempt " + String(cnt) + " failed.";
-    Serial.println(msg);
+    reply.add("BOOT\tIMU Init - Attempt ", cnt, " failed.").send();
     ++cnt;
     delay(500);
   }
@@ -20,7 +19,7 @@ void setupIMU() {
     Serial.println(F("BOOT\tIMU found."));
     uint8_t sys, gyro, accel, mag;
     bno055.getCalibration(&sys, &gyro, &accel, &mag); // this blocks the entire program if it fails to get the data
-    String msg = String("//BOOT Imu: Sys = ") + sys + ", Gyro = " + gyro + ", Accel = " + accel + ", Mag = " + mag; Serial.println(msg);
+    reply.add("//BOOT Imu: Sys = ", sys, ", Gyro = ", gyro, ", Accel = ", accel, ", Mag = ", mag).send();
   } else {
     Serial.println(F("BOOT\tIMU initialization failed. Continuing... even though it's pointless."));
   }
@@ -34,9 +33,8 @@ void setupIMU() {
   Serial.println("BOOT IMU initialized if connected correctly.");
   Serial.println("BOOT Beginning IMU Calibration - DO NOT MOVE");
   mpu6050.calcGyroOffsets(false); // do not write to console
-  String msg = "BOOT\tIMU gyro calibration complete: " + String(mpu6050.getGyroXoffset()) + ", "
-    + String(mpu6050.getGyroYoffset()) + ", " + String(mpu6050.getGyroZoffset());
-  Serial.println(msg);
+  reply.add("BOOT\tIMU gyro calibration complete: ", mpu6050.getGyroXoffset(), ", ",
+    mpu6050.getGyroYoffset(), ", ", mpu6050.getGyroZoffset()).send();
 
 /*
 cal log:
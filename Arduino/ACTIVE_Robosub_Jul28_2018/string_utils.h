@@ -1,25 +1,36 @@
-#include <ArduinoSTL.h>
+#ifndef STRING_UTILS_H
+#define STRING_UTILS_H
 
 #include <Arduino.h>
 
-// split
+// command line helpers that work in place on a char buffer, nothing here allocates
 namespace str_util {
-  // assumptions:
-  // input string has at least one character, that character is not the delimiting character
-  void split(String str, char delim, std::vector<String>& tokens) {
-    tokens.clear(); // remove existing contents if there is any
-    if(str.length() > 0) {
-      str += delim; // a hack such that the last section is captured
-      uint16_t prev_index = 0;
-      for(uint16_t index = 1; index < str.length(); index++) {
-        if(str.charAt(index) == delim) {
-          if(index != prev_index) {
-            tokens.push_back(str.substring(prev_index, index));
-          }
-          prev_index = index + 1;
-        }
-      }
+  inline bool equals(const char* a, const char* b) {
+    return strcmp(a, b) == 0;
+  }
+
+  // splits line in place on delim, pointing tokens at the pieces. Runs of delim count as one,
+  // the same as a leading or trailing delim. Returns the number of tokens, or -1 if there are
+  // more than max - the line is left half split then
+  inline int8_t tokenize(char* line, char delim, char** tokens, uint8_t max) {
+    uint8_t count = 0;
+    char* c = line;
+    while(true) {
+      while(*c == delim) ++c;
+      if(*c == '\0') return count;
+      if(count == max) return -1;
+      tokens[count++] = c;
+      while(*c != delim && *c != '\0') ++c;
+      if(*c == '\0') return count;
+      *c++ = '\0';
     }
   }
+
+  // 32 bit FNV-1a, constexpr so command tables can hold it precomputed. It's a tail call, so
+  // at runtime it compiles to a loop
+  constexpr uint32_t hash(const char* s, uint32_t h = 2166136261UL) {
+    return *s == '\0' ? h : hash(s + 1, (h ^ (uint8_t)*s) * 16777619UL);
+  }
 }
 
+#endif
@@ -0,0 +1,343 @@
+/*
+Counts the heap allocations the vision pipelines make per frame once they are
+warmed up, and checks the mask kernels they use (Vision/MaskKernels.hpp) against
+the OpenCV calls they replace.
+
+Every allocation in the process is counted - malloc and friends are wrapped
+(glibc), and operator new goes through malloc. Each pipeline runs the frames
+twice: the first lap grows every buffer to what these frames need, and the
+second lap has to do without allocating. The only exception is what OpenCV
+allocates inside approxPolyDP and minAreaRect - temporaries it makes on every
+call, whatever is passed in. Those are counted by repeating the two calls on the
+frame's target, and taken off the frame's total. Anything left fails the bench.
+
+The kernel check compares dilateRect (5x5, 7x7), decimate and
+traceExternalContours with cv::dilate, cv::resize and cv::findContours on
+thresholded frames and on random masks, then times both.
+
+usage: make bench, or bin/frame_arena_bench [source] [frames]
+	with no source, 640x480 frames of an orange target and path with a varying number
+	of orange specks around them are synthesized, so the contour count changes from
+	frame to frame
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Vision/VisionPipeline.hpp"
+#include "Vision/MaskKernels.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+// ********************************
+// Allocation counting
+// ********************************
+
+static std::atomic<unsigned long> allocations(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+	void* __libc_malloc(std::size_t size);
+	void* __libc_calloc(std::size_t count, std::size_t size);
+	void* __libc_realloc(void* ptr, std::size_t size);
+	void* __libc_memalign(std::size_t alignment, std::size_t size);
+
+	void* malloc(std::size_t size) {
+		++allocations;
+		return __libc_malloc(size);
+	}
+	void* calloc(std::size_t count, std::size_t size) {
+		++allocations;
+		return __libc_calloc(count, size);
+	}
+	void* realloc(void* ptr, std::size_t size) {
+		++allocations;
+		return __libc_realloc(ptr, size);
+	}
+	void* memalign(std::size_t alignment, std::size_t size) {
+		++allocations;
+		return __libc_memalign(alignment, size);
+	}
+	void* aligned_alloc(std::size_t alignment, std::size_t size) {
+		++allocations;
+		return __libc_memalign(alignment, size);
+	}
+	int posix_memalign(void** out, std::size_t alignment, std::size_t size) {
+		++allocations;
+		*out = __libc_memalign(alignment, size);
+		return (*out ? 0 : ENOMEM);
+	}
+}
+#define COUNT_NEW
+#else
+// only what goes through operator new is seen
+#define COUNT_NEW ++allocations
+#endif
+
+void* operator new(std::size_t size) {
+	COUNT_NEW;
+	void* p = std::malloc(size ? size : 1);
+	if(!p) throw std::bad_alloc();
+	return p;
+}
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	COUNT_NEW;
+	return std::malloc(size ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// ********************************
+// Frames
+// ********************************
+
+static std::vector<cv::Mat> syntheticFrames(int count) {
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::uniform_int_distribution<int> noise(-12, 12);
+	const cv::Scalar orange(30, 110, 230);
+	std::vector<cv::Mat> frames;
+
+	for(int f = 0; f < count; ++f) {
+		cv::Mat img(480, 640, CV_8UC3);
+		for(int y = 0; y < img.rows; ++y) {
+			std::uint8_t* p = img.ptr<std::uint8_t>(y);
+			for(int x = 0; x < img.cols; ++x, p += 3) {
+				p[0] = cv::saturate_cast<std::uint8_t>(120 - y / 8 + noise(rng));
+				p[1] = cv::saturate_cast<std::uint8_t>(100 - y / 10 + noise(rng));
+				p[2] = cv::saturate_cast<std::uint8_t>(25 + noise(rng));
+			}
+		}
+
+		// a bar drifting across the frame, the biggest thing in view
+		cv::Point2f center(160 + 320 * f / count, 200 + 80 * unit(rng));
+		double a = CV_PI / 2 + (unit(rng) - 0.5) * 0.8;
+		cv::Point2f dir(std::cos(a) * 140, std::sin(a) * 140), side(-std::sin(a) * 22, std::cos(a) * 22);
+		cv::Point corners[4] = { center - dir + side, center + dir + side, center + dir - side, center - dir - side };
+		cv::fillConvexPoly(img, corners, 4, orange);
+
+		// a different number of specks every frame
+		int specks = f % 37;
+		for(int i = 0; i < specks; ++i) {
+			cv::Point p(8 + unit(rng) * 624, 8 + unit(rng) * 464);
+			int r = 1 + unit(rng) * 5;
+			cv::Point speck[4] = { p + cv::Point(-r, 0), p + cv::Point(0, -r), p + cv::Point(r, 0), p + cv::Point(0, r) };
+			cv::fillConvexPoly(img, speck, 4, orange);
+		}
+		frames.push_back(img);
+	}
+	return frames;
+}
+
+static std::vector<cv::Mat> sourceFrames(const std::string& spec, int max_frames) {
+	std::vector<cv::Mat> frames;
+	std::unique_ptr<vision::FrameSource> source = vision::openSource(spec);
+	cv::Mat frame;
+	while((int)frames.size() < max_frames && source->isOpened() && source->read(frame)) frames.push_back(frame.clone());
+	return frames;
+}
+
+// ********************************
+// Kernel check
+// ********************************
+
+static bool sameContours(const vision::ContourStore& mine, const std::vector<std::vector<cv::Point>>& ref) {
+	if(mine.size() != ref.size()) return false;
+	for(std::size_t i = 0; i < ref.size(); ++i) {
+		if(mine.count(i) != (int)ref[i].size()) return false;
+		const int* p = mine.points(i);
+		for(std::size_t k = 0; k < ref[i].size(); ++k) {
+			if(p[2 * k] != ref[i][k].x || p[2 * k + 1] != ref[i][k].y) return false;
+		}
+	}
+	return true;
+}
+
+// compares the kernels with OpenCV on one mask and a BGR image, returns the number of things that differ
+static int checkKernels(const cv::Mat& mask, const cv::Mat& bgr, cv::Point offset) {
+	int bad = 0;
+	std::vector<std::uint8_t> row(mask.cols + 8);
+
+	for(int size : { 5, 7 }) {
+		cv::Mat ref, mine(mask.size(), CV_8UC1);
+		cv::dilate(mask, ref, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(size, size)));
+		vision::dilateRect(mask.data, mask.step, mine.data, mine.step, mask.cols, mask.rows, size, row.data());
+		bad += (cv::countNonZero(ref != mine) > 0);
+	}
+
+	for(int scale : { 2, 4 }) {
+		cv::Size size((bgr.cols + scale - 1) / scale, (bgr.rows + scale - 1) / scale);
+		cv::Mat ref, mine(size, CV_8UC3);
+		std::vector<int> offsets(size.width);
+		cv::resize(bgr, ref, size, 0, 0, cv::INTER_NEAREST);
+		vision::decimate(bgr.data, bgr.step, bgr.cols, bgr.rows, mine.data, mine.step, size.width, size.height, 3, offsets.data());
+		bad += (cv::norm(ref, mine, cv::NORM_INF) > 0);
+	}
+
+	std::vector<std::vector<cv::Point>> ref;
+	cv::findContours(mask.clone(), ref, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, offset);
+	std::vector<std::int8_t> labels((mask.cols + 2) * (mask.rows + 2));
+	vision::ContourStore mine;
+	vision::traceExternalContours(mask.data, mask.step, mask.cols, mask.rows, offset.x, offset.y, labels.data(), mine);
+	bad += !sameContours(mine, ref);
+	return bad;
+}
+
+static cv::Mat thresholdMask(const cv::Mat& bgr) {
+	cv::Mat hsv, mask;
+	cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+	cv::inRange(hsv, cv::Scalar(2, 111, 100), cv::Scalar(18, 255, 255), mask);
+	return mask;
+}
+
+static double timeMs(const std::vector<cv::Mat>& masks, int repeats, void (*run)(const cv::Mat&)) {
+	clock_type::time_point start = clock_type::now();
+	for(int r = 0; r < repeats; ++r) for(const cv::Mat& m : masks) run(m);
+	return std::chrono::duration<double, std::milli>(clock_type::now() - start).count() / (repeats * masks.size());
+}
+
+// ********************************
+// Allocations per frame
+// ********************************
+
+// what approxPolyDP and minAreaRect allocate for themselves on this frame's target
+static unsigned long geometryAllocations(vision::VisionFrame& frame, std::vector<cv::Point>& poly) {
+	if(!frame.detection.found || frame.target < 0) return 0;
+	const std::vector<cv::Point>& target_poly = frame.targets.poly(frame.target);
+	poly.reserve(frame.contours.count(frame.targets.contour(frame.target))); // so the output vector itself never counts
+
+	unsigned long before = allocations.load();
+	cv::approxPolyDP(vision::contourMat(frame.contours, frame.targets.contour(frame.target)), poly, 2, true);
+	cv::minAreaRect(target_poly);
+	return allocations.load() - before;
+}
+
+struct Run {
+	const char* name;
+	const char* pipeline;
+	bool tracking;
+	double budget_ms;
+};
+
+// false if the second lap allocated anything beyond the OpenCV geometry temporaries
+static bool checkAllocations(const Run& run, const std::vector<cv::Mat>& frames) {
+	vision::Pipeline pipeline;
+	vision::configure(pipeline, run.pipeline);
+	pipeline.setTracking(run.tracking);
+	// a budget nothing can meet walks the governor down to its lowest level within the first lap
+	pipeline.setFrameBudget(run.budget_ms);
+
+	std::vector<cv::Point> poly;
+	unsigned long warmup = 0, total = 0, geometry = 0, arena_before = 0, found = 0;
+	for(int lap = 0; lap < 2; ++lap) {
+		if(lap == 1) arena_before = pipeline.frame().arena.allocations();
+		for(const cv::Mat& f : frames) {
+			f.copyTo(pipeline.frame().input); // same size every time, no allocation
+
+			unsigned long before = allocations.load();
+			pipeline.process();
+			unsigned long made = allocations.load() - before;
+
+			if(lap == 0) {
+				warmup += made;
+				continue;
+			}
+			total += made;
+			geometry += geometryAllocations(pipeline.frame(), poly);
+			found += pipeline.frame().detection.found;
+		}
+	}
+
+	unsigned long own = total - geometry;
+	unsigned long arena_grew = pipeline.frame().arena.allocations() - arena_before;
+	std::printf("  %-24s %6lu warming up, then %5.2f/frame of which OpenCV geometry %5.2f, pipeline %lu  (quality %d, found %lu/%zu)\n",
+		run.name, warmup, (double)total / frames.size(), (double)geometry / frames.size(), own,
+		pipeline.quality().level(), found, frames.size());
+	if(arena_grew > 0) std::printf("    the arena grew %lu times in the second lap\n", arena_grew);
+	return own == 0 && arena_grew == 0;
+}
+
+int main(int argc, char* argv[]) {
+	int frame_count = (argc > 2 ? std::atoi(argv[2]) : 40);
+	std::vector<cv::Mat> frames = (argc > 1 ? sourceFrames(argv[1], frame_count) : syntheticFrames(frame_count));
+	if(frames.empty()) {
+		std::printf("no frames from %s\n", argv[1]);
+		return 1;
+	}
+
+	std::printf("checking the mask kernels against cv::dilate, cv::resize and cv::findContours:\n");
+	std::mt19937 rng(3);
+	int bad = 0, checked = 0;
+	for(const cv::Mat& f : frames) {
+		bad += checkKernels(thresholdMask(f), f, cv::Point(5, 9));
+		++checked;
+	}
+	for(int i = 0; i < 200; ++i) {
+		// noise and odd sizes, objects touching the edges, holes with things inside them
+		cv::Mat mask(1 + rng() % 90, 1 + rng() % 90, CV_8UC1), bgr(mask.size(), CV_8UC3);
+		cv::randu(bgr, cv::Scalar::all(0), cv::Scalar::all(256));
+		double density = (rng() % 100) / 100.0;
+		for(int y = 0; y < mask.rows; ++y) {
+			for(int x = 0; x < mask.cols; ++x) mask.at<std::uint8_t>(y, x) = ((rng() % 1000) < density * 1000 ? 1 + rng() % 255 : 0);
+		}
+		bad += checkKernels(mask, bgr, cv::Point(rng() % 20, rng() % 20));
+		++checked;
+	}
+	std::printf("  %d masks, %s\n", checked, bad == 0 ? "identical" : "DIFFERENT");
+	if(bad > 0) return 1;
+
+	std::vector<cv::Mat> masks;
+	for(const cv::Mat& f : frames) masks.push_back(thresholdMask(f));
+	const int repeats = 20;
+	static std::vector<std::uint8_t> row;
+	static std::vector<std::int8_t> labels;
+	static vision::ContourStore store;
+	static cv::Mat out, kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7));
+	static std::vector<std::vector<cv::Point>> contours;
+	double cv_dilate = timeMs(masks, repeats, [](const cv::Mat& m) { cv::dilate(m, out, kernel); });
+	double my_dilate = timeMs(masks, repeats, [](const cv::Mat& m) {
+		out.create(m.size(), CV_8UC1);
+		row.resize(m.cols + 7);
+		vision::dilateRect(m.data, m.step, out.data, out.step, m.cols, m.rows, 7, row.data());
+	});
+	double cv_contours = timeMs(masks, repeats, [](const cv::Mat& m) { cv::findContours(m, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE); });
+	double my_contours = timeMs(masks, repeats, [](const cv::Mat& m) {
+		labels.resize((m.cols + 2) * (m.rows + 2));
+		vision::traceExternalContours(m.data, m.step, m.cols, m.rows, 0, 0, labels.data(), store);
+	});
+	std::printf("%d x %d masks:\n", masks[0].cols, masks[0].rows);
+	std::printf("  %-24s %8.3f ms  dilateRect  %8.3f ms\n", "cv::dilate 7x7", cv_dilate, my_dilate);
+	std::printf("  %-24s %8.3f ms  traceExternalContours  %8.3f ms\n", "cv::findContours", cv_contours, my_contours);
+
+	std::printf("allocations per frame, %zu frames, second lap:\n", frames.size());
+	const Run runs[] = {
+		{ "heading", "heading", false, 0 },
+		{ "heading, tracking", "heading", true, 0 },
+		{ "heading, degraded", "heading", true, 1e-6 },
+		{ "path", "path", false, 0 },
+		{ "path_pyramid, tracking", "path_pyramid", true, 0 }
+	};
+	bool pass = true;
+	for(const Run& run : runs) pass = checkAllocations(run, frames) && pass;
+
+	if(!pass) {
+		std::printf("FAIL: the pipeline allocated in steady state\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+Checks the fused HSV threshold kernel (Vision/HSVKernel.hpp) against
+cv::cvtColor + cv::inRange and times both per frame.
+
+The check runs first and the bench fails if anything differs: every one of the
+2^24 BGR colours (one 4096x4096 image) against a few bound sets, including the
+heading bounds and awkward ones (fractional, reversed, out of range), then the
+frames being timed. Odd widths and a non-continuous ROI are thrown in so row
+tails and the per-row path get covered too.
+
+usage: make bench, or bin/hsv_threshold_bench [source] [frames]
+	with no source, 640x480 frames are synthesized - mostly blue-green water with
+	orange blobs, so the V/S early outs behave roughly like they do in the pool
+	a source is anything vision::openSource takes, its first frames are used
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "Vision/HSVKernel.hpp"
+#include "Vision/FrameSource.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+struct Bounds {
+	cv::Scalar lower;
+	cv::Scalar upper;
+};
+
+static const std::vector<Bounds> check_bounds = {
+	{ cv::Scalar(2, 111, 100), cv::Scalar(18, 255, 255) }, // configureHeading
+	{ cv::Scalar(100, 50, 50), cv::Scalar(130, 255, 255) },
+	{ cv::Scalar(170, 0, 0), cv::Scalar(179, 40, 255) },
+	{ cv::Scalar(0, 0, 50), cv::Scalar(180, 255, 200) }, // V only
+	{ cv::Scalar(2.5, 3.5, 0.5), cv::Scalar(254.5, 255.5, 254.49) }, // rounding
+	{ cv::Scalar(10, 0, 0), cv::Scalar(5, 255, 255) }, // empty
+	{ cv::Scalar(-10, -5, -1), cv::Scalar(0, 0, 0) },
+};
+
+static vision::HSVRange toRange(const Bounds& b) {
+	double lo[3] = { b.lower[0], b.lower[1], b.lower[2] };
+	double hi[3] = { b.upper[0], b.upper[1], b.upper[2] };
+	return vision::makeHSVRange(lo, hi);
+}
+
+static void reference(const cv::Mat& bgr, const Bounds& b, cv::Mat& hsv, cv::Mat& mask) {
+	cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+	cv::inRange(hsv, b.lower, b.upper, mask);
+}
+
+template<typename Row>
+static void fused(const cv::Mat& bgr, const vision::HSVRange& range, cv::Mat& mask, Row row) {
+	mask.create(bgr.size(), CV_8UC1);
+	for(int y = 0; y < bgr.rows; ++y) row(bgr.ptr<std::uint8_t>(y), mask.ptr<std::uint8_t>(y), bgr.cols, range);
+}
+
+static long differences(const cv::Mat& a, const cv::Mat& b) {
+	long n = 0;
+	for(int y = 0; y < a.rows; ++y) {
+		const std::uint8_t* pa = a.ptr<std::uint8_t>(y);
+		const std::uint8_t* pb = b.ptr<std::uint8_t>(y);
+		for(int x = 0; x < a.cols; ++x) n += (pa[x] != pb[x]);
+	}
+	return n;
+}
+
+// compare both kernel paths against OpenCV on one image, prints and returns the number of bad pixels
+static long check(const char* what, const cv::Mat& bgr) {
+	cv::Mat hsv, expected, simd, scalar;
+	long bad = 0;
+	for(const Bounds& b : check_bounds) {
+		vision::HSVRange range = toRange(b);
+		reference(bgr, b, hsv, expected);
+		fused(bgr, range, simd, vision::hsvThresholdRow);
+		fused(bgr, range, scalar, vision::hsvThresholdRowScalar);
+		bad += differences(expected, simd) + differences(expected, scalar);
+	}
+	std::printf("  %-34s %s\n", what, bad == 0 ? "identical" : "DIFFERENT");
+	return bad;
+}
+
+static cv::Mat allColours(void) {
+	cv::Mat img(4096, 4096, CV_8UC3);
+	std::uint8_t* p = img.ptr<std::uint8_t>(0);
+	for(std::uint32_t i = 0; i < (1u << 24); ++i, p += 3) {
+		p[0] = i & 0xff;
+		p[1] = (i >> 8) & 0xff;
+		p[2] = (i >> 16) & 0xff;
+	}
+	return img;
+}
+
+static std::vector<cv::Mat> syntheticFrames(int count) {
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> noise(-12, 12);
+	std::vector<cv::Mat> frames;
+	for(int f = 0; f < count; ++f) {
+		cv::Mat img(480, 640, CV_8UC3);
+		int cx = 100 + (int)(rng() % 440), cy = 80 + (int)(rng() % 320), radius = 20 + (int)(rng() % 60);
+		for(int y = 0; y < img.rows; ++y) {
+			std::uint8_t* p = img.ptr<std::uint8_t>(y);
+			for(int x = 0; x < img.cols; ++x, p += 3) {
+				bool blob = (x - cx) * (x - cx) + (y - cy) * (y - cy) < radius * radius;
+				int b = blob ? 30 : 120 - y / 8, g = blob ? 110 : 100 - y / 10, r = blob ? 230 : 25;
+				p[0] = cv::saturate_cast<std::uint8_t>(b + noise(rng));
+				p[1] = cv::saturate_cast<std::uint8_t>(g + noise(rng));
+				p[2] = cv::saturate_cast<std::uint8_t>(r + noise(rng));
+			}
+		}
+		frames.push_back(img);
+	}
+	return frames;
+}
+
+static std::vector<cv::Mat> sourceFrames(const std::string& spec, int count) {
+	std::vector<cv::Mat> frames;
+	std::unique_ptr<vision::FrameSource> source = vision::openSource(spec);
+	cv::Mat frame;
+	while((int)frames.size() < count && source->isOpened() && source->read(frame)) frames.push_back(frame.clone());
+	return frames;
+}
+
+template<typename F>
+static double msPerFrame(const std::vector<cv::Mat>& frames, int repeats, F f) {
+	clock_type::time_point start = clock_type::now();
+	for(int r = 0; r < repeats; ++r) {
+		for(const cv::Mat& frame : frames) f(frame);
+	}
+	return std::chrono::duration<double, std::milli>(clock_type::now() - start).count() / (repeats * frames.size());
+}
+
+int main(int argc, char* argv[]) {
+	int frame_count = (argc > 2 ? std::atoi(argv[2]) : 30);
+	std::vector<cv::Mat> frames = (argc > 1 ? sourceFrames(argv[1], frame_count) : syntheticFrames(frame_count));
+	if(frames.empty()) {
+		std::printf("no frames from %s\n", argv[1]);
+		return 1;
+	}
+
+	std::printf("kernel path: %s\n", vision::hsvKernelPath());
+	std::printf("checking against cvtColor + inRange, %zu bound sets:\n", check_bounds.size());
+	long bad = check("all 2^24 colours", allColours());
+	bad += check("frames", frames[0]);
+	bad += check("odd width (637 columns)", frames[0](cv::Rect(1, 1, 637, frames[0].rows - 2)));
+	if(bad != 0) {
+		std::printf("%ld pixels differ\n", bad);
+		return 1;
+	}
+
+	const Bounds& heading = check_bounds[0];
+	vision::HSVRange range = toRange(heading);
+	cv::Mat hsv, mask;
+	const int repeats = 20;
+
+	double cv_ms = msPerFrame(frames, repeats, [&](const cv::Mat& f) { reference(f, heading, hsv, mask); });
+	double scalar_ms = msPerFrame(frames, repeats, [&](const cv::Mat& f) { fused(f, range, mask, vision::hsvThresholdRowScalar); });
+	double fused_ms = msPerFrame(frames, repeats, [&](const cv::Mat& f) { fused(f, range, mask, vision::hsvThresholdRow); });
+
+	std::printf("%d x %d, %zu frames x %d, heading bounds:\n", frames[0].cols, frames[0].rows, frames.size(), repeats);
+	std::printf("  %-34s %8.3f ms/frame\n", "cvtColor + inRange", cv_ms);
+	std::printf("  %-34s %8.3f ms/frame  %.2fx\n", "fused, scalar", scalar_ms, cv_ms / scalar_ms);
+	std::printf("  %-34s %8.3f ms/frame  %.2fx\n", (std::string("fused, ") + vision::hsvKernelPath()).c_str(), fused_ms, cv_ms / fused_ms);
+	return 0;
+}
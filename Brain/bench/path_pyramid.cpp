@@ -0,0 +1,130 @@
+/*
+Runs the path detector (vision::configurePath) at full resolution and in pyramid
+mode on the same frames, and reports the time per frame of each and how far
+apart their answers are.
+
+usage: make bench, or bin/path_pyramid [source] [levels] [max_frames]
+	bin/path_pyramid ~/robosub/frames/path_run1/ 2
+	with no source, 640x480 frames of a bent orange path on noisy blue-green water
+	are synthesized, so it runs without any recordings
+	levels is how many times the coarse search halves the frame, 1 or 2 (default)
+
+Accuracy is the pyramid result measured against the full resolution one, per
+frame: whether both found a path, the distance between their path ends and the
+difference in path angle.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Vision/VisionPipeline.hpp"
+
+static std::vector<cv::Mat> syntheticFrames(int count) {
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::uniform_int_distribution<int> noise(-12, 12);
+	std::vector<cv::Mat> frames;
+
+	for(int f = 0; f < count; ++f) {
+		cv::Mat img(480, 640, CV_8UC3);
+		for(int y = 0; y < img.rows; ++y) {
+			std::uint8_t* p = img.ptr<std::uint8_t>(y);
+			for(int x = 0; x < img.cols; ++x, p += 3) {
+				p[0] = cv::saturate_cast<std::uint8_t>(120 - y / 8 + noise(rng));
+				p[1] = cv::saturate_cast<std::uint8_t>(100 - y / 10 + noise(rng));
+				p[2] = cv::saturate_cast<std::uint8_t>(25 + noise(rng));
+			}
+		}
+
+		// two straight sections with a bend between them, like the path markers
+		cv::Point2f bend(200 + 240 * unit(rng), 160 + 160 * unit(rng));
+		double a1 = CV_PI / 2 + (unit(rng) - 0.5) * 0.6;
+		double a2 = a1 + CV_PI + (unit(rng) < 0.5 ? -1 : 1) * (0.4 + 0.4 * unit(rng));
+		for(double a : { a1, a2 }) {
+			cv::Point2f dir(std::cos(a), std::sin(a)), side(-dir.y * 20, dir.x * 20);
+			cv::Point2f end = bend + dir * (150 + 60 * unit(rng));
+			cv::Point corners[4] = { bend + side, end + side, end - side, bend - side };
+			cv::fillConvexPoly(img, corners, 4, cv::Scalar(30, 110, 230));
+		}
+		frames.push_back(img);
+	}
+	return frames;
+}
+
+static std::vector<cv::Mat> sourceFrames(const std::string& spec, unsigned long max_frames) {
+	std::vector<cv::Mat> frames;
+	std::unique_ptr<vision::FrameSource> source = vision::openSource(spec);
+	cv::Mat frame;
+	while((max_frames == 0 || frames.size() < max_frames) && source->isOpened() && source->read(frame)) frames.push_back(frame.clone());
+	return frames;
+}
+
+static double endDistance(const vision::Detection& a, const vision::Detection& b) {
+	// ends are ordered by height, which can flip on a near horizontal path, so take the better pairing
+	double same = std::max(cv::norm(a.path_ends[0] - b.path_ends[0]), cv::norm(a.path_ends[1] - b.path_ends[1]));
+	double swapped = std::max(cv::norm(a.path_ends[0] - b.path_ends[1]), cv::norm(a.path_ends[1] - b.path_ends[0]));
+	return std::min(same, swapped);
+}
+
+static double angleDifference(double a, double b) {
+	double diff = std::fabs(a - b);
+	return std::min(diff, 180 - diff);
+}
+
+int main(int argc, char* argv[]) {
+	int levels = (argc > 2 ? std::atoi(argv[2]) : 2);
+	unsigned long max_frames = (argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0);
+	std::vector<cv::Mat> frames = (argc > 1 ? sourceFrames(argv[1], max_frames) : syntheticFrames(max_frames > 0 ? max_frames : 60));
+	if(frames.empty()) {
+		std::printf("no frames from %s\n", argv[1]);
+		return 1;
+	}
+
+	vision::Pipeline full, pyramid;
+	vision::configurePath(full);
+	vision::configurePath(pyramid, levels);
+
+	const int repeats = (argc > 1 ? 1 : 5);
+	unsigned long both = 0, full_only = 0, pyramid_only = 0;
+	double end_total = 0, end_max = 0, angle_total = 0, angle_max = 0;
+
+	for(int r = 0; r < repeats; ++r) {
+		for(const cv::Mat& frame : frames) {
+			full.frame().input = frame;
+			pyramid.frame().input = frame;
+			const vision::Detection& a = full.process();
+			const vision::Detection& b = pyramid.process();
+			if(r > 0) continue; // later rounds are for timing only
+
+			bool found_a = a.path_sections > 0, found_b = b.path_sections > 0;
+			if(found_a && found_b) {
+				++both;
+				double e = endDistance(a, b), g = angleDifference(a.path_angle, b.path_angle);
+				end_total += e;
+				angle_total += g;
+				end_max = std::max(end_max, e);
+				angle_max = std::max(angle_max, g);
+			} else if(found_a) {
+				++full_only;
+			} else if(found_b) {
+				++pyramid_only;
+			}
+		}
+	}
+
+	std::printf("%zu frames (%s), pyramid of %d levels\n", frames.size(), argc > 1 ? argv[1] : "synthetic", levels);
+	std::printf("full resolution: %s", full.report().c_str());
+	std::printf("pyramid:         %s", pyramid.report().c_str());
+	std::printf("speedup %.2fx\n", full.meanFrameMs() / pyramid.meanFrameMs());
+	std::printf("path found by both in %lu, full resolution only %lu, pyramid only %lu\n", both, full_only, pyramid_only);
+	if(both > 0) {
+		std::printf("path ends differ by %.2f px mean, %.2f px max\n", end_total / both, end_max);
+		std::printf("path angle differs by %.2f deg mean, %.2f deg max\n", angle_total / both, angle_max);
+	}
+	return 0;
+}
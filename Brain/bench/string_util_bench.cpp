@@ -0,0 +1,117 @@
+/*
+Times string_util against the std::regex versions it replaced, on lines shaped
+like what USBSerialLink receives from the teensy. Prints the cost per line of
+each operation.
+
+usage: make bench, or bin/string_util_bench [iterations]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "string_util.hpp"
+
+namespace legacy {
+	void splitOnChar(const std::string& s, const char delim, std::vector<std::string>& v) {
+		std::size_t pos = s.find(delim);
+		if(pos == std::string::npos) {
+			v.push_back(s);
+		} else {
+			int i = 0;
+			while (pos != std::string::npos) {
+				v.push_back(s.substr(i, pos-i));
+				i = ++pos;
+				pos = s.find(delim, pos);
+
+				if (pos == std::string::npos)
+					v.push_back(s.substr(i, s.length()));
+			}
+		}
+	}
+
+	std::string removeWhitespace(const std::string& s) {
+		return std::regex_replace( s, std::regex("\\s+"), "" );
+	}
+
+	std::string trim(const std::string& s) {
+		std::string trimmed_start = std::regex_replace(s, std::regex("^\\s+"), "");
+		return std::regex_replace(trimmed_start, std::regex("\\s+$"), "");
+	}
+}
+
+using clock_type = std::chrono::steady_clock;
+
+static const std::vector<std::string> lines = {
+	"~~data_pressure~d~1013.250000\r",
+	"  ~~data_imu~d[]~12.500000,-3.250000,179.125000\r",
+	"~~mode~s~SAFE\r",
+	"INFO log.sensors...\r",
+	"~~thrusters_enabled~b~true \r",
+	"\r",
+};
+
+static std::size_t sink = 0; // keeps results alive
+
+template<typename F>
+void run(const char* name, long iterations, F f) {
+	clock_type::time_point start = clock_type::now();
+	for(long i = 0; i < iterations; ++i) {
+		for(const std::string& line : lines) f(line);
+	}
+	double ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+	std::printf("%-28s %10.1f ns/line\n", name, ns / (iterations * lines.size()));
+}
+
+int main(int argc, char* argv[]) {
+	long iterations = argc > 1 ? std::atol(argv[1]) : 20000;
+
+	// same answers before timing anything
+	for(const std::string& line : lines) {
+		std::vector<std::string> a, b;
+		legacy::splitOnChar(line, '~', a);
+		string_util::splitOnChar(line, '~', b);
+		if(legacy::trim(line) != string_util::trim(line).str() || legacy::removeWhitespace(line) != string_util::removeWhitespace(line) || a != b) {
+			std::printf("MISMATCH on '%s'\n", line.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("%zu lines x %ld iterations\n", lines.size(), iterations);
+
+	run("trim (regex)", iterations, [](const std::string& l) { sink += legacy::trim(l).size(); });
+	run("trim", iterations, [](const std::string& l) { sink += string_util::trim(l).size(); });
+
+	run("removeWhitespace (regex)", iterations, [](const std::string& l) { sink += legacy::removeWhitespace(l).size(); });
+	run("removeWhitespace", iterations, [](const std::string& l) { sink += string_util::removeWhitespace(l).size(); });
+
+	run("splitOnChar (substr)", iterations, [](const std::string& l) {
+		std::vector<std::string> v;
+		legacy::splitOnChar(l, '~', v);
+		sink += v.size();
+	});
+	run("split", iterations, [](const std::string& l) {
+		for(string_util::StringView f : string_util::split(l, '~')) sink += f.size();
+	});
+
+	// what USBSerialLink does with each line before storing the value
+	run("line (regex + substr)", iterations, [](const std::string& l) {
+		std::string line = legacy::trim(l);
+		if(line.find("~~") == 0) {
+			std::vector<std::string> fields;
+			legacy::splitOnChar(line.substr(2), '~', fields);
+			sink += fields.size();
+		}
+	});
+	run("line (views)", iterations, [](const std::string& l) {
+		string_util::StringView line = string_util::trim(l);
+		if(line.startsWith("~~")) {
+			for(string_util::StringView f : string_util::split(line.substr(2), '~')) sink += f.size();
+		}
+	});
+
+	return sink == 0; // never true, but the compiler can't know that
+}
@@ -0,0 +1,261 @@
+/*
+Checks the telemetry frame decoder (TelemetryFrame.hpp) on frames built here
+from the layout in the teensy's Telemetry.h, then times it:
+	- every field comes back out, including negative powers and the CRC
+	- a wrong sync, version, length or CRC is refused, a short frame waits for more
+	- consume() pulls frames out of a stream of text lines the way USBSerialLink
+	  gets it, with the stream cut into reads at every possible byte, a frame in
+	  the middle of a line, and garbage and half frames to resync past
+	- SequenceTracker counts the gaps in seq, and a teensy reset isn't a loss
+Then prints the cost per frame of decode() and of consume() on a second of
+200 Hz frames with the odd reply line in between.
+
+usage: make bench, or bin/telemetry_frame_bench [seconds]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Comms/TelemetryFrame.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const std::string& detail = "") {
+	if(ok) return;
+	++failures;
+	std::printf("FAIL %s%s%s\n", what, detail.empty() ? "" : ": ", detail.c_str());
+}
+
+// ********************************
+// Frames as the teensy writes them
+// ********************************
+
+static void put16(std::string& s, std::uint16_t v) {
+	s += (char)(v & 0xFF);
+	s += (char)(v >> 8);
+}
+static void put32(std::string& s, std::uint32_t v) {
+	put16(s, (std::uint16_t)(v & 0xFFFF));
+	put16(s, (std::uint16_t)(v >> 16));
+}
+static void putf(std::string& s, float f) {
+	std::uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(bits));
+	put32(s, bits);
+}
+
+static telemetry::Frame sample(std::uint32_t seq) {
+	telemetry::Frame f;
+	f.seq = seq;
+	f.time_ms = 1000 + 5 * seq;
+	f.pressure = 1013.25f + 0.01f * (seq % 100);
+	f.temperature = 21.5f;
+	f.yaw = -179.5f;
+	f.pitch = 3.25f;
+	f.roll = -0.125f;
+	for(int i = 0; i < telemetry::AXES; ++i) f.pid_out[i] = -2.5f + i;
+	for(int i = 0; i < telemetry::THRUSTERS; ++i) f.power[i] = (std::int8_t)(i % 2 ? -100 + i : 100 - i);
+	f.pid_auto = 0x0B;
+	f.flags = seq % 4 == 0 ? telemetry::FRESH_PRESSURE : 0;
+	f.kill_adc = 4095;
+	return f;
+}
+
+static std::string encode(const telemetry::Frame& f) {
+	std::string s;
+	s += (char)telemetry::SYNC0;
+	s += (char)telemetry::SYNC1;
+	s += (char)telemetry::VERSION;
+	s += (char)telemetry::FRAME_SIZE;
+	put32(s, f.seq);
+	put32(s, f.time_ms);
+	for(float v : { f.pressure, f.temperature, f.yaw, f.pitch, f.roll }) putf(s, v);
+	for(float v : f.pid_out) putf(s, v);
+	for(std::int8_t p : f.power) s += (char)p;
+	s += (char)f.pid_auto;
+	s += (char)f.flags;
+	put16(s, f.kill_adc);
+	put16(s, telemetry::crc16((const std::uint8_t*)s.data(), s.size()));
+	return s;
+}
+
+static bool same(const telemetry::Frame& a, const telemetry::Frame& b) {
+	bool eq = a.seq == b.seq && a.time_ms == b.time_ms && a.pressure == b.pressure && a.temperature == b.temperature
+		&& a.yaw == b.yaw && a.pitch == b.pitch && a.roll == b.roll && a.pid_auto == b.pid_auto && a.flags == b.flags && a.kill_adc == b.kill_adc;
+	for(int i = 0; i < telemetry::AXES; ++i) eq = eq && a.pid_out[i] == b.pid_out[i];
+	for(int i = 0; i < telemetry::THRUSTERS; ++i) eq = eq && a.power[i] == b.power[i];
+	return eq;
+}
+
+static telemetry::Result decode(const std::string& bytes, telemetry::Frame& f) {
+	return telemetry::decode((const std::uint8_t*)bytes.data(), bytes.size(), f);
+}
+
+// ********************************
+// Stream
+// ********************************
+
+struct Collected {
+	std::vector<std::string> lines;
+	std::vector<telemetry::Frame> frames;
+};
+
+// feeds the stream through consume() in reads of the given sizes, repeating the pattern
+static Collected feed(const std::string& stream, const std::vector<std::size_t>& reads) {
+	Collected c;
+	std::string input;
+	std::size_t at = 0;
+	for(std::size_t r = 0; at < stream.size(); ++r) {
+		std::size_t n = reads[r % reads.size()];
+		input.append(stream, at, n);
+		at += n;
+		telemetry::consume(input,
+			[&c](string_util::StringView line) { c.lines.push_back(line.str()); },
+			[&c](const telemetry::Frame& f) { c.frames.push_back(f); });
+	}
+	return c;
+}
+
+static void checkStream(void) {
+	// what the teensy sends after "log telemetry start": frames, with whole reply lines in between
+	std::string stream = "CMD config.log.telemetry.start -> Logging for telemetry enabled.\r\n";
+	std::vector<std::string> lines = { "CMD config.log.telemetry.start -> Logging for telemetry enabled.\r" };
+	std::vector<telemetry::Frame> frames;
+	for(std::uint32_t seq = 0; seq < 12; ++seq) {
+		frames.push_back(sample(seq));
+		stream += encode(frames.back());
+		if(seq == 5) {
+			stream += "~~data_pressure~d~1013.250000\r\n";
+			lines.push_back("~~data_pressure~d~1013.250000\r");
+		}
+	}
+	// a frame cutting a line in two, which the teensy doesn't do but a line is still a line
+	frames.push_back(sample(12));
+	stream += "CMD config.pid.pressure.read: " + encode(frames.back()) + "1013.25\r\n";
+	lines.push_back("CMD config.pid.pressure.read: 1013.25\r");
+	stream += "INFO log.sensors"; // left unfinished
+
+	for(std::size_t n = 1; n <= stream.size(); ++n) {
+		Collected c = feed(stream, { n });
+		bool ok = c.lines == lines && c.frames.size() == frames.size();
+		for(std::size_t i = 0; ok && i < frames.size(); ++i) ok = same(c.frames[i], frames[i]);
+		if(!ok) {
+			check(false, "stream read in pieces of", std::to_string(n) + " bytes, " + std::to_string(c.frames.size()) + " frames and "
+				+ std::to_string(c.lines.size()) + " lines");
+			break;
+		}
+	}
+
+	// the partial line stays for the next read
+	std::string input = stream;
+	telemetry::consume(input, [](string_util::StringView) {}, [](const telemetry::Frame&) {});
+	check(input == "INFO log.sensors", "partial line kept", input);
+
+	// garbage, a frame cut off by a reset and a frame with a bad CRC are passed over and the frames after them found
+	std::string good = encode(sample(40));
+	std::string bad_crc = encode(sample(41));
+	bad_crc[20] ^= 0x01;
+	std::string junk = std::string("\xA5\xA5\x5A\x01", 4) + good.substr(0, 30) + bad_crc + "\r\n" + good + encode(sample(0)) + "INFO booted\r\n";
+	Collected c = feed(junk, { 7, 1, 64, 3 });
+	check(c.frames.size() == 2 && c.frames[0].seq == 40 && c.frames[1].seq == 0, "resync after garbage", std::to_string(c.frames.size()) + " frames");
+	check(!c.lines.empty() && c.lines.back() == "INFO booted\r", "line after garbage");
+}
+
+// ********************************
+// Frames one at a time
+// ********************************
+
+static void checkDecode(void) {
+	telemetry::Frame in = sample(0x12345678);
+	std::string bytes = encode(in);
+	check(bytes.size() == telemetry::FRAME_SIZE, "frame size", std::to_string(bytes.size()));
+
+	telemetry::Frame out;
+	check(decode(bytes, out) == telemetry::Result::Ok && same(in, out), "round trip");
+
+	for(std::size_t n = 1; n < telemetry::FRAME_SIZE; ++n) {
+		if(decode(bytes.substr(0, n), out) != telemetry::Result::NeedMore) check(false, "short frame waits for more", std::to_string(n) + " bytes");
+	}
+	for(std::size_t at : { 1, 2, 3 }) {
+		std::string wrong = bytes;
+		++wrong[at];
+		check(decode(wrong.substr(0, at + 1), out) == telemetry::Result::Bad, "header refused before the rest arrives", std::to_string(at));
+	}
+	for(std::size_t at = 4; at < telemetry::FRAME_SIZE; ++at) {
+		for(int bit = 0; bit < 8; ++bit) {
+			std::string flipped = bytes;
+			flipped[at] ^= (char)(1 << bit);
+			if(decode(flipped, out) != telemetry::Result::Bad) check(false, "single bit error caught", std::to_string(at) + "." + std::to_string(bit));
+		}
+	}
+
+	// check value from the CRC-16/CCITT-FALSE catalogue
+	check(telemetry::crc16((const std::uint8_t*)"123456789", 9) == 0x29B1, "crc16 check value");
+}
+
+static void checkSequence(void) {
+	telemetry::SequenceTracker t;
+	std::uint32_t gaps = 0;
+	for(std::uint32_t seq : { 100, 101, 102, 105, 106, 110 }) gaps += t.update(seq);
+	check(gaps == 5 && t.lost() == 5 && t.received() == 6, "gaps counted", std::to_string(t.lost()));
+	check(t.update(0) == 0 && t.update(1) == 0 && t.lost() == 5, "teensy reset isn't a loss");
+	check(t.update(0xFFFFFFFF) == 0xFFFFFFFD && t.update(0) == 0, "seq wraps");
+}
+
+// ********************************
+// Timing
+// ********************************
+
+int main(int argc, char* argv[]) {
+	int seconds = argc > 1 ? std::atoi(argv[1]) : 200;
+
+	checkDecode();
+	checkSequence();
+	checkStream();
+	std::printf("decode and stream: %s\n", failures == 0 ? "ok" : "FAILED");
+
+	// a second of frames at 200 Hz and a reply now and then, read 64 bytes at a time as from the port
+	std::string second;
+	for(std::uint32_t seq = 0; seq < 200; ++seq) {
+		second += encode(sample(seq));
+		if(seq % 50 == 0) second += "CMD config.pid.yaw -> 12.50\r\n";
+	}
+	std::vector<std::uint8_t> frame_bytes;
+	for(std::uint32_t seq = 0; seq < 200; ++seq) {
+		std::string f = encode(sample(seq));
+		frame_bytes.insert(frame_bytes.end(), f.begin(), f.end());
+	}
+
+	std::uint64_t sink = 0;
+	telemetry::Frame f;
+	clock_type::time_point start = clock_type::now();
+	for(int s = 0; s < seconds; ++s) {
+		for(std::size_t at = 0; at < frame_bytes.size(); at += telemetry::FRAME_SIZE) {
+			sink += telemetry::decode(frame_bytes.data() + at, telemetry::FRAME_SIZE, f) == telemetry::Result::Ok ? f.seq : 0;
+		}
+	}
+	double decode_ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / (seconds * 200.0);
+
+	std::string input;
+	input.reserve(256);
+	start = clock_type::now();
+	for(int s = 0; s < seconds; ++s) {
+		for(std::size_t at = 0; at < second.size(); at += 64) {
+			input.append(second, at, 64);
+			telemetry::consume(input, [&sink](string_util::StringView line) { sink += line.size(); }, [&sink](const telemetry::Frame& fr) { sink += fr.seq; });
+		}
+	}
+	double consume_ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count() / (seconds * 200.0);
+
+	std::printf("%d s of 200 Hz frames, host ns per frame\n", seconds);
+	std::printf("  %-24s %8.1f\n", "decode()", decode_ns);
+	std::printf("  %-24s %8.1f\n", "consume(), 64 byte reads", consume_ns);
+
+	return failures == 0 && sink != 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+Runs the heading pipeline headless over a video file, image directory, glob
+pattern or camera and reports frames per second and time per stage. No camera
+or display needed, so it runs anywhere Brain builds.
+
+usage: bin/vision_fps <source> [max_frames] [workers] [tracking]
+	bin/vision_fps ~/robosub/frames/gate_run1/
+	bin/vision_fps gate.avi 500
+	bin/vision_fps 0 600 2
+	bin/vision_fps gate.avi 500 0 0    ~ serial, whole frame every time
+With workers > 0 the threaded capture/process/publish pipeline (action::FramePipeline)
+is used instead, and the age of the frame behind each result is reported. A file
+source is read as fast as it decodes there, so expect dropped frames - that is the
+"latest frame wins" policy at work, not lost throughput.
+A camera never runs out (a missed frame is retried, not the end of the stream), so
+give it max_frames when threaded or it runs until interrupted.
+ROI tracking (see VisionPipeline.hpp) is on unless tracking is 0, run both ways
+on the same frames to see what it saves.
+With no source it prints usage and exits cleanly, so 'make bench' can run it.
+*/
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+
+#include "Vision/VisionPipeline.hpp"
+#include "ThreadManager.hpp"
+#include "Actions.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+class BenchOwner : public NamedClass {
+public:
+	BenchOwner() : NamedClass("vision_fps", "bench") {}
+};
+
+int runSerial(const std::string& spec, unsigned long max_frames, bool tracking) {
+	std::unique_ptr<vision::FrameSource> source = vision::openSource(spec);
+	if(!source->isOpened()) return 1;
+
+	vision::Pipeline pipeline;
+	vision::configureHeading(pipeline);
+	pipeline.setTracking(tracking);
+
+	unsigned long found = 0;
+	while(pipeline.step(*source)) {
+		if(pipeline.frame().detection.found) ++found;
+		if(max_frames > 0 && pipeline.frameCount() >= max_frames) break;
+	}
+
+	std::cout << source->getDescription() << "\n" << pipeline.report();
+	std::cout << "target found in " << found << " of " << pipeline.frameCount() << " frames" << std::endl;
+	return 0;
+}
+
+int runThreaded(const std::string& spec, unsigned long max_frames, int worker_count, bool tracking) {
+	ThreadManager thread_manager;
+	BenchOwner owner;
+	action::FramePipeline vision(worker_count);
+	vision.capture().setSource(spec);
+
+	thread_manager.load(owner, vision.capture(), "capture", th_man::RunLevel::Worker);
+	for(int i = 0; i < vision.workerCount(); ++i) vision.worker(i).setTracking(tracking);
+	for(int i = 0; i < vision.workerCount(); ++i) thread_manager.load(owner, vision.worker(i), "vision " + std::to_string(i), th_man::RunLevel::Worker);
+
+	unsigned long found = 0;
+	double age_total_ms = 0, age_max_ms = 0;
+	vision::Detection d;
+	clock_type::time_point idle_since = clock_type::now();
+
+	for(;;) {
+		thread_manager.resume(vision.capture());
+		for(int i = 0; i < vision.workerCount(); ++i) thread_manager.resume(vision.worker(i));
+
+		if(vision.latest(d)) {
+			double age_ms = std::chrono::duration<double, std::milli>(clock_type::now() - d.captured).count();
+			age_total_ms += age_ms;
+			if(age_ms > age_max_ms) age_max_ms = age_ms;
+			if(d.found) ++found;
+			idle_since = clock_type::now();
+			if(max_frames > 0 && vision.published() >= max_frames) break;
+		} else if(vision.capture().finished() && clock_type::now() - idle_since > std::chrono::milliseconds(500)) {
+			break; // source ran out and the workers have gone quiet
+		} else {
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	}
+
+	thread_manager.unloadAllFromParent(owner);
+
+	unsigned long results = vision.published();
+	std::cout << spec << " with " << worker_count << " workers\n";
+	std::cout << vision.capture().captured() << " captured, " << vision.capture().dropped() << " dropped, " << results << " published, " << d.fps << " fps\n";
+	std::cout << "frame age at publish: " << (results > 0 ? age_total_ms / results : 0) << " ms mean, " << age_max_ms << " ms max\n";
+	std::cout << "target found in " << found << " of " << results << " results" << std::endl;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(200)); // let the threads finish cleanUp before their objects go away
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	if(argc < 2) {
+		std::cout << "usage: " << argv[0] << " <camera index | video file | image dir | pattern> [max_frames] [workers]" << std::endl;
+		return 0;
+	}
+	unsigned long max_frames = (argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0);
+	int workers = (argc > 3 ? std::atoi(argv[3]) : 0);
+	bool tracking = (argc > 4 ? std::atoi(argv[4]) != 0 : true);
+
+	if(workers > 0) return runThreaded(argv[1], max_frames, workers, tracking);
+	return runSerial(argv[1], max_frames, tracking);
+}
@@ -0,0 +1,291 @@
+/*
+Headless regression run of a vision pipeline over recorded frames: throughput,
+latency of each stage, and accuracy against a labels file. Exits non-zero when
+a limit given on the command line isn't met, so it can gate a change before it
+goes in the pool.
+
+usage: bin/vision_regress <pipeline> <source> [labels] [options]
+	pipeline  heading, path or path_pyramid (see vision::configure)
+	source    video file, image directory or pattern (see vision::openSource)
+	labels    ground truth, see below
+options:
+	--max-error <px>      a detection further than this from the label counts as misplaced (20)
+	--min-accuracy <0-1>  fail below this accuracy
+	--min-fps <fps>       fail below this processing rate
+	--max-frames <n>      stop after n frames
+	--tracking            run with ROI tracking on
+	--budget <ms>         let the pipeline trade quality for time over this budget per frame, see QualityGovernor
+	--record <file>       write what was detected as a labels file, to start a new set of labels
+	                      from or to compare a change against the current behaviour
+
+'make regress' runs it with REGRESS_PIPELINE, REGRESS_SOURCE, REGRESS_LABELS and REGRESS_ARGS.
+With no arguments it prints usage and exits cleanly, so 'make bench' can run it.
+
+Labels file, one frame per line, # starts a comment:
+	<frame> <found 0|1> [x y [angle]]
+	img_0001.png 1 322 241
+	img_0002.png 0
+	path_017.png 1 310 250 84.5
+<frame> is the file name (no directory) for image sources, and the frame number
+counting from 1 for video. x y is the target center in pixels, angle is
+Detection::path_angle in degrees for the path pipelines. Frames without a
+line aren't counted for accuracy.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Vision/VisionPipeline.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+struct Label {
+	bool found;
+	cv::Point2f center;
+	bool has_angle;
+	double angle;
+};
+
+struct Options {
+	std::string pipeline;
+	std::string source;
+	std::string labels;
+	std::string record;
+	double max_error = 20;
+	double min_accuracy = 0;
+	double min_fps = 0;
+	unsigned long max_frames = 0;
+	double budget = 0;
+	bool tracking = false;
+};
+
+static void usage(const char* argv0) {
+	std::printf("usage: %s <heading | path | path_pyramid> <video | image dir | pattern> [labels] [--max-error px] "
+		"[--min-accuracy 0-1] [--min-fps n] [--max-frames n] [--tracking] [--budget ms] [--record file]\n", argv0);
+}
+
+static bool parseArgs(int argc, char* argv[], Options& o) {
+	o.pipeline = argv[1];
+	o.source = argv[2];
+	for(int i = 3; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = (i + 1 < argc);
+		if(arg == "--tracking") {
+			o.tracking = true;
+		} else if(arg == "--max-error" && has_value) {
+			o.max_error = std::atof(argv[++i]);
+		} else if(arg == "--min-accuracy" && has_value) {
+			o.min_accuracy = std::atof(argv[++i]);
+		} else if(arg == "--min-fps" && has_value) {
+			o.min_fps = std::atof(argv[++i]);
+		} else if(arg == "--max-frames" && has_value) {
+			o.max_frames = std::strtoul(argv[++i], nullptr, 10);
+		} else if(arg == "--budget" && has_value) {
+			o.budget = std::atof(argv[++i]);
+		} else if(arg == "--record" && has_value) {
+			o.record = argv[++i];
+		} else if(arg.compare(0, 2, "--") != 0 && o.labels.empty()) {
+			o.labels = arg;
+		} else {
+			std::printf("unknown or incomplete option '%s'\n", arg.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool loadLabels(const std::string& path, std::unordered_map<std::string, Label>& labels) {
+	std::ifstream in(path);
+	if(!in) return false;
+
+	std::string line;
+	int line_number = 0;
+	while(std::getline(in, line)) {
+		++line_number;
+		std::size_t hash = line.find('#');
+		if(hash != std::string::npos) line.erase(hash);
+
+		std::istringstream fields(line);
+		std::string name;
+		int found;
+		if(!(fields >> name)) continue; // blank
+		if(!(fields >> found)) {
+			std::printf("%s:%d: expected <frame> <found> [x y [angle]]\n", path.c_str(), line_number);
+			return false;
+		}
+
+		Label l = { found != 0, cv::Point2f(0, 0), false, 0 };
+		if(l.found && !(fields >> l.center.x >> l.center.y)) {
+			std::printf("%s:%d: a found target needs x y\n", path.c_str(), line_number);
+			return false;
+		}
+		l.has_angle = l.found && static_cast<bool>(fields >> l.angle);
+		labels[name] = l;
+	}
+	return true;
+}
+
+static double percentile(std::vector<double>& v, double p) {
+	if(v.empty()) return 0;
+	std::size_t i = std::min(v.size() - 1, (std::size_t)(p * (v.size() - 1) + 0.5));
+	std::nth_element(v.begin(), v.begin() + i, v.end());
+	return v[i];
+}
+
+static double mean(const std::vector<double>& v) {
+	double total = 0;
+	for(double x : v) total += x;
+	return (v.empty() ? 0 : total / v.size());
+}
+
+static void latencyRow(const std::string& name, std::vector<double>& ms) {
+	double avg = mean(ms);
+	double p50 = percentile(ms, 0.5), p90 = percentile(ms, 0.9), p99 = percentile(ms, 0.99), max = percentile(ms, 1);
+	std::printf("  %-16s %8.3f %8.3f %8.3f %8.3f %8.3f\n", name.c_str(), p50, p90, p99, max, avg);
+}
+
+static std::string baseName(const std::string& path) {
+	std::size_t slash = path.find_last_of('/');
+	return (slash == std::string::npos ? path : path.substr(slash + 1));
+}
+
+int main(int argc, char* argv[]) {
+	if(argc < 3) {
+		usage(argv[0]);
+		return (argc == 1 ? 0 : 2);
+	}
+
+	Options o;
+	if(!parseArgs(argc, argv, o)) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	vision::Pipeline pipeline;
+	if(!vision::configure(pipeline, o.pipeline)) {
+		std::printf("no pipeline called '%s'\n", o.pipeline.c_str());
+		return 2;
+	}
+	pipeline.setTracking(o.tracking);
+	pipeline.setFrameBudget(o.budget);
+
+	std::unordered_map<std::string, Label> labels;
+	if(!o.labels.empty() && !loadLabels(o.labels, labels)) {
+		std::printf("could not read labels from %s\n", o.labels.c_str());
+		return 2;
+	}
+
+	std::unique_ptr<vision::FrameSource> source = vision::openSource(o.source);
+	if(!source->isOpened()) return 2;
+	vision::ImageSequenceSource* images = dynamic_cast<vision::ImageSequenceSource*>(source.get());
+
+	std::ofstream record;
+	if(!o.record.empty()) {
+		record.open(o.record);
+		record << "# vision_regress " << o.pipeline << " " << o.source << "\n# <frame> <found> [x y [angle]]\n";
+	}
+
+	const std::vector<vision::Pipeline::StageTiming>& stages = pipeline.stageTimings();
+	std::vector<std::vector<double>> stage_ms(stages.size());
+	std::vector<double> frame_ms;
+
+	unsigned long labeled = 0, found_right = 0, misplaced = 0, missed = 0, false_found = 0, empty_right = 0;
+	std::vector<double> center_error, angle_error;
+
+	clock_type::time_point start = clock_type::now();
+	while(pipeline.step(*source)) {
+		const vision::Detection& d = pipeline.frame().detection;
+		std::string name = (images ? baseName(images->lastFile()) : std::to_string(d.frame_number));
+
+		for(std::size_t i = 0; i < stages.size(); ++i) stage_ms[i].push_back(stages[i].last_ms);
+		frame_ms.push_back(pipeline.lastFrameMs());
+
+		bool path = (d.path_sections > 0);
+		if(record.is_open()) {
+			record << name << " " << (d.found ? 1 : 0);
+			if(d.found) record << " " << d.center.x << " " << d.center.y;
+			if(path) record << " " << d.path_angle;
+			record << "\n";
+		}
+
+		std::unordered_map<std::string, Label>::const_iterator l = labels.find(name);
+		if(l != labels.end()) {
+			++labeled;
+			const Label& label = l->second;
+			if(label.found && d.found) {
+				double error = cv::norm(d.center - label.center);
+				center_error.push_back(error);
+				if(error <= o.max_error) ++found_right;
+				else ++misplaced;
+
+				if(label.has_angle && path) {
+					double diff = std::fabs(d.path_angle - label.angle);
+					angle_error.push_back(std::min(diff, 180 - diff));
+				}
+			} else if(label.found) {
+				++missed;
+			} else if(d.found) {
+				++false_found;
+			} else {
+				++empty_right;
+			}
+		}
+
+		if(o.max_frames > 0 && pipeline.frameCount() >= o.max_frames) break;
+	}
+	double wall_sec = std::chrono::duration<double>(clock_type::now() - start).count();
+
+	unsigned long frames = pipeline.frameCount();
+	if(frames == 0) {
+		std::printf("no frames read from %s\n", o.source.c_str());
+		return 2;
+	}
+
+	double processing_fps = 1000.0 / pipeline.meanFrameMs();
+	std::printf("%s on %s, %lu frames%s\n", o.pipeline.c_str(), source->getDescription().c_str(), frames, o.tracking ? ", tracking" : "");
+	std::printf("throughput: %.1f fps processing, %.1f fps with decoding (%.2f s)\n", processing_fps, frames / wall_sec, wall_sec);
+	if(o.tracking) std::printf("tracking: %lu frames from the ROI alone, %lu lost\n", pipeline.roiFrames(), pipeline.lostFrames());
+	if(o.budget > 0) {
+		const vision::QualityGovernor& q = pipeline.quality();
+		std::printf("budget %.1f ms: ended at quality level %d, %lu level changes, %lu frames skipped\n", o.budget, q.level(), q.levelChanges(), q.skipped());
+	}
+
+	std::printf("latency ms              p50      p90      p99      max     mean\n");
+	for(std::size_t i = 0; i < stages.size(); ++i) latencyRow(stages[i].name, stage_ms[i]);
+	latencyRow("frame", frame_ms);
+
+	bool pass = true;
+	if(!o.labels.empty()) {
+		double accuracy = (labeled > 0 ? (double)(found_right + empty_right) / labeled : 0);
+		std::printf("accuracy against %s, %lu of %lu frames labeled, max error %.0f px:\n", o.labels.c_str(), labeled, frames, o.max_error);
+		std::printf("  %lu found, %lu misplaced, %lu missed, %lu found where nothing is, %lu correctly empty\n",
+			found_right, misplaced, missed, false_found, empty_right);
+		std::printf("  accuracy %.2f%%", accuracy * 100);
+		if(!center_error.empty()) std::printf(", center error %.2f px mean, %.2f px p95", mean(center_error), percentile(center_error, 0.95));
+		if(!angle_error.empty()) std::printf(", path angle error %.2f deg mean, %.2f deg max", mean(angle_error), percentile(angle_error, 1));
+		std::printf("\n");
+
+		if(labeled == 0) {
+			std::printf("FAIL: no frame matched a label, check the frame names\n");
+			pass = false;
+		} else if(accuracy < o.min_accuracy) {
+			std::printf("FAIL: accuracy %.4f below %.4f\n", accuracy, o.min_accuracy);
+			pass = false;
+		}
+	}
+	if(processing_fps < o.min_fps) {
+		std::printf("FAIL: %.1f fps below %.1f\n", processing_fps, o.min_fps);
+		pass = false;
+	}
+	if(!o.record.empty()) std::printf("detections written to %s\n", o.record.c_str());
+
+	return (pass ? 0 : 1);
+}
@@ -1,7 +1,16 @@
 #ifndef ACTIONS_H
 #define ACTIONS_H
 
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
 #include "Threadable.hpp"
+#include "Channel.hpp"
+#include "TripleBuffer.hpp"
+#include "Vision/VisionPipeline.hpp"
 
 /*
 This is a library file for commonly used Threadables.
@@ -24,17 +33,93 @@ private:
 */
 
 namespace action {
-	class SearchForQualGate : public Threadable {
+	/*
+	Vision runs as three stages on their own threads so capture never waits on processing:
+		CaptureFrames  ~ reads the source as fast as it delivers and hands each frame to a
+		                 worker through a TripleBuffer - if every worker is busy the newest
+		                 frame replaces the one waiting, so nothing queues up and goes stale
+		ProcessFrames  ~ one Pipeline each, pushes a Detection per frame into a Channel
+		the Task       ~ publishes, via FramePipeline::latest(), which keeps results in
+		                 frame order and skips any that were overtaken by a newer frame
+	FramePipeline owns the threadables and wires them together. The Task loads capture()
+	and every worker(i) and resume()s them every update. Pixels are never copied between
+	threads - Mats are swapped through the buffers, so after the first few frames every
+	thread reuses the same buffers.
+	When the Pi is busy and a worker can't keep up, its Pipeline drops to lower
+	quality levels rather than falling behind (see vision::QualityGovernor).
+	*/
+	class CaptureFrames : public Threadable {
+	public:
+		CaptureFrames();
+
+		// camera index, video file or image directory, see vision::openSource - set before load()
+		void setSource(const std::string& spec) { source_spec = spec; }
+		void addOutput(TripleBuffer<vision::CapturedFrame>& output) { outputs.push_back(&output); }
+
+		void step(void);
+		void cleanUp(void);
+
+		unsigned long captured(void) { return frames_captured.load(); }
+		unsigned long dropped(void) { return frames_dropped.load(); } // replaced before any worker took them
+		bool finished(void) { return source_finished.load(); } // end of a file or sequence, never for a camera
+
+	private:
+		std::string source_spec;
+		std::unique_ptr<vision::FrameSource> source;
+		vision::CapturedFrame frame;
+		std::vector<TripleBuffer<vision::CapturedFrame>*> outputs;
+		std::size_t next_output;
+
+		std::atomic<unsigned long> frames_captured;
+		std::atomic<unsigned long> frames_dropped;
+		std::atomic<bool> source_finished;
+	};
+
+	class ProcessFrames : public Threadable {
 	public:
-		SearchForQualGate() : i(0) {}
+		ProcessFrames();
 
 		void step(void);
 
-		std::string getDirection(void) { return dir; }
+		TripleBuffer<vision::CapturedFrame>& input(void) { return frame_input; }
+		// on by default, only change it before the thread is loaded
+		void setTracking(bool enabled) { pipeline.setTracking(enabled); }
+		// see vision::QualityGovernor, FramePipeline sets it from the camera rate - only change it before the thread is loaded
+		void setFrameBudget(double ms) { pipeline.setFrameBudget(ms); }
+		// one entry per processed frame
+		Channel<vision::Detection, 4>& detections(void) { return detection_channel; }
 
 	private:
-		int i;
-		std::string dir;
+		vision::Pipeline pipeline;
+		TripleBuffer<vision::CapturedFrame> frame_input;
+		Channel<vision::Detection, 4> detection_channel;
+	};
+
+	// time between frames from the camera, at 30 fps
+	const double CAMERA_FRAME_MS = 1000.0 / 30;
+
+	class FramePipeline {
+	public:
+		explicit FramePipeline(int worker_count = 2);
+
+		CaptureFrames& capture(void) { return capture_th; }
+		int workerCount(void) const { return workers.size(); }
+		ProcessFrames& worker(int i) { return *workers[i]; }
+
+		// newest detection from any worker, false if there is nothing newer than the last one returned
+		// fps of the result is the rate at which results come out of the whole pipeline
+		bool latest(vision::Detection& out);
+
+		unsigned long published(void) const { return results; }
+		void resetStats(void);
+
+	private:
+		CaptureFrames capture_th;
+		std::vector<std::unique_ptr<ProcessFrames>> workers;
+
+		unsigned long last_sequence;
+		unsigned long results;
+		std::chrono::steady_clock::time_point first_result;
 	};
 
 	class MoveTowardsQualGate : public Threadable {
@@ -52,9 +137,11 @@ namespace action {
 		void init(void);
 		void step(void);
 
-		std::string getStr() { return input; }
+		// one entry per line read from std::cin
+		Channel<std::string, 16>& lines(void) { return line_channel; }
 	private:
 		std::string input;
+		Channel<std::string, 16> line_channel;
 	};
 }
 
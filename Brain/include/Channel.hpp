@@ -0,0 +1,99 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/*
+Channel is a bounded single producer, single consumer ring buffer for handing
+data from a Threadable to the Task that loaded it without either side blocking.
+
+Polling ThreadManager::status() until a Threadable is Paused and then copying a
+member out only works if the Task and the Threadable take turns. With a Channel
+the Threadable push()es each result as soon as it has one and the Task drains
+whatever is waiting in update() with pop(). Combined with calling resume() every
+update (see ThreadManager), a worker can be computing result N+1 while the Task
+consumes result N.
+
+Rules:
+* exactly one thread may push and exactly one thread may pop
+* push() returns false when the channel is full, the producer decides whether
+to drop the value or try again on its next step
+* pop() returns false when the channel is empty and leaves the argument untouched
+* values are moved in and out, so a std::string result is never copied
+
+Capacity must be a power of two so indexes wrap with a mask. The read and write
+indexes are padded apart so the two threads don't fight over one cache line.
+*/
+
+template<typename T, std::size_t Capacity>
+class Channel {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Channel capacity must be a power of two");
+public:
+	Channel() : head(0), tail(0) {}
+
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+
+	// producer side
+	bool push(const T& value) {
+		return emplace(value);
+	}
+	bool push(T&& value) {
+		return emplace(std::move(value));
+	}
+
+	// consumer side
+	bool pop(T& out) {
+		const std::size_t t = tail.load(std::memory_order_relaxed);
+		if(t == head.load(std::memory_order_acquire)) return false; // empty
+
+		out = std::move(slots[t & mask]);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, discards everything but the most recent value
+	bool popLatest(T& out) {
+		bool got = false;
+		while(pop(out)) got = true;
+		return got;
+	}
+
+	// consumer side, consumer is the only one who can make this false after it is true
+	bool empty() const {
+		return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+	}
+
+	// approximate when called while the other side is active
+	std::size_t size() const {
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+	}
+
+	static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+	static const std::size_t mask = Capacity - 1;
+	static const std::size_t cache_line = 64;
+
+	template<typename U>
+	bool emplace(U&& value) {
+		const std::size_t h = head.load(std::memory_order_relaxed);
+		if(h - tail.load(std::memory_order_acquire) == Capacity) return false; // full
+
+		slots[h & mask] = std::forward<U>(value);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	// indexes increase forever and are masked on use, so full and empty are distinguishable
+	// padding rather than alignas, c++14 operator new doesn't honor over-aligned types
+	std::atomic<std::size_t> head; // written by producer
+	char pad_head[cache_line];
+	std::atomic<std::size_t> tail; // written by consumer
+	char pad_tail[cache_line];
+	T slots[Capacity];
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef CO_TASK_H
+#define CO_TASK_H
+
+#include <string>
+#include <chrono>
+#include <functional>
+
+#include "Task.hpp"
+#include "TimeLord.hpp"
+
+/*
+CoTask is an optional Task base that lets behavior be written top to bottom as a
+stackless coroutine instead of a switch on RunType plus counters and TimeOuts.
+A derived class implements run() between CO_BEGIN() and CO_END(). CO_AWAIT()
+suspends run() until its condition holds, then picks up on the following line.
+
+While a CoTask is suspended, TaskManager::update() asks isAwake() before calling
+update(), so a sleeping task costs a comparison per tick instead of a full update:
+	wait_for(ms)             ~ wakes once a TimeOut on the shared TimerWheel
+	                           expires, no clock reads per task.
+	wait_field<T>(link, field, predicate)
+	                         ~ wakes when the field has data newer than the await
+	                           and predicate(value) is true. The predicate only
+	                           runs when new data arrives.
+	wait_thread(th)          ~ wakes when the Threadable finishes a step or is
+	                           unloaded - resume() it before awaiting
+	yield()                  ~ wakes on the next tick
+
+Init and Normal RunTypes both go to run(), Stop goes to stop() which is where
+commands should be undone. unloadAll() is called after stop().
+
+Because run() returns every time it suspends, LOCAL VARIABLES DO NOT SURVIVE A
+CO_AWAIT - anything needed afterwards must be a member. Two CO_AWAITs may not share
+a line (the line number is the resume point) and CO_AWAIT can't be used inside a
+nested switch.
+
+Example:
+
+class Dive : public CoTask {
+public:
+	explicit Dive(ThreadManager& _t_m, Comms& _c) : CoTask("Dive", _t_m, _c) {}
+protected:
+	const Result run(void) {
+		CO_BEGIN();
+		comms.send("teensy", "cmd", comms_util::Hint::String, std::string("pid pressure 1060"));
+		CO_AWAIT(wait_field<double>("teensy", "data_pressure", [](const double& p) { return p > 1055; }));
+		CO_AWAIT(wait_for(2000));
+		CO_RETURN(ReturnStatus::Success, "At depth");
+		CO_END();
+	}
+	void stop(void) {
+		comms.send("teensy", "cmd", comms_util::Hint::String, std::string("pid pressure stop"));
+	}
+};
+*/
+
+#define CO_BEGIN() switch(resume_point) { default: return Task::Result(Task::ReturnStatus::Continue, ""); case 0:
+#define CO_AWAIT(awaitable) do { resume_point = __LINE__; suspend(awaitable); return Task::Result(Task::ReturnStatus::Continue, ""); case __LINE__:; } while(0)
+#define CO_RETURN(status, message) do { resume_point = -1; return Task::Result(status, message); } while(0)
+#define CO_END() } resume_point = -1; return Task::Result(Task::ReturnStatus::Success, "")
+
+class CoTask : public Task {
+public:
+	CoTask(std::string _instance_name, ThreadManager& _thread_manager, Comms& _comms);
+	virtual ~CoTask() {}
+
+	const Result update(void) final;
+	bool isAwake(const std::chrono::steady_clock::time_point& now) final;
+
+protected:
+	struct Await {
+		enum class Kind { Tick, Time, Field, Thread };
+
+		Kind kind;
+		int milliseconds;
+		std::string link_id, field_name;
+		std::function<bool()> predicate;
+		Threadable* th;
+		unsigned long th_steps; // Threadable::stepCount() when the await started
+	};
+
+	virtual const Result run(void) = 0;
+	virtual void stop(void) {}
+
+	Await yield(void);
+	Await wait_for(int milliseconds);
+	Await wait_thread(Threadable& th);
+	template<typename T>
+	Await wait_field(const std::string& link_id, const std::string& field_name, std::function<bool(const T&)> predicate);
+
+	void suspend(const Await& awaitable);
+
+	int resume_point; // __LINE__ of the CO_AWAIT to continue from, 0 to start, -1 when finished
+
+private:
+	Await waiting;
+	TimeOut wake;
+	std::chrono::steady_clock::time_point field_since;
+};
+
+template<typename T>
+CoTask::Await CoTask::wait_field(const std::string& link_id, const std::string& field_name, std::function<bool(const T&)> predicate) {
+	Await a = yield();
+	a.kind = Await::Kind::Field;
+	a.link_id = link_id;
+	a.field_name = field_name;
+	a.predicate = [this, link_id, field_name, predicate]() {
+		return comms.isSetAs<T>(link_id, field_name) && predicate(comms.get<T>(link_id, field_name));
+	};
+	return a;
+}
+
+#endif
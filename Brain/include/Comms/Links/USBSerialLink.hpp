@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "../CommsLink.hpp"
+#include "../TelemetryFrame.hpp"
 #include "string_util.hpp"
 
 #include <libserialport.h> // c library
@@ -24,6 +25,15 @@ where
 	data is a string, though formatted and parsed according to the Hint associated
 		with the 'type'
 
+The teensy's binary telemetry frames (TelemetryFrame.hpp) come in on the same
+port between the lines. Each one is published as these fields:
+	data_pressure (d), data_temperature (d) - only from frames with a new sample
+	data_orientation (d[]) - yaw, pitch, roll
+	data_pid_out (d[]), data_pid_auto (i) - per axis, yaw pitch roll pressure
+	data_thrusters (i[]) - power per thruster
+	data_kill_adc (i)
+	telemetry_seq (i), telemetry_lost (i) - frames lost since the link opened
+
 */
 
 
@@ -45,6 +55,7 @@ private:
 	std::unordered_map<comms_util::Hint, std::string> hint_strings;
 
 	std::string unparsed_input;
+	telemetry::SequenceTracker telemetry_seq;
 
 	struct sp_port* port;
 
@@ -53,13 +64,15 @@ private:
 	template<typename T>
 	const std::string format(std::vector<T> data);
 
-	std::vector<int> aStoiV(const std::string& s, const char arr_sep);
-	std::vector<double> aStodV(const std::string& s, const char arr_sep);
+	std::vector<int> aStoiV(string_util::StringView s, const char arr_sep);
+	std::vector<double> aStodV(string_util::StringView s, const char arr_sep);
 
 	void transmit(const std::string& field_name, const std::string& type_hint, const std::string formatted_data);
 
-	std::string parse(const std::string& parse_me);
-	comms_util::Hint deduceHint(const std::string& hint_str);
+	void parse(std::string& input); // consumes complete lines and frames, leaves a partial last one
+	void parseLine(string_util::StringView line);
+	void publish(const telemetry::Frame& frame);
+	comms_util::Hint deduceHint(string_util::StringView hint_str);
 };
 
 template<typename T>
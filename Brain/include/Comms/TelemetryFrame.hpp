@@ -0,0 +1,106 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "string_util.hpp"
+
+/*
+Decoder for the binary telemetry frames the teensy sends once per control tick
+after "log telemetry start" (Telemetry.h in the Arduino sketch has the layout).
+
+The frames share the serial stream with the text lines USBSerialLink already
+handles. Text is 7 bit ASCII, so a byte of SYNC0 can only be the start of a
+frame. Every frame is checked by its header and CRC before anything in it is
+used, and a sync byte that doesn't start a good frame is skipped, so the stream
+finds its way back after garbage or a half frame from a reset.
+
+The fields are read a byte at a time as little endian, nothing here depends on
+the Pi laying the struct out the way the teensy does.
+*/
+
+namespace telemetry {
+	const std::uint8_t SYNC0 = 0xA5;
+	const std::uint8_t SYNC1 = 0x5A;
+	const std::uint8_t VERSION = 1;
+	const std::size_t FRAME_SIZE = 60;
+
+	const int AXES = 4; // yaw, pitch, roll, pressure - axis::Id on the teensy
+	const int THRUSTERS = 6; // vert_fl, vert_bl, vert_fr, vert_br, thrust_l, thrust_r - thr::Id on the teensy
+
+	// Frame::flags
+	const std::uint8_t FRESH_PRESSURE = 0x01; // pressure and temperature are a new sample this tick
+
+	struct Frame {
+		std::uint32_t seq;
+		std::uint32_t time_ms; // teensy millis()
+		float pressure; // mbar
+		float temperature; // C
+		float yaw, pitch, roll; // degrees
+		float pid_out[AXES];
+		std::int8_t power[THRUSTERS];
+		std::uint8_t pid_auto; // bit per axis, set when that controller is running
+		std::uint8_t flags;
+		std::uint16_t kill_adc;
+	};
+
+	enum class Result { Ok, NeedMore, Bad };
+
+	// looks for a frame at the start of data, which should hold a SYNC0. NeedMore when what's there
+	// so far could still be a frame, Bad as soon as it can't be
+	Result decode(const std::uint8_t* data, std::size_t size, Frame& frame);
+
+	// CRC-16/CCITT-FALSE, what the teensy seals each frame with
+	std::uint16_t crc16(const std::uint8_t* data, std::size_t size);
+
+	// counts frames lost on the way from the gaps in seq. The teensy counts every frame it builds,
+	// including the ones it drops when the USB buffer is full
+	class SequenceTracker {
+	public:
+		SequenceTracker() : started(false), expected(0), received_cnt(0), lost_cnt(0) {}
+
+		// returns how many frames went missing just before this one
+		std::uint32_t update(std::uint32_t seq);
+
+		std::uint64_t received(void) const { return received_cnt; }
+		std::uint64_t lost(void) const { return lost_cnt; }
+
+	private:
+		bool started;
+		std::uint32_t expected;
+		std::uint64_t received_cnt;
+		std::uint64_t lost_cnt;
+	};
+
+	// consumes text lines and frames from the front of input, handing each to on_line or on_frame in the
+	// order they came, and leaves whatever is incomplete for the next call. A frame in the middle of a
+	// line is cut out and the line is handed over whole once its '\n' arrives
+	template<typename OnLine, typename OnFrame>
+	void consume(std::string& input, OnLine on_line, OnFrame on_frame) {
+		const char stops[] = { '\n', (char)SYNC0, '\0' };
+		Frame frame;
+		std::size_t line_start = 0;
+		std::size_t i = 0;
+		while((i = input.find_first_of(stops, i)) != std::string::npos) {
+			if(input[i] == '\n') {
+				on_line(string_util::StringView(input.data() + line_start, i - line_start));
+				line_start = ++i;
+				continue;
+			}
+			Result result = decode((const std::uint8_t*)input.data() + i, input.size() - i, frame);
+			if(result == Result::NeedMore) break;
+			if(result == Result::Bad) {
+				++i; // not a frame, let it through as text
+				continue;
+			}
+			on_frame(frame);
+			if(i == line_start) line_start = i += FRAME_SIZE;
+			else input.erase(i, FRAME_SIZE);
+		}
+		input.erase(0, line_start);
+	}
+}
+
+#endif
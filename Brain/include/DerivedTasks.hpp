@@ -2,6 +2,7 @@
 #define DERIVED_TASKS_H
 
 #include "Task.hpp"
+#include "CoTask.hpp"
 #include "TimeLord.hpp"
 
 #include "Actions.hpp"
@@ -50,14 +51,14 @@ private:
 	float pressure_tolerance;
 };
 
-class ValidationGate : public Task {
+class ValidationGate : public CoTask {
 public:
 	explicit ValidationGate(ThreadManager&, Comms&);
 
-	const Result update(void);
+protected:
+	const Result run(void);
+	void stop(void);
 private:
-	TimeOut delay;
-	int operation;
 	int thrust;
 	int dur;
 };
@@ -94,7 +95,8 @@ public:
 
 	const Result update(void);
 private:
-	action::SearchForQualGate a_search;
+	action::FramePipeline a_vision;
+	int on_target; // consecutive detections on target
 	action::MoveTowardsQualGate a_move;
 };
 
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <tuple>
+#include <chrono>
 
 #include "NamedClass.hpp"
 #include "ThreadManager.hpp"
@@ -38,7 +39,8 @@ RunLevel::Worker is fine for most things. For Threadables that are expected to r
 forever (and have very few side-effects), use RunLevel::Critical.
 status(...) ~ get the status of a Threadable, useful for determining whether it 
 is safe to retrieve data from it, ie by making sure it is Paused (loaded and not
-working).
+working). For a Threadable that produces results continuously, have it push them
+into a Channel (Channel.hpp) and drain that in update() instead.
 unload(...) ~ Tell the manager to clean up the given Threadable.
 unloadAll(...) ~ Tell the manager to clean up all threads launched by this task.
 */
@@ -82,6 +84,8 @@ public:
 	void launch(bool skip_init = false);
 
 	virtual const Result update(void) = 0;
+	// TaskManager skips update() while this is false, see CoTask
+	virtual bool isAwake(const std::chrono::steady_clock::time_point& now) { return true; }
 	
 	void kill(bool reset_state = true);
 
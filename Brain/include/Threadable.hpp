@@ -59,6 +59,10 @@ public:
 	bool isWorking(void) {
 		return working.load();
 	}
+	// number of completed steps, lets a caller tell a fresh Paused from a stale one
+	unsigned long stepCount(void) {
+		return steps_completed.load();
+	}
 	bool isPersistent(void) {
 		return persistent;
 	}
@@ -80,6 +84,7 @@ private:
 	std::atomic<bool> allow_step;
 	std::atomic<bool> working;
 	std::atomic<bool> clean_up_next;
+	std::atomic<unsigned long> steps_completed;
 };
 
 #endif
\ No newline at end of file
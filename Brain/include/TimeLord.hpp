@@ -3,6 +3,8 @@
 
 #include <chrono>
 
+#include "TimerWheel.hpp"
+
 /*
 This file contains helper classes to deal with 
 non-blocking event tracking.
@@ -16,7 +18,10 @@ to hasNew() to check if a new piece of data needs to be retrieved.
 
 TimeOut is an implementation of a nonblocking delay. Use reset() to start it
 or bring it up to current time and periodically check timedOut() to determine
-exactly that.
+exactly that. TimeOuts are registered with the shared TimerWheel, which
+TaskManager advances once per tick, so timedOut() only reads a flag the wheel
+sets - no clock read per poll. Because of that the wheel has to be advanced for
+a TimeOut to ever expire, and a TimeOut can't be copied.
 */
 
 class TimeStamp {
@@ -32,38 +37,44 @@ private:
 	clock::time_point timestamp;
 };
 
-class TimeOut {
-	using clock = std::chrono::steady_clock;
+class TimeOut : public TimerWheel::Timer {
 public:
-	// construct given a duration, but do not start
-	explicit TimeOut(int milliseconds, bool _enabled = false) {
-		enabled = _enabled;
-		dur = std::chrono::milliseconds(milliseconds);
+	// construct given a duration, but do not start unless _enabled
+	explicit TimeOut(int milliseconds, bool _enabled = false, TimerWheel& _wheel = TimerWheel::shared())
+		: wheel(_wheel), dur(milliseconds), fired(false)
+	{
+		if(_enabled) reset();
 	}
 	// start from now
 	void reset(void) {
-		timestamp = clock::now();
-		enabled = true;
+		fired = false;
+		wheel.schedule(*this, dur);
 	}
 	// set duration and start from now
 	void reset(int milliseconds) {
-		dur = std::chrono::milliseconds(milliseconds);
+		dur = milliseconds;
 		reset();
 	}
+	// stop without timing out
+	void cancel(void) {
+		fired = false;
+		wheel.cancel(*this);
+	}
 
-	// if enabled, check if duration has been exceeded
-	bool timedOut(void) { // true if timeout has been exceeded
-		if(enabled && clock::now() > timestamp + dur) {
-			enabled = false;
+	// true once after the duration has been exceeded
+	bool timedOut(void) {
+		if(fired) {
+			fired = false;
 			return true;
 		}
 		return false;
 	}
+protected:
+	void expired(void) { fired = true; }
 private:
-	// needs to a time_point to track start time
-	bool enabled;
-	clock::time_point timestamp;
-	std::chrono::milliseconds dur;
+	TimerWheel& wheel;
+	int dur;
+	bool fired;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+TimerWheel is a hierarchical timing wheel that tracks every pending deadline in
+one place so each timer doesn't have to read the clock to find out if it has
+expired.
+
+Time is divided into ticks of one millisecond. There are four levels of 64 slots,
+the first covers the next 64 ticks one slot per tick, the second the next 64^2
+ticks 64 per slot and so on, for a range of about 4.6 hours (longer timers are
+parked in the top level and re-filed when they come around). A timer is a node in
+an intrusive doubly linked list hanging off one slot, so schedule() and cancel()
+are O(1) no matter how many timers are pending and nothing is allocated.
+
+advance() is called once per TaskManager tick with the time TaskManager already
+sampled. It walks the ticks that have passed since the previous call, moves timers
+down a level as their slot comes up, and calls expired() on each timer whose tick
+has been reached. Per tick the cost is flat, it doesn't grow with the number of
+timers that aren't expiring.
+
+Timers are subclassed from TimerWheel::Timer (see TimeOut in TimeLord.hpp).
+A Timer cancels itself when destroyed and can't be copied. A Timer may be
+rescheduled or cancelled from inside expired().
+
+NOT THREAD SAFE - the shared wheel belongs to the thread running TaskManager, so
+only use it from Tasks, not from Threadables.
+*/
+
+class TimerWheel {
+public:
+	using clock = std::chrono::steady_clock;
+
+	class Timer {
+	public:
+		Timer() : wheel(nullptr), head(nullptr), prev(nullptr), next(nullptr), expiry(0) {}
+		virtual ~Timer();
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+		bool isPending() const { return head != nullptr; }
+
+	protected:
+		virtual void expired(void) = 0;
+
+	private:
+		friend class TimerWheel;
+
+		TimerWheel* wheel;
+		Timer** head; // slot this timer is filed under, nullptr when not pending
+		Timer* prev;
+		Timer* next;
+		std::uint64_t expiry; // tick
+	};
+
+	TimerWheel();
+	~TimerWheel();
+
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+
+	// (re)start a timer to expire once 'milliseconds' have passed, never sooner - up to a tick later
+	void schedule(Timer& timer, int milliseconds);
+	void cancel(Timer& timer);
+
+	// expire everything due at or before 'now'
+	void advance(const clock::time_point& now);
+
+	int pending(void) const { return pending_count; }
+
+	// the wheel TimeOut registers with by default, advanced by TaskManager::update()
+	static TimerWheel& shared(void);
+
+private:
+	static const int level_bits = 6;
+	static const int levels = 4;
+	static const int slots = 1 << level_bits;
+	static const std::uint64_t slot_mask = slots - 1;
+	static const std::uint64_t max_delta = (1ull << (level_bits * levels)) - 1;
+
+	clock::time_point origin;
+	std::uint64_t next_tick; // next tick to be processed
+	int pending_count;
+
+	Timer* wheel[levels][slots];
+
+	std::uint64_t toTick(const clock::time_point& t) const;
+	void file(Timer& timer);
+	void unlink(Timer& timer);
+	void cascade(int level, std::uint64_t index);
+	void processTick(void);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+TripleBuffer hands the most recent value from one thread to another, where only
+the newest matters and older values can be dropped - "latest frame wins". Unlike
+Channel, the writer never has to wait or give up because the reader is slow, and
+the reader never sees anything but the newest complete value.
+
+There are three slots. The writer fills back() and publish()es it, which swaps it
+with the middle slot. The reader calls update(), which swaps the middle slot into
+front() if something new was published. Neither side ever touches the other's
+slot, so values can be large (a cv::Mat) and are never copied by the buffer
+itself - swap into and out of the slots to move them without copying pixels.
+
+Rules:
+* exactly one writer thread and one reader thread
+* the writer owns back() until publish(), after which back() is a different slot
+holding some older value - overwrite or swap it, don't read it
+* the reader owns front() until the next update() that returns true
+*/
+
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : middle(1), back_index(0), front_index(2) {}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// writer side
+	T& back(void) { return slots[back_index]; }
+
+	// make back() the newest value, returns false if the previous one was never read (it was dropped)
+	bool publish(void) {
+		std::uint8_t old = middle.exchange(back_index | fresh, std::memory_order_acq_rel);
+		back_index = old & index_mask;
+		return (old & fresh) == 0;
+	}
+
+	// the last published value hasn't been picked up by the reader yet
+	bool pending(void) const {
+		return (middle.load(std::memory_order_acquire) & fresh) != 0;
+	}
+
+	// reader side
+	T& front(void) { return slots[front_index]; }
+
+	// move the newest value into front(), false (and front() unchanged) if nothing new was published
+	bool update(void) {
+		if((middle.load(std::memory_order_relaxed) & fresh) == 0) return false;
+		std::uint8_t old = middle.exchange(front_index, std::memory_order_acq_rel);
+		front_index = old & index_mask;
+		return true;
+	}
+
+private:
+	static const std::uint8_t index_mask = 0x3;
+	static const std::uint8_t fresh = 0x4; // set on middle when it holds a value the reader hasn't taken
+
+	T slots[3];
+	std::atomic<std::uint8_t> middle; // index of the middle slot | fresh
+	std::uint8_t back_index; // only touched by the writer
+	std::uint8_t front_index; // only touched by the reader
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef CONTOUR_TABLE_H
+#define CONTOUR_TABLE_H
+
+#include <vector>
+#include <cstddef>
+
+#include "opencv2/opencv.hpp"
+
+#include "MaskKernels.hpp"
+
+/*
+ContourTable is the list of contours that passed the area filter, with their
+features. It refers to contours by index instead of copying them, and only
+computes what is asked for:
+	area, center     ~ from the moments the area filter needed anyway, always there
+	poly             ~ approxPolyDP, on first use
+	bounds, min_bounds ~ boundingRect / minAreaRect of poly, on first use
+Usually only the largest one or two ever get looked at, so rankByArea(k)
+partially sorts just those to the front rather than sorting everything.
+
+	table.reset(contours, 2);
+	for(...) if(m.m00 > min_area) table.add(i, m);  // m = cv::moments(contourMat(contours, i))
+	table.rankByArea(2);
+	table.minBounds(0).center;   // approxPolyDP + minAreaRect of the largest only
+
+Entries' storage, polygons included, is kept from frame to frame.
+*/
+
+namespace vision {
+	// a header onto contour i's points, CV_32SC2 like a std::vector<cv::Point>, for OpenCV calls
+	inline cv::Mat contourMat(const ContourStore& contours, std::size_t i) {
+		return cv::Mat(contours.count(i), 1, CV_32SC2, const_cast<int*>(contours.points(i)));
+	}
+
+	class ContourTable {
+	public:
+		ContourTable();
+
+		// start a new frame, contours must outlive the table's use this frame
+		void reset(const ContourStore& _contours, double _poly_epsilon);
+		void add(int contour, const cv::Moments& m);
+
+		std::size_t size(void) const { return entries.size(); }
+		bool empty(void) const { return entries.empty(); }
+
+		// the k largest first, largest to smallest (lower contour index on a tie), the rest after in no order
+		void rankByArea(std::size_t k);
+
+		// epsilon of the polygon approximation, changing it drops polygons and bounds already computed
+		void setPolyEpsilon(double epsilon);
+
+		int contour(std::size_t i) const { return entries[i].contour; } // index into the ContourStore given to reset()
+		double area(std::size_t i) const { return entries[i].area; }
+		cv::Point2f center(std::size_t i) const { return entries[i].center; } // center of mass
+
+		const std::vector<cv::Point>& poly(std::size_t i);
+		const cv::Rect& bounds(std::size_t i);
+		const cv::RotatedRect& minBounds(std::size_t i);
+
+	private:
+		enum Computed : unsigned char {
+			Poly = 1,
+			Bounds = 2,
+			MinBounds = 4
+		};
+
+		struct Entry {
+			int contour;
+			double area;
+			cv::Point2f center;
+			unsigned char computed;
+			int poly_slot; // into polys, -1 until poly() is first asked for
+			cv::Rect bounds;
+			cv::RotatedRect min_bounds;
+		};
+
+		std::vector<Entry> entries;
+		const ContourStore* contours;
+		double poly_epsilon;
+
+		// polygons are handed out from here so reordering entries never moves them
+		std::vector<std::vector<cv::Point>> polys;
+		std::size_t polys_used;
+	};
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "opencv2/opencv.hpp"
+
+/*
+FrameArena is where the stages of a Pipeline get their working images from. It
+hands out views into frame sized slots in the order they're asked for, and
+reset() at the start of each pass makes every slot free again. The stages ask
+for the same things in the same order every frame, so each request lands in the
+slot it had last frame:
+
+	frame.mask = frame.arena.take(in.size(), CV_8UC1);     // slot 0
+	frame.scratch = frame.arena.take(in.size(), CV_8UC1);  // slot 1
+
+Slots are allocated at the full frame size (reserve(), from the first frame), so
+a different ROI or a half resolution pass only changes the view, never the
+memory behind it - a cv::Mat that is create()d at each new ROI size frees and
+allocates every time the size changes. A slot is just bytes, so it only grows
+when a request needs more of them than it has (a 3 channel image in what was a
+mask's slot, the first time).
+
+Views aren't continuous unless they cover a whole slot row, so anything writing
+through a raw pointer goes row by row.
+
+labels(), row() and offsets() are the scratch buffers of MaskKernels.hpp.
+allocations() counts every time the arena had to get memory, so a test can
+check it stops once the first frames are through.
+*/
+
+namespace vision {
+	class FrameArena {
+	public:
+		FrameArena();
+
+		// does nothing unless frames got bigger, slots already handed out are reallocated on their next take()
+		void reserve(cv::Size frame_size);
+		// start of a pass, everything taken before can be handed out again
+		void reset(void) { used = 0; }
+
+		cv::Mat take(cv::Size size, int type);
+
+		// scratch for traceExternalContours, for a mask this size - flat, not a view
+		std::int8_t* labels(cv::Size mask_size);
+		// scratch for dilateRect and decimate, valid until the next call of the same function
+		std::uint8_t* row(std::size_t bytes);
+		int* offsets(std::size_t count);
+
+		cv::Size capacity(void) const { return frame; }
+		std::size_t slotCount(void) const { return slots.size(); }
+		unsigned long allocations(void) const { return allocs; }
+
+	private:
+		cv::Size frame;
+		std::vector<cv::Mat> slots;
+		std::size_t used;
+		std::vector<std::uint8_t> row_buffer;
+		std::vector<int> offset_buffer;
+		unsigned long allocs;
+	};
+}
+
+#endif
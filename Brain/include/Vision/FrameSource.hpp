@@ -0,0 +1,81 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "opencv2/opencv.hpp"
+
+/*
+A FrameSource produces BGR frames for a vision::Pipeline. read() fills the given
+Mat, reusing its buffer where the backend allows (cv::VideoCapture does), and
+returns false when no frame is available - end of a file or sequence, or a
+camera that stopped answering. isLive() tells the two apart: a live camera can
+miss a frame and carry on, a file or sequence that returns false is done.
+
+CaptureSource     ~ a camera by index, or a video file, through cv::VideoCapture
+ImageSequenceSource ~ every image matching a glob pattern, or every image in a
+                    directory, in sorted order. Optionally loops, which is handy
+                    for measuring throughput on a handful of stored frames.
+
+openSource() picks one from a single string so a source can be given on the
+command line or through Comms:
+	"0", "1"          -> camera 0, 1
+	"dir/" or a directory -> every image in it
+	"dir/img*.png"    -> images matching the pattern
+	anything else     -> video file
+*/
+
+namespace vision {
+	class FrameSource {
+	public:
+		FrameSource() : live(false) {}
+		virtual ~FrameSource() {}
+
+		virtual bool isOpened(void) = 0;
+		virtual bool read(cv::Mat& frame) = 0;
+
+		const std::string& getDescription(void) const { return description; }
+		bool isLive(void) const { return live; } // a camera, rather than a file or sequence that ends
+
+	protected:
+		std::string description;
+		bool live;
+	};
+
+	class CaptureSource : public FrameSource {
+	public:
+		CaptureSource(int device, cv::Size frame_size);
+		explicit CaptureSource(const std::string& path);
+		~CaptureSource();
+
+		bool isOpened(void);
+		bool read(cv::Mat& frame);
+
+	private:
+		cv::VideoCapture cap;
+	};
+
+	class ImageSequenceSource : public FrameSource {
+	public:
+		explicit ImageSequenceSource(const std::string& pattern, bool _loop = false);
+
+		bool isOpened(void);
+		bool read(cv::Mat& frame);
+
+		std::size_t size(void) const { return files.size(); }
+		std::size_t position(void) const { return next; } // index of the next file to be read
+		const std::string& lastFile(void) const { return last_file; }
+
+	private:
+		std::vector<cv::String> files;
+		std::size_t next;
+		bool loop;
+		std::string last_file;
+	};
+
+	std::unique_ptr<FrameSource> openSource(const std::string& spec, cv::Size frame_size = cv::Size(640, 480), bool loop = false);
+}
+
+#endif
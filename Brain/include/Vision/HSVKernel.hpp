@@ -0,0 +1,53 @@
+#ifndef HSV_KERNEL_H
+#define HSV_KERNEL_H
+
+#include <cstdint>
+
+/*
+Fused BGR -> HSV -> inRange, one pass over the frame with no intermediate HSV image.
+
+hsvThresholdRow() produces exactly what
+	cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+	cv::inRange(hsv, lower, upper, mask);
+does for 8-bit images, bit for bit. H is computed the way OpenCV does it for
+8-bit data (H in [0, 180), fixed point with 12 fraction bits and rounded
+reciprocal tables), and the bounds are converted the way inRange converts a
+Scalar (round half to even, an interval that is empty or entirely outside
+[0, 255] matches nothing, otherwise clamped to [0, 255]).
+
+Paths, picked at compile time from the target flags the Makefile passes:
+	SSE4.1 (x86 with -march=native)      16 pixels per iteration
+	NEON   (the Pi, armv7 or aarch64)    16 pixels per iteration
+	scalar                               everything else, and row tails
+The vector paths can't look up the reciprocal tables, so they recompute the
+table entry with a float divide, which rounds to exactly the table value (on
+armv7, a refined reciprocal estimate corrected with the integer remainder).
+Pixels failing the V test are rejected before any division is done, and when the
+H and S bounds cover everything only V is computed at all.
+
+This file has no OpenCV dependency so the kernel can be tested and benchmarked
+against OpenCV from anywhere (see bench/hsv_threshold_bench.cpp).
+*/
+
+namespace vision {
+	struct HSVRange {
+		std::uint8_t lower[3]; // H, S, V inclusive
+		std::uint8_t upper[3];
+		bool empty; // matches nothing
+		bool v_only; // H and S bounds are the full range
+	};
+
+	// bounds as given to cv::inRange, H in [0, 180), S and V in [0, 255]
+	HSVRange makeHSVRange(const double lower[3], const double upper[3]);
+
+	// mask[i] = 255 if pixel i of the packed BGR row is in range, else 0
+	void hsvThresholdRow(const std::uint8_t* bgr, std::uint8_t* mask, int width, const HSVRange& range);
+
+	// the portable version, always available - the reference the vector paths are tested against
+	void hsvThresholdRowScalar(const std::uint8_t* bgr, std::uint8_t* mask, int width, const HSVRange& range);
+
+	// which path hsvThresholdRow() uses in this build, "sse4.1", "neon" or "scalar"
+	const char* hsvKernelPath(void);
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include "opencv2/opencv.hpp"
+
+/*
+LineIndex holds the sides of a polygon so near parallel pairs can be found
+without comparing every side against every other one (get_path.cpp's list
+scan, which is n^2 and a heap node per line).
+
+Lines are stored as one array per field, longest first after build(), and
+bucketed by direction. A bucket is at least as wide as the parallel tolerance,
+so everything parallel to a line is in its own bucket or one of the two next to
+it (wrapping around, 179 degrees is parallel to 1). nearestParallel() only looks
+at those three buckets, and used lines are taken out of their bucket, so with
+lines spread over directions pairing them does about 3 / buckets of the
+comparisons of the full scan (12 buckets at the usual 15 degrees).
+
+A noisy polygon can come out with hundreds of tiny sides. build() keeps only
+the longest max_lines - the short ones never make useful pairs anyway.
+
+	index.clear();
+	for(...) index.add(p1, p2);
+	index.build(48, 15 * CV_PI / 180);
+	for(i = 0; i < index.size(); ++i) if(!index.used(i)) { index.markUsed(i); j = index.nearestParallel(i, ...); }
+
+All storage is kept between frames, so once it has grown to fit it doesn't allocate.
+*/
+
+namespace vision {
+	struct Segment {
+		Segment() {}
+		Segment(cv::Point2f _p1, cv::Point2f _p2) : p1(_p1), p2(_p2) {}
+
+		double length(void) const { return std::hypot(p2.x - p1.x, p2.y - p1.y); }
+		double angle(void) const { return std::atan2(p2.y - p1.y, p2.x - p1.x); } // radians, +-pi
+		cv::Point2f midpoint(void) const { return (p1 + p2) * 0.5f; }
+		void reverse(void) { std::swap(p1, p2); }
+
+		cv::Point2f p1, p2;
+	};
+
+	class LineIndex {
+	public:
+		LineIndex();
+
+		void clear(void);
+		void add(cv::Point2f p1, cv::Point2f p2);
+
+		// sort longest first (ties keep the order they were added in), drop all but the longest
+		// max_lines and bucket by direction. Returns how many were dropped
+		std::size_t build(std::size_t max_lines, double tolerance);
+
+		std::size_t size(void) const { return length.size(); }
+		Segment segment(std::size_t i) const { return Segment(cv::Point2f(x1[i], y1[i]), cv::Point2f(x2[i], y2[i])); }
+		float getLength(std::size_t i) const { return length[i]; }
+
+		bool used(std::size_t i) const { return bucket_pos[i] < 0; }
+		void markUsed(std::size_t i);
+
+		// the unused line within tolerance of line i's direction and at least min_length long whose midpoint
+		// is nearest line i's, lowest index on a tie. -1 if there is none
+		int nearestParallel(std::size_t i, float min_length) const;
+
+	private:
+		std::size_t bucketOf(float angle) const;
+		void permute(std::vector<float>& v); // into order
+
+		// one entry per line
+		std::vector<float> x1, y1, x2, y2;
+		std::vector<float> mid_x, mid_y;
+		std::vector<float> length;
+		std::vector<float> angle; // [0, pi), direction without caring which way the line points
+		std::vector<int> bucket_pos; // position in its bucket, -1 once used
+
+		double tolerance;
+		std::vector<std::vector<int>> buckets; // line indexes
+		std::vector<int> bucket; // bucket of each line
+
+		// build() scratch
+		std::vector<int> order;
+		std::vector<float> scratch;
+	};
+}
+
+#endif
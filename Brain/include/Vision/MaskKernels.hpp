@@ -0,0 +1,66 @@
+#ifndef MASK_KERNELS_H
+#define MASK_KERNELS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+The mask operations of the pipelines, written against caller provided buffers so
+nothing is allocated per frame (see FrameArena). Each gives exactly what the
+OpenCV call it replaces gives:
+	dilateRect            ~ cv::dilate(src, dst, getStructuringElement(MORPH_RECT, Size(size, size)))
+	                        with the default anchor and border, for CV_8UC1
+	decimate              ~ cv::resize(src, dst, dst_size, 0, 0, INTER_NEAREST), any number of 8 bit channels
+	traceExternalContours ~ cv::findContours(mask, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE, offset),
+	                        the same points in the same order (OpenCV's Suzuki border following)
+OpenCV sets up a filter engine for every dilate, and findContours copies the
+mask into a new padded image and builds its contours in a fresh CvMemStorage
+before copying them out into a vector per contour. Here all of that lives in
+buffers that are sized on the first frame and reused.
+
+Images are given as a pointer to the first pixel and a row stride in bytes, so
+views into bigger buffers work. Pixels outside the width x height given are
+never read - unlike cv::dilate on a submatrix, which reads the parent's pixels
+past the view's edges.
+
+Like HSVKernel.hpp this has no OpenCV dependency, so it can be checked against
+OpenCV from anywhere (see bench/frame_arena_bench.cpp).
+*/
+
+namespace vision {
+	// contours packed one after another, so a frame with more or fewer contours than the
+	// last doesn't free or allocate anything once the vectors have grown
+	struct ContourStore {
+		std::vector<int> xy; // x, y of each point, a contour's points are CV_32SC2 / cv::Point compatible
+		std::vector<int> starts; // contour i is points starts[i] up to starts[i + 1]
+
+		ContourStore() { clear(); }
+		void clear(void) {
+			xy.clear();
+			starts.clear();
+			starts.push_back(0);
+		}
+
+		std::size_t size(void) const { return starts.size() - 1; }
+		bool empty(void) const { return size() == 0; }
+		int count(std::size_t i) const { return starts[i + 1] - starts[i]; }
+		const int* points(std::size_t i) const { return xy.data() + 2 * starts[i]; }
+		int* points(std::size_t i) { return xy.data() + 2 * starts[i]; }
+	};
+
+	// row: scratch of at least width + size - 1 bytes
+	void dilateRect(const std::uint8_t* src, std::size_t src_step, std::uint8_t* dst, std::size_t dst_step,
+		int width, int height, int size, std::uint8_t* row);
+
+	// x_ofs: scratch of at least dst_width ints
+	void decimate(const std::uint8_t* src, std::size_t src_step, int src_width, int src_height,
+		std::uint8_t* dst, std::size_t dst_step, int dst_width, int dst_height, int channels, int* x_ofs);
+
+	// labels: scratch of at least (width + 2) * (height + 2) bytes, out is cleared first
+	// the mask isn't modified (findContours used to write into it)
+	void traceExternalContours(const std::uint8_t* mask, std::size_t step, int width, int height,
+		int offset_x, int offset_y, std::int8_t* labels, ContourStore& out);
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+/*
+QualityGovernor decides how much work a Pipeline does per frame so results stay
+fresh when the CPU is shared with the serial, task and logging threads. It
+watches the (smoothed) processing time of each frame against a budget and
+steps down a level when the pipeline keeps running over, and back up when
+there has been plenty of headroom for a while:
+	0  full quality
+	1  optional stages dropped (Stage::setOptional, ie Dilate)
+	2  + half resolution - coordinates in the Detection are still full resolution
+	3  + every other frame skipped
+	4  + two of every three frames skipped
+Skipping doesn't make a frame cheaper, it gives each processed frame the time of
+the frames skipped, so the budget at levels 3 and 4 is 2x and 3x the frame budget.
+
+Going down takes hold_frames frames over budget, going up takes recover_frames
+under recover_ratio of the budget of the level above. When a level that was
+just recovered to turns out to be too much again straight away, the wait before
+the next try doubles (up to 16x), so a load right at the edge doesn't make the
+quality flap from frame to frame.
+
+With no budget (the default) it stays at level 0 and never skips.
+*/
+
+namespace vision {
+	struct QualityLevel {
+		bool optional_stages;
+		int downscale; // the frame is processed at 1 / downscale of its size
+		int skip; // frames skipped after each processed one
+	};
+
+	class QualityGovernor {
+	public:
+		QualityGovernor();
+
+		// budget_ms is the time each frame handed to the pipeline may take, 0 turns the governor off
+		void setBudget(double _budget_ms, unsigned _hold_frames = 5, unsigned _recover_frames = 30, double _recover_ratio = 0.5);
+		bool enabled(void) const { return budget_ms > 0; }
+		double budget(void) const { return budget_ms; }
+
+		int level(void) const { return current_level; }
+		const QualityLevel& current(void) const;
+		static int levelCount(void);
+
+		// call for each frame before processing it, true if it should be dropped instead
+		bool skip(void);
+		// processing time of the frame that was just processed, may change the level for the next one
+		void update(double frame_ms);
+
+		unsigned long skipped(void) const { return frames_skipped; }
+		unsigned long levelChanges(void) const { return changes; }
+		double smoothedMs(void) const { return smoothed_ms; }
+		void resetStats(void);
+
+	private:
+		double levelBudget(int level) const;
+		void changeLevel(int level);
+
+		double budget_ms;
+		unsigned hold_frames;
+		unsigned recover_frames;
+		double recover_ratio;
+
+		int current_level;
+		double smoothed_ms; // < 0 until the first frame at this level
+		unsigned over; // frames in a row over budget
+		unsigned under; // frames in a row with room to go up a level
+		unsigned since_change; // frames processed since the level last changed
+		unsigned recover_wait; // frames of headroom needed to go up, backs off when going up doesn't stick
+		bool recovered; // the last change was up a level
+		int skip_count;
+
+		unsigned long frames_skipped;
+		unsigned long changes;
+	};
+}
+
+#endif
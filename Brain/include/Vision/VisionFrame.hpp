@@ -0,0 +1,126 @@
+#ifndef VISION_FRAME_H
+#define VISION_FRAME_H
+
+#include <vector>
+#include <chrono>
+
+#include "opencv2/opencv.hpp"
+
+#include "LineIndex.hpp"
+#include "ContourTable.hpp"
+#include "FrameArena.hpp"
+#include "MaskKernels.hpp"
+
+/*
+VisionFrame is the working state of one frame as it moves through a
+vision::Pipeline. The pipeline owns a single VisionFrame and hands it to each
+Stage in turn, so every Mat and vector in here keeps its buffer from one frame
+to the next. The images the stages work in are views handed out by arena (see
+FrameArena.hpp), which keeps them in frame sized memory even when the ROI
+changes size from frame to frame, and clear() on a vector keeps its capacity.
+Once the buffers have grown to what the frames need, processing a frame
+allocates nothing (bench/frame_arena_bench.cpp checks this).
+
+Buffer conventions used by the stages:
+	input    ~ BGR frame from the FrameSource, never modified
+	reduced  ~ input at reduced resolution, the two are swapped while the Pipeline is
+	           degraded to a lower resolution, so the stages see the small one as input
+	roi      ~ the part of input this pass works on, the whole frame unless the
+	           Pipeline is tracking. hsv, mask and scratch are roi sized, contours
+	           and everything after them are in full frame coordinates
+	hsv      ~ input converted to HSV, only filled by HSVThreshold when it isn't fused
+	mask     ~ the current binary image, stages that refine it write into scratch
+	           and swap the two, so a cv::Mat header swap is the only cost
+	           (hsv, mask and scratch are arena views, only good until the next pass)
+	contours ~ outer contours of mask, packed into one ContourStore (traceExternalContours)
+	targets  ~ contours that passed the area filter and their features, see ContourTable
+	target   ~ which of targets was picked, -1 for none
+	lines, centerlines ~ sides of poly and the center lines paired from them (path detection)
+	detection ~ the result, reset at the start of every frame
+
+Detection is what leaves the pipeline. It is copied into a Channel by the
+Threadable running the pipeline, so it holds no Mats or vectors.
+
+CapturedFrame is a frame on its way from the capture thread to a worker, with
+the time it was captured and its sequence number so results from several workers
+can be put back in order and their age reported.
+*/
+
+namespace vision {
+	enum class Heading {
+		None, // nothing found
+		Left,
+		Right,
+		OnTarget
+	};
+
+	const char* headingName(Heading heading);
+
+	struct Detection {
+		Detection() : frame_number(0), fps(0) { clear(); }
+
+		void clear(void) {
+			found = false;
+			center = cv::Point2f(0, 0);
+			area = 0;
+			bounds = cv::Rect();
+			min_bounds = cv::RotatedRect();
+			offset = 0;
+			heading = Heading::None;
+			path_sections = 0;
+			path_ends[0] = path_ends[1] = cv::Point2f(0, 0);
+			path_angle = 0;
+			quality = 0;
+		}
+
+		bool found;
+		cv::Point2f center; // pixels in the full frame
+		double area; // pixels
+		cv::Rect bounds;
+		cv::RotatedRect min_bounds;
+		double offset; // horizontal position of center, -1 at the left edge to 1 at the right
+		Heading heading;
+
+		// path detection (configurePath), only filled in when at least one section was found
+		int path_sections; // center lines making up the path
+		cv::Point2f path_ends[2]; // the two center line endpoints farthest apart, [0] lower in the frame
+		double path_angle; // degrees, of the longest center line, 0 is along the image x axis, 90 down the y axis, [0, 180)
+
+		cv::Size frame_size;
+		cv::Rect roi; // the part of the frame that was searched for this result
+		int quality; // QualityGovernor level this was processed at, 0 is full quality
+		unsigned long frame_number; // CapturedFrame::sequence, or the count when the pipeline reads the source itself
+		std::chrono::steady_clock::time_point captured; // when the source returned the frame
+		double fps; // pipeline throughput when this was produced
+	};
+
+	struct CapturedFrame {
+		CapturedFrame() : sequence(0) {}
+
+		cv::Mat image;
+		std::chrono::steady_clock::time_point captured;
+		unsigned long sequence; // 1 for the first frame from the source, 0 for none
+	};
+
+	struct VisionFrame {
+		VisionFrame() : target(-1) {}
+
+		cv::Mat input;
+		cv::Mat reduced;
+		cv::Rect roi;
+		cv::Mat hsv;
+		cv::Mat mask;
+		cv::Mat scratch;
+
+		FrameArena arena;
+		ContourStore contours;
+		ContourTable targets;
+		int target;
+		LineIndex lines;
+		std::vector<Segment> centerlines;
+
+		Detection detection;
+	};
+}
+
+#endif
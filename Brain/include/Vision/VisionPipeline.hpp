@@ -0,0 +1,156 @@
+#ifndef VISION_PIPELINE_H
+#define VISION_PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <utility>
+
+#include "VisionFrame.hpp"
+#include "VisionStages.hpp"
+#include "FrameSource.hpp"
+#include "QualityGovernor.hpp"
+
+#include "../Comms/Comms.hpp"
+
+/*
+Pipeline runs a fixed list of Stages over one frame at a time and keeps timing
+for each stage and for the whole thing. It owns the VisionFrame the stages work
+in, so buffers are allocated on the first frames and reused after that (see FrameArena).
+
+	vision::Pipeline p;
+	vision::configureHeading(p);
+	std::unique_ptr<vision::FrameSource> src = vision::openSource("frames/");
+	while(p.step(*src)) std::cout << vision::headingName(p.frame().detection.heading);
+
+step() reads from the source and processes; process() runs the stages on
+whatever is already in frame().input, or on a CapturedFrame handed over by a
+capture thread. None of these are thread safe - a Pipeline belongs to the thread
+that calls it. action::FramePipeline runs capture and several Pipelines on
+their own threads.
+
+Tracking (off unless setTracking() is called): once something is found, the
+next frames only search an ROI around the last bounding box, grown by margin
+times its size on each side (at least min_margin pixels). When the ROI turns up
+nothing the same frame is searched again in full, so losing the target costs
+one extra pass rather than a frame without a result. The whole frame is also
+searched every full_search_every frames, in case something better showed up
+elsewhere (0 turns that off). An ROI covering most of the frame isn't worth it and is skipped.
+
+Frame budget (off unless setFrameBudget() is called): a QualityGovernor watches
+how long frames take and trades quality for time when the CPU is busy elsewhere -
+optional stages are dropped first, then the frame is processed at half
+resolution, then frames are skipped. step() skips by reading past frames, a
+thread feeding process() asks skipFrame() first. Detection::quality says which
+level a result came from.
+
+publish() writes a Detection into Comms as typed fields, prefixed with 'vision_':
+	found   Bool        offset  Double (-1 left edge .. 1 right edge)
+	heading String      center  DoubleVector (x, y pixels)
+	area    Double      fps     Double
+	age_ms  Double      ~ how old the frame behind this result is, at the time of publishing
+	quality Int         ~ Detection::quality, 0 is full quality, higher is coarser (see QualityGovernor)
+*/
+
+namespace vision {
+	class Pipeline {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		struct StageTiming {
+			std::string name;
+			double last_ms; // the last frame, both passes when tracking had to search again, 0 if skipped
+			double total_ms;
+		};
+
+		Pipeline();
+
+		Pipeline(const Pipeline&) = delete;
+		Pipeline& operator=(const Pipeline&) = delete;
+
+		template<typename S, typename... Args>
+		S& add(Args&&... args);
+
+		// read a frame and process it, false if the source had nothing
+		bool step(FrameSource& source);
+		// swap the frame's image in as the input and process it, see CapturedFrame
+		const Detection& process(CapturedFrame& frame);
+		// run the stages on frame().input
+		const Detection& process(void);
+
+		VisionFrame& frame(void) { return current; }
+
+		void setTracking(bool enabled, double margin = 0.5, int min_margin = 16, unsigned full_search_every = 30);
+		bool isTracking(void) const { return tracking; }
+
+		// time each frame may take, 0 (the default) always runs at full quality
+		void setFrameBudget(double ms) { governor.setBudget(ms); }
+		const QualityGovernor& quality(void) const { return governor; }
+		// true if the governor wants the next frame dropped, for callers of process(CapturedFrame)
+		bool skipFrame(void) { return governor.skip(); }
+
+		unsigned long frameCount(void) const { return frames; }
+		double fps(void) const; // frames per second of wall time since the first frame (or resetStats)
+		double meanFrameMs(void) const; // processing only, not waiting on the source
+		double lastFrameMs(void) const { return last_frame_ms; }
+		const std::vector<StageTiming>& stageTimings(void) const { return timings; }
+		unsigned long roiFrames(void) const { return roi_frames; } // frames answered from the ROI alone
+		unsigned long lostFrames(void) const { return lost_frames; } // ROI came up empty and the full frame was searched
+		std::string report(void) const;
+		void resetStats(void);
+
+	private:
+		std::vector<std::unique_ptr<Stage>> stages;
+		std::vector<StageTiming> timings;
+
+		VisionFrame current;
+
+		// where to look, full frame unless tracking says otherwise
+		cv::Rect nextRoi(void);
+		void runStages(void);
+		void scaleDetection(Detection& d, int scale);
+
+		bool tracking;
+		double track_margin;
+		int track_min_margin;
+		unsigned full_search_every;
+		cv::Rect track_bounds; // empty when there's nothing to track
+		unsigned since_full; // frames since the last full frame search
+		unsigned long roi_frames;
+		unsigned long lost_frames;
+
+		QualityGovernor governor;
+		int frame_scale; // downscale of the frame being processed
+
+		unsigned long frames;
+		double total_ms;
+		double last_frame_ms;
+		bool timing; // started is valid
+		clock::time_point started;
+		clock::time_point stage_start; // runStages() carries it from one stage to the next
+	};
+
+	template<typename S, typename... Args>
+	S& Pipeline::add(Args&&... args) {
+		S* stage = new S(std::forward<Args>(args)...);
+		stages.push_back(std::unique_ptr<Stage>(stage));
+		timings.push_back(StageTiming{ stage->getName(), 0, 0 });
+		return *stage;
+	}
+
+	// cv_c++_tests/heading1.cpp: orange threshold, 7x7 dilate, steer toward the largest blob
+	void configureHeading(Pipeline& pipeline);
+
+	// cv_c++_tests/get_path.cpp: the path's center lines, ends and direction (Detection::path_*)
+	// with pyramid_levels > 0 the path is found on a frame halved that many times first, and only the
+	// region around it is processed at full resolution - see CoarseLocate
+	void configurePath(Pipeline& pipeline, int pyramid_levels = 0);
+
+	// one of the above by name, "heading", "path" or "path_pyramid" - false if there's no such pipeline
+	bool configure(Pipeline& pipeline, const std::string& name);
+
+	void publish(Comms& comms, const std::string& link_id, const Detection& detection);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef VISION_STAGES_H
+#define VISION_STAGES_H
+
+#include <string>
+
+#include "opencv2/opencv.hpp"
+
+#include "VisionFrame.hpp"
+#include "HSVKernel.hpp"
+
+/*
+A Stage is one operator in a vision::Pipeline. process() reads and writes the
+shared VisionFrame (see VisionFrame.hpp for which buffer means what). Anything a
+stage needs between frames - kernels, thresholds - is built in its constructor
+so process() does no setup work.
+
+Stages that read input only read frame.roi of it. Stages working on the mask
+don't need to care, and contours come out in full frame coordinates, so nothing
+after FindContours knows whether the whole frame was searched. Images a stage
+writes come from frame.arena rather than being create()d, and the mask work is
+done by the kernels in MaskKernels.hpp, so a frame allocates nothing.
+
+The stages here are the steps of cv_c++_tests/heading1.cpp and contour_moments.cpp:
+	HSVThreshold  ~ cvtColor to HSV, then inRange into mask (fused into one pass by default, see HSVKernel.hpp)
+	Dilate        ~ grow the white parts of mask, helps in low light
+	FindContours  ~ outer contours of mask, moments of each, those over min_area go in targets
+	LargestTarget ~ picks the biggest of targets and fills in the detection
+	HeadingStage  ~ left/right/on target from the horizontal offset of the detection
+and from get_path.cpp:
+	CoarseLocate  ~ finds the target on a shrunk copy and narrows roi to it, so the
+	                full resolution stages after it only look where it is
+	PathLines     ~ pairs near parallel sides of the target's polygon into center lines
+	                (through a LineIndex) and finds the two ends of the path
+
+A stage that finds nothing worth looking at can empty frame.roi, which ends the
+pass - the stages after it don't run and the frame has no detection.
+
+Stages don't assume a frame size. When the pipeline is degraded to half
+resolution input is the shrunk frame, and the pipeline scales the Detection back
+up afterwards.
+*/
+
+namespace vision {
+	class Stage {
+	public:
+		explicit Stage(std::string _name) : name(_name), optional(false) {}
+		virtual ~Stage() {}
+
+		const std::string& getName(void) const { return name; }
+
+		// an optional stage improves the result but the pipeline still works without it,
+		// so it is the first thing dropped when the pipeline runs over its budget (see QualityGovernor)
+		void setOptional(bool _optional) { optional = _optional; }
+		bool isOptional(void) const { return optional; }
+
+		virtual void process(VisionFrame& frame) = 0;
+
+	private:
+		std::string name;
+		bool optional;
+	};
+
+	class HSVThreshold : public Stage {
+	public:
+		// bounds are H in [0, 180), S and V in [0, 255], inclusive
+		// fused writes mask straight from input and leaves hsv alone, the same mask as
+		// the cvtColor + inRange path bit for bit, but without the HSV image in between
+		HSVThreshold(cv::Scalar _lower, cv::Scalar _upper, bool _fused = true);
+
+		void process(VisionFrame& frame);
+
+	private:
+		cv::Scalar lower;
+		cv::Scalar upper;
+		HSVRange range;
+		bool fused;
+	};
+
+	class Dilate : public Stage {
+	public:
+		// a kernel_size x kernel_size square
+		explicit Dilate(int _kernel_size);
+
+		void process(VisionFrame& frame);
+
+	private:
+		int kernel_size;
+	};
+
+	class FindContours : public Stage {
+	public:
+		explicit FindContours(double _min_area);
+
+		void process(VisionFrame& frame);
+
+	private:
+		double min_area;
+	};
+
+	class LargestTarget : public Stage {
+	public:
+		// epsilon of the polygon approximation the bounding boxes are taken from
+		explicit LargestTarget(double _poly_epsilon = 2);
+
+		void process(VisionFrame& frame);
+
+	private:
+		double poly_epsilon;
+	};
+
+	class CoarseLocate : public Stage {
+	public:
+		// levels: the frame is searched at 1 / 2^levels size, 1 -> 320x240 and 2 -> 160x120 from 640x480
+		// min_area and margin are in full resolution pixels
+		CoarseLocate(cv::Scalar lower, cv::Scalar upper, int _levels, double _min_area = 0, int _margin = 16);
+
+		void process(VisionFrame& frame);
+
+	private:
+		HSVRange range;
+		int levels;
+		double min_area;
+		int margin;
+
+		ContourStore contours; // of the shrunk frame, the images are arena views
+	};
+
+	class HeadingStage : public Stage {
+	public:
+		// within +-tolerance pixels of the center column counts as on target, pixels of the full frame
+		// (Detection::frame_size) whatever resolution the Pipeline is running at
+		explicit HeadingStage(int _tolerance = 7);
+
+		void process(VisionFrame& frame);
+
+	private:
+		int tolerance;
+	};
+
+	class PathLines : public Stage {
+	public:
+		// sides within parallel_tolerance degrees of each other can pair up, at most max_sections center lines
+		// only the longest max_lines sides are considered, and a side only pairs with one at least
+		// min_length_ratio as long - a noisy polygon's slivers stay out of the way of the real sides
+		explicit PathLines(double _parallel_tolerance = 15, int _max_sections = 4, std::size_t _max_lines = 48, double _min_length_ratio = 0.25);
+
+		void process(VisionFrame& frame);
+
+	private:
+		double parallel_tolerance; // radians
+		int max_sections;
+		std::size_t max_lines;
+		double min_length_ratio;
+	};
+}
+
+#endif
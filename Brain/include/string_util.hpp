@@ -2,17 +2,107 @@
 #define STRING_UTIL_H
 
 #include <string>
-#include <regex>
 #include <vector>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <ostream>
 
 /*
 This file defines extra string helper functions.
+
+StringView is a pointer and length into characters owned by someone else (a
+c++14 stand-in for std::string_view). trim() and split() work on views so they
+never allocate or copy - the view is only valid while the string it came from
+is alive and unmodified. Use str() to make an owning copy when one is needed.
+
+	for(StringView field : string_util::split(line, '~')) { ... }
+
+split() behaves like splitOnChar(): "a,,b," yields "a", "", "b" and "", and an
+empty string yields one empty field.
+
+Whitespace is what isspace() accepts in the C locale: space, \t, \n, \v, \f, \r.
 */
 
 namespace string_util {
-	void splitOnChar(const std::string&, char, std::vector<std::string>&);
-	std::string removeWhitespace(const std::string&);
-	std::string trim(const std::string&);
+	class StringView {
+	public:
+		StringView() : ptr(""), len(0) {}
+		StringView(const char* s) : ptr(s), len(std::strlen(s)) {}
+		StringView(const char* s, std::size_t n) : ptr(s), len(n) {}
+		StringView(const std::string& s) : ptr(s.data()), len(s.size()) {}
+
+		const char* data() const { return ptr; }
+		std::size_t size() const { return len; }
+		bool empty() const { return len == 0; }
+		char operator[](std::size_t i) const { return ptr[i]; }
+		const char* begin() const { return ptr; }
+		const char* end() const { return ptr + len; }
+
+		// npos (std::string::npos) when not found
+		std::size_t find(char c, std::size_t from = 0) const;
+		StringView substr(std::size_t pos, std::size_t n = std::string::npos) const;
+		bool startsWith(StringView prefix) const;
+
+		std::string str() const { return std::string(ptr, len); }
+
+		bool operator==(StringView other) const { return len == other.len && std::memcmp(ptr, other.ptr, len) == 0; }
+		bool operator!=(StringView other) const { return !(*this == other); }
+
+	private:
+		const char* ptr;
+		std::size_t len;
+	};
+
+	std::ostream& operator<<(std::ostream& os, StringView v);
+
+	class Split {
+	public:
+		class iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = StringView;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const StringView*;
+			using reference = StringView;
+
+			iterator(StringView _src, char _delim, bool _done);
+
+			StringView operator*() const { return current; }
+			const StringView* operator->() const { return &current; }
+			iterator& operator++();
+			iterator operator++(int) { iterator tmp = *this; ++(*this); return tmp; }
+
+			bool operator==(const iterator& other) const { return done == other.done && (done || current.data() == other.current.data()); }
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+		private:
+			StringView src;
+			StringView current;
+			std::size_t next; // start of the field after current, npos when current is the last
+			char delim;
+			bool done;
+		};
+
+		Split(StringView _src, char _delim) : src(_src), delim(_delim) {}
+
+		iterator begin() const { return iterator(src, delim, false); }
+		iterator end() const { return iterator(src, delim, true); }
+	private:
+		StringView src;
+		char delim;
+	};
+
+	inline bool isWhitespace(char c) {
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+	Split split(StringView s, char delim);
+	StringView trim(StringView s);
+	void trimInPlace(std::string& s); // erases in place, keeps the capacity
+	void removeWhitespaceInPlace(std::string& s);
+
+	void splitOnChar(StringView, char, std::vector<std::string>&);
+	std::string removeWhitespace(StringView);
 }
 
-#endif
\ No newline at end of file
+#endif
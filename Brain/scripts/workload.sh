@@ -0,0 +1,22 @@
+#!/bin/sh
+# Scripted Brain session used to train pgo builds and compare loop rates.
+# Runs the comms self-test, starts the default mission tree on the DummyLink
+# (no teensy attached, so Submerge times out and falls through to SurfaceAndWait),
+# queries the managers and quits. Brain prints its main loop rate on exit.
+#
+# usage: sh scripts/workload.sh [binary] [seconds]
+
+BIN=${1:-bin/brain}
+DUR=${2:-20}
+
+mkdir -p logs
+
+{
+	sleep 1
+	echo "start"
+	sleep "$DUR"
+	echo "tasks"
+	echo "threads"
+	echo "quit"
+	sleep 1
+} | "$BIN" -e
@@ -17,10 +17,116 @@ void action::XXX:step(void) {
 
 */
 
-void action::SearchForQualGate::step(void) {
-	if(i == 50) dir = "locked";
-	++i;
-	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+// ********************************
+// CaptureFrames
+// ********************************
+
+action::CaptureFrames::CaptureFrames() : source_spec("0"), next_output(0), frames_captured(0), frames_dropped(0), source_finished(false) {}
+
+void action::CaptureFrames::step(void) {
+	// opened here rather than init(), which runs on the main thread, a camera can take a while to start
+	if(!source) source = vision::openSource(source_spec);
+
+	if(outputs.empty()) {
+		sleepThread(100); // no worker to hand frames to yet
+		return;
+	}
+	if(!source->read(frame.image)) {
+		// a file or sequence has run out. A camera can miss a frame or stall while the driver recovers,
+		// keep asking it
+		if(!source->isLive()) source_finished.store(true);
+		sleepThread(source->isLive() ? 10 : 100); // no frame, don't spin
+		return;
+	}
+	frame.captured = std::chrono::steady_clock::now();
+	frame.sequence = frames_captured.fetch_add(1) + 1;
+
+	// prefer a worker that has taken its last frame, otherwise overwrite the next one's waiting frame
+	std::size_t target = next_output;
+	for(std::size_t i = 0; i < outputs.size(); ++i) {
+		std::size_t candidate = (next_output + i) % outputs.size();
+		if(!outputs[candidate]->pending()) {
+			target = candidate;
+			break;
+		}
+	}
+	next_output = (target + 1) % outputs.size();
+
+	TripleBuffer<vision::CapturedFrame>& out = *outputs[target];
+	std::swap(frame, out.back()); // frame now holds an old buffer to capture into next
+	if(!out.publish()) frames_dropped.fetch_add(1);
+}
+
+void action::CaptureFrames::cleanUp(void) {
+	LOG_INFO << "CaptureFrames: " << frames_captured.load() << " captured, " << frames_dropped.load() << " dropped";
+	source.reset();
+}
+
+// ********************************
+// ProcessFrames
+// ********************************
+
+action::ProcessFrames::ProcessFrames() {
+	vision::configureHeading(pipeline);
+	// on approach the target stays about where it was, only search around it
+	pipeline.setTracking(true);
+}
+
+void action::ProcessFrames::step(void) {
+	if(!frame_input.update()) {
+		sleepThread(1); // waiting on capture
+		return;
+	}
+
+	// over budget, let this one go so the next result is fresh rather than late
+	if(pipeline.skipFrame()) return;
+
+	pipeline.process(frame_input.front());
+
+	// the task drains every update, if it has fallen behind this result was overtaken anyway
+	detection_channel.push(pipeline.frame().detection);
+}
+
+// ********************************
+// FramePipeline
+// ********************************
+
+action::FramePipeline::FramePipeline(int worker_count) : last_sequence(0), results(0) {
+	for(int i = 0; i < worker_count; ++i) {
+		workers.push_back(std::unique_ptr<ProcessFrames>(new ProcessFrames()));
+		// capture hands the workers frames in turn, so each has worker_count camera frames to finish one
+		workers.back()->setFrameBudget(CAMERA_FRAME_MS * worker_count);
+		capture_th.addOutput(workers.back()->input());
+	}
+}
+
+bool action::FramePipeline::latest(vision::Detection& out) {
+	bool got = false;
+	vision::Detection d;
+	for(auto& w : workers) {
+		while(w->detections().pop(d)) {
+			if(d.frame_number > last_sequence) {
+				last_sequence = d.frame_number;
+				out = d;
+				got = true;
+			}
+		}
+	}
+
+	if(got) {
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if(results == 0) first_result = now;
+		++results;
+
+		double sec = std::chrono::duration<double>(now - first_result).count();
+		out.fps = (sec > 0 ? (results - 1) / sec : 0);
+	}
+	return got;
+}
+
+void action::FramePipeline::resetStats(void) {
+	last_sequence = 0;
+	results = 0;
 }
 
 void action::MoveTowardsQualGate::step(void) {
@@ -32,5 +138,11 @@ void action::Interpreter::init(void) {
 	makePersistent();
 }
 void action::Interpreter::step(void) {
-	std::getline(std::cin, input);
+	if(!std::getline(std::cin, input)) {
+		sleepThread(100); // stdin closed, don't spin
+		return;
+	}
+	if(!line_channel.push(std::move(input))) {
+		LOG_WARNING << "Interpreter: line channel full, dropping input.";
+	}
 }
\ No newline at end of file
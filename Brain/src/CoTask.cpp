@@ -0,0 +1,83 @@
+#include "CoTask.hpp"
+
+CoTask::CoTask(std::string _instance_name, ThreadManager& _thread_manager, Comms& _comms)
+	: Task(_instance_name, _thread_manager, _comms), resume_point(0), wake(0)
+{
+	waiting = yield();
+}
+
+const Task::Result CoTask::update(void) {
+	switch(getRunType()) {
+		case RunType::Init:
+			resume_point = 0;
+			waiting = yield();
+			wake.cancel();
+			return run();
+
+		case RunType::Normal:
+			return run();
+
+		case RunType::Stop:
+			stop();
+			unloadAll();
+			resume_point = 0;
+			waiting = yield();
+			wake.cancel();
+			break;
+	}
+	return Task::Result(ReturnStatus::Continue, "");
+}
+
+bool CoTask::isAwake(const std::chrono::steady_clock::time_point& now) {
+	switch(waiting.kind) {
+		case Await::Kind::Tick:
+			return true;
+
+		case Await::Kind::Time:
+			return wake.timedOut();
+
+		case Await::Kind::Field:
+			// only look at the value when something new has arrived
+			if(comms.hasNew(waiting.link_id, waiting.field_name, field_since)) {
+				field_since = now;
+				return waiting.predicate();
+			}
+			return false;
+
+		case Await::Kind::Thread:
+			// a step has finished since the await, or the thread is gone
+			return status(*waiting.th) == th_man::ThreadStatus::NotLoaded
+				|| waiting.th->stepCount() != waiting.th_steps;
+	}
+	return true;
+}
+
+void CoTask::suspend(const Await& awaitable) {
+	waiting = awaitable;
+	if(waiting.kind == Await::Kind::Field) field_since = std::chrono::steady_clock::now();
+	if(waiting.kind == Await::Kind::Time) wake.reset(waiting.milliseconds); else wake.cancel();
+}
+
+CoTask::Await CoTask::yield(void) {
+	Await a;
+	a.kind = Await::Kind::Tick;
+	a.th = nullptr;
+	a.th_steps = 0;
+	a.milliseconds = 0;
+	return a;
+}
+
+CoTask::Await CoTask::wait_for(int milliseconds) {
+	Await a = yield();
+	a.kind = Await::Kind::Time;
+	a.milliseconds = milliseconds;
+	return a;
+}
+
+CoTask::Await CoTask::wait_thread(Threadable& th) {
+	Await a = yield();
+	a.kind = Await::Kind::Thread;
+	a.th = &th;
+	a.th_steps = th.stepCount();
+	return a;
+}
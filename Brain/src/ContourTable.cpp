@@ -0,0 +1,70 @@
+#include "Vision/ContourTable.hpp"
+
+#include <algorithm>
+
+using namespace vision;
+
+ContourTable::ContourTable() : contours(nullptr), poly_epsilon(2), polys_used(0) {}
+
+void ContourTable::reset(const ContourStore& _contours, double _poly_epsilon) {
+	entries.clear();
+	contours = &_contours;
+	poly_epsilon = _poly_epsilon;
+	polys_used = 0;
+}
+
+void ContourTable::add(int contour, const cv::Moments& m) {
+	Entry e;
+	e.contour = contour;
+	e.area = m.m00;
+	e.center = cv::Point2f(m.m10 / m.m00, m.m01 / m.m00);
+	e.computed = 0;
+	e.poly_slot = -1;
+	entries.push_back(e);
+}
+
+void ContourTable::rankByArea(std::size_t k) {
+	k = std::min(k, entries.size());
+	// by reference - the entries are small, but there's no reason to copy them to compare
+	std::partial_sort(entries.begin(), entries.begin() + k, entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return lhs.area > rhs.area || (lhs.area == rhs.area && lhs.contour < rhs.contour);
+	});
+}
+
+void ContourTable::setPolyEpsilon(double epsilon) {
+	if(epsilon == poly_epsilon) return;
+	poly_epsilon = epsilon;
+	for(Entry& e : entries) e.computed = 0; // slots are kept and refilled
+}
+
+const std::vector<cv::Point>& ContourTable::poly(std::size_t i) {
+	Entry& e = entries[i];
+	if(e.poly_slot < 0) {
+		if(polys_used == polys.size()) polys.emplace_back();
+		e.poly_slot = polys_used++;
+	}
+	std::vector<cv::Point>& p = polys[e.poly_slot];
+	if(!(e.computed & Poly)) {
+		cv::approxPolyDP(contourMat(*contours, e.contour), p, poly_epsilon, true);
+		e.computed |= Poly;
+	}
+	return p;
+}
+
+const cv::Rect& ContourTable::bounds(std::size_t i) {
+	Entry& e = entries[i];
+	if(!(e.computed & Bounds)) {
+		e.bounds = cv::boundingRect(poly(i));
+		e.computed |= Bounds;
+	}
+	return e.bounds;
+}
+
+const cv::RotatedRect& ContourTable::minBounds(std::size_t i) {
+	Entry& e = entries[i];
+	if(!(e.computed & MinBounds)) {
+		e.min_bounds = cv::minAreaRect(poly(i));
+		e.computed |= MinBounds;
+	}
+	return e.min_bounds;
+}
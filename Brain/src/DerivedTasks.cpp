@@ -137,29 +137,23 @@ const Task::Result Submerge::update(void) {
 // ValidationGate
 // ********************************
 
-ValidationGate::ValidationGate(ThreadManager& _t_m, Comms& _c) : Task("ValidationGate", _t_m, _c),
-    delay(0), operation(0), thrust(30), dur(5) {}
+ValidationGate::ValidationGate(ThreadManager& _t_m, Comms& _c) : CoTask("ValidationGate", _t_m, _c),
+    thrust(30), dur(5) {}
 
-const Task::Result ValidationGate::update(void) {
-    switch(getRunType()) {
-        case RunType::Init:
-            if(comms.isSetAs<int>("pi", "validation_thrust")) thrust = comms.get<int>("pi", "validation_thrust");
-            if(comms.isSetAs<int>("pi", "validation_duration")) dur = comms.get<int>("pi", "validation_duration");
+const Task::Result ValidationGate::run(void) {
+    CO_BEGIN();
+    if(comms.isSetAs<int>("pi", "validation_thrust")) thrust = comms.get<int>("pi", "validation_thrust");
+    if(comms.isSetAs<int>("pi", "validation_duration")) dur = comms.get<int>("pi", "validation_duration");
 
-            operation = 0;
-            comms.send("teensy", "cmd", comms_util::Hint::String, std::string("thrust ") + std::to_string(thrust));
-            delay.reset(dur*1000);
-            break;
-        case RunType::Normal:
-            if(delay.timedOut()) {
-                if(operation == 0) return Task::Result(ReturnStatus::Success, "");
-            }
-            break;
-        case RunType::Stop:
-            comms.send("teensy", "cmd", comms_util::Hint::String, std::string("thrust 0"));
-            break;
-    }
-    return Task::Result(ReturnStatus::Continue, "");
+    comms.send("teensy", "cmd", comms_util::Hint::String, std::string("thrust ") + std::to_string(thrust));
+    CO_AWAIT(wait_for(dur*1000));
+
+    CO_RETURN(ReturnStatus::Success, "");
+    CO_END();
+}
+
+void ValidationGate::stop(void) {
+    comms.send("teensy", "cmd", comms_util::Hint::String, std::string("thrust 0"));
 }
 
 // ********************************
@@ -238,10 +232,14 @@ const Task::Result CommsDaemon::update(void) {
             break;
 
         case RunType::Normal:
-            if(status(a_interpreter) == th_man::ThreadStatus::Paused) {
-                comms.send("pi", "cmdline", comms_util::Hint::String, a_interpreter.getStr());
-                resume(a_interpreter);
+        {
+            // one line per update so the main loop sees every command in 'cmdline'
+            std::string line;
+            if(a_interpreter.lines().pop(line)) {
+                comms.send("pi", "cmdline", comms_util::Hint::String, line);
             }
+            resume(a_interpreter); // keep reading while earlier lines wait in the channel
+        }
 
             comms.receiveAll();
             break;
@@ -264,24 +262,33 @@ const Task::Result CommsDaemon::update(void) {
 // QualifierGateEntry
 // ********************************
 
-QualifierGateEntry::QualifierGateEntry(ThreadManager& _t_m, Comms& _c) : Task("QualifierGateEntry", _t_m, _c) {}
+QualifierGateEntry::QualifierGateEntry(ThreadManager& _t_m, Comms& _c) : Task("QualifierGateEntry", _t_m, _c), on_target(0) {}
 
 const Task::Result QualifierGateEntry::update(void) {
     switch(getRunType()) {
         case RunType::Init:
-            load(a_search, "search", th_man::RunLevel::Worker);
+            if(comms.isSetAs<std::string>("pi", "vision_source")) a_vision.capture().setSource(comms.get<std::string>("pi", "vision_source"));
+            on_target = 0;
+            a_vision.resetStats();
+            load(a_vision.capture(), "capture", th_man::RunLevel::Worker);
+            for(int i = 0; i < a_vision.workerCount(); ++i) load(a_vision.worker(i), "vision " + std::to_string(i), th_man::RunLevel::Worker);
             break;
         case RunType::Normal:
-            if(status(a_search) == th_man::ThreadStatus::Paused) {
-                std::string where_to = a_search.getDirection();
-                
-                if(where_to.find("locked") != std::string::npos) {
-                    unload(a_search);
+            if(status(a_vision.capture()) != th_man::ThreadStatus::NotLoaded) {
+                vision::Detection d;
+                if(a_vision.latest(d)) {
+                    vision::publish(comms, "pi", d);
+                    on_target = (d.heading == vision::Heading::OnTarget ? on_target + 1 : 0);
+                }
+                if(on_target >= 5) { // locked on
+                    unload(a_vision.capture());
+                    for(int i = 0; i < a_vision.workerCount(); ++i) unload(a_vision.worker(i));
                     load(a_move, "move", th_man::RunLevel::Worker);
                 } else {
-                    resume(a_search);
+                    // all three stages run freely, capture paces itself on the source
+                    resume(a_vision.capture());
+                    for(int i = 0; i < a_vision.workerCount(); ++i) resume(a_vision.worker(i));
                 }
-                
             }
             if(status(a_move) == th_man::ThreadStatus::Paused) {
                 resume(a_move);
@@ -0,0 +1,55 @@
+#include "Vision/FrameArena.hpp"
+
+#include <algorithm>
+
+using namespace vision;
+
+FrameArena::FrameArena() : used(0), allocs(0) {
+	// more slots than any pipeline here uses, so the vector itself never grows mid-frame
+	slots.reserve(8);
+}
+
+void FrameArena::reserve(cv::Size frame_size) {
+	// + 2 for the border of the contour labels
+	cv::Size size(frame_size.width + 2, frame_size.height + 2);
+	if(size.width <= frame.width && size.height <= frame.height) return;
+	frame = cv::Size(std::max(size.width, frame.width), std::max(size.height, frame.height));
+
+	row_buffer.reserve(frame.width * 3 + 64);
+	offset_buffer.reserve(frame.width);
+	++allocs;
+}
+
+cv::Mat FrameArena::take(cv::Size size, int type) {
+	if(used == slots.size()) slots.emplace_back();
+	cv::Mat& slot = slots[used++];
+
+	// slots are plain bytes, so the same slot can be a mask one frame and a BGR image the next
+	// (when an optional stage is dropped the requests after it move up a slot) without reallocating
+	int row_bytes = size.width * CV_ELEM_SIZE(type);
+	if(slot.cols < row_bytes || slot.rows < size.height) {
+		int frame_bytes = frame.width * CV_ELEM_SIZE(type);
+		slot.create(std::max(frame.height, size.height), std::max(std::max(frame_bytes, row_bytes), slot.cols), CV_8UC1);
+		++allocs;
+	}
+	return cv::Mat(size.height, size.width, type, slot.data, slot.step);
+}
+
+std::int8_t* FrameArena::labels(cv::Size mask_size) {
+	// the tracer wants (width + 2) * (height + 2) bytes in one piece rather than a view with the slot's stride,
+	// a slot is a continuous Mat at least that many rows and columns, so its memory is used as a flat buffer
+	cv::Mat view = take(cv::Size(mask_size.width + 2, mask_size.height + 2), CV_8SC1);
+	return reinterpret_cast<std::int8_t*>(view.data);
+}
+
+std::uint8_t* FrameArena::row(std::size_t bytes) {
+	if(bytes > row_buffer.capacity()) ++allocs;
+	if(bytes > row_buffer.size()) row_buffer.resize(bytes);
+	return row_buffer.data();
+}
+
+int* FrameArena::offsets(std::size_t count) {
+	if(count > offset_buffer.capacity()) ++allocs;
+	if(count > offset_buffer.size()) offset_buffer.resize(count);
+	return offset_buffer.data();
+}
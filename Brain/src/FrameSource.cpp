@@ -0,0 +1,99 @@
+#include "Vision/FrameSource.hpp"
+
+#include <cctype>
+#include <sys/stat.h>
+
+#include "plog/Log.h"
+
+using namespace vision;
+
+// ********************************
+// CaptureSource
+// ********************************
+
+CaptureSource::CaptureSource(int device, cv::Size frame_size) {
+	description = "camera " + std::to_string(device);
+	live = true;
+	cap.open(device);
+	if(cap.isOpened()) {
+		cap.set(cv::CAP_PROP_FRAME_WIDTH, frame_size.width);
+		cap.set(cv::CAP_PROP_FRAME_HEIGHT, frame_size.height);
+		cap.set(cv::CAP_PROP_BUFFERSIZE, 1); // don't let the driver queue stale frames, ignored where unsupported
+	}
+}
+
+CaptureSource::CaptureSource(const std::string& path) {
+	description = "video " + path;
+	cap.open(path);
+}
+
+CaptureSource::~CaptureSource() {
+	cap.release();
+}
+
+bool CaptureSource::isOpened(void) {
+	return cap.isOpened();
+}
+
+bool CaptureSource::read(cv::Mat& frame) {
+	// grab() + retrieve(), decodes into frame's existing buffer when the size matches
+	return cap.read(frame) && !frame.empty();
+}
+
+// ********************************
+// ImageSequenceSource
+// ********************************
+
+ImageSequenceSource::ImageSequenceSource(const std::string& pattern, bool _loop) : next(0), loop(_loop) {
+	description = "images " + pattern;
+	cv::glob(pattern, files, false); // sorted
+}
+
+bool ImageSequenceSource::isOpened(void) {
+	return !files.empty();
+}
+
+bool ImageSequenceSource::read(cv::Mat& frame) {
+	// skip anything imread can't decode, so a directory can hold a labels file or README
+	for(std::size_t tries = 0; tries < files.size(); ++tries) {
+		if(next == files.size()) {
+			if(!loop) return false;
+			next = 0;
+		}
+		last_file = files[next++];
+		frame = cv::imread(last_file, cv::IMREAD_COLOR);
+		if(!frame.empty()) return true;
+	}
+	return false;
+}
+
+// ********************************
+// openSource
+// ********************************
+
+std::unique_ptr<FrameSource> vision::openSource(const std::string& spec, cv::Size frame_size, bool loop) {
+	std::unique_ptr<FrameSource> source;
+
+	bool all_digits = !spec.empty();
+	for(char c : spec) all_digits = all_digits && std::isdigit(static_cast<unsigned char>(c));
+
+	struct stat info;
+	bool is_dir = (stat(spec.c_str(), &info) == 0 && S_ISDIR(info.st_mode));
+
+	if(all_digits) {
+		source.reset(new CaptureSource(std::stoi(spec), frame_size));
+	} else if(is_dir) {
+		std::string dir = spec;
+		if(dir.back() != '/') dir += '/';
+		source.reset(new ImageSequenceSource(dir + "*", loop));
+	} else if(spec.find_first_of("*?") != std::string::npos) {
+		source.reset(new ImageSequenceSource(spec, loop));
+	} else {
+		source.reset(new CaptureSource(spec));
+	}
+
+	if(!source->isOpened()) {
+		LOG_WARNING << "Could not open frame source '" << spec << "' (" << source->getDescription() << ")";
+	}
+	return source;
+}
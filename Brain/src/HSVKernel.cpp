@@ -0,0 +1,327 @@
+#include "Vision/HSVKernel.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define HSV_KERNEL_NEON
+#elif defined(__SSE4_1__)
+	#include <smmintrin.h>
+	#define HSV_KERNEL_SSE41
+#endif
+
+using namespace vision;
+
+/*
+Everything here has to match OpenCV's RGB2HSV_b (imgproc/color_hsv) exactly:
+	v = max(b, g, r), diff = v - min(b, g, r)
+	s = (diff * sdiv[v] + 2^11) >> 12                  sdiv[v] = round((255 << 12) / v)
+	h = v == r ? g - b : v == g ? b - r + 2*diff : r - g + 4*diff
+	h = (h * hdiv[diff] + 2^11) >> 12, + 180 if negative   hdiv[d] = round((180 << 12) / (6 * d))
+with both tables 0 at index 0.
+
+The vector paths get the table entries from a float divide rather than a
+lookup. That is exact: the quotient N/d is never closer than 1/(2d) to a half
+(no ties), and a correctly rounded float quotient of a 20 bit N is within
+2^-4/d of the true one, so rounding it to the nearest integer always gives the
+table value. armv7 has no float divide, so there the reciprocal estimate is
+refined and the result corrected once with the integer remainder.
+*/
+
+namespace {
+	const int hsv_shift = 12;
+	const int sdiv_numerator = 255 << hsv_shift;
+	const int hdiv_numerator = (180 << hsv_shift) / 6;
+
+	struct DivTables {
+		int sdiv[256];
+		int hdiv[256];
+
+		DivTables() {
+			sdiv[0] = hdiv[0] = 0;
+			for(int i = 1; i < 256; ++i) {
+				// exact round(N / i), the quotients never land on a half
+				sdiv[i] = (2 * sdiv_numerator + i) / (2 * i);
+				hdiv[i] = (2 * hdiv_numerator + i) / (2 * i);
+			}
+		}
+	};
+
+	const DivTables& tables(void) {
+		static const DivTables t;
+		return t;
+	}
+
+	// one pixel, the reference for everything else
+	inline std::uint8_t thresholdPixel(int b, int g, int r, const HSVRange& range, const DivTables& t) {
+		int v = std::max(std::max(b, g), r);
+		if(v < range.lower[2] || v > range.upper[2]) return 0;
+		if(range.v_only) return 255;
+
+		int diff = v - std::min(std::min(b, g), r);
+		int s = (diff * t.sdiv[v] + (1 << (hsv_shift - 1))) >> hsv_shift;
+		if(s < range.lower[1] || s > range.upper[1]) return 0;
+
+		int h = (v == r) ? g - b : (v == g) ? b - r + 2 * diff : r - g + 4 * diff;
+		h = (h * t.hdiv[diff] + (1 << (hsv_shift - 1))) >> hsv_shift;
+		if(h < 0) h += 180;
+		return (h >= range.lower[0] && h <= range.upper[0]) ? 255 : 0;
+	}
+}
+
+HSVRange vision::makeHSVRange(const double lower[3], const double upper[3]) {
+	HSVRange range;
+	range.empty = false;
+	for(int c = 0; c < 3; ++c) {
+		// inRange rounds Scalar bounds with cvRound, which is round half to even
+		long lo = std::lrint(std::max(-1e9, std::min(1e9, lower[c])));
+		long hi = std::lrint(std::max(-1e9, std::min(1e9, upper[c])));
+		if(lo > hi || lo > 255 || hi < 0) {
+			range.empty = true;
+			lo = 255;
+			hi = 0;
+		}
+		range.lower[c] = static_cast<std::uint8_t>(std::max(0L, lo));
+		range.upper[c] = static_cast<std::uint8_t>(std::min(255L, hi));
+	}
+	// H never exceeds 179
+	range.v_only = (range.lower[0] == 0 && range.upper[0] >= 179 && range.lower[1] == 0 && range.upper[1] == 255);
+	return range;
+}
+
+void vision::hsvThresholdRowScalar(const std::uint8_t* bgr, std::uint8_t* mask, int width, const HSVRange& range) {
+	if(range.empty) {
+		std::fill(mask, mask + width, 0);
+		return;
+	}
+	const DivTables& t = tables();
+	for(int i = 0; i < width; ++i, bgr += 3) mask[i] = thresholdPixel(bgr[0], bgr[1], bgr[2], range, t);
+}
+
+#if defined(HSV_KERNEL_NEON)
+
+namespace {
+	// round(n / d) for d > 0, exact for the numerators used here
+	inline int32x4_t divRound(float32x4_t n, int32x4_t d) {
+		float32x4_t df = vcvtq_f32_s32(d);
+	#if defined(__aarch64__)
+		return vcvtnq_s32_f32(vdivq_f32(n, df));
+	#else
+		float32x4_t r = vrecpeq_f32(df);
+		r = vmulq_f32(vrecpsq_f32(df, r), r);
+		r = vmulq_f32(vrecpsq_f32(df, r), r);
+		int32x4_t q = vcvtq_s32_f32(vaddq_f32(vmulq_f32(n, r), vdupq_n_f32(0.5f)));
+		// the estimate can be one off, step q towards the side the remainder says
+		int32x4_t rem2 = vshlq_n_s32(vmlsq_s32(vcvtq_s32_f32(n), q, d), 1);
+		q = vsubq_s32(q, vreinterpretq_s32_u32(vcgtq_s32(rem2, d))); // true is -1
+		q = vaddq_s32(q, vreinterpretq_s32_u32(vcltq_s32(rem2, vnegq_s32(d))));
+		return q;
+	#endif
+	}
+
+	inline bool anySet(uint8x16_t x) {
+	#if defined(__aarch64__)
+		return vmaxvq_u8(x) != 0;
+	#else
+		uint32x2_t t = vreinterpret_u32_u8(vorr_u8(vget_low_u8(x), vget_high_u8(x)));
+		return (vget_lane_u32(t, 0) | vget_lane_u32(t, 1)) != 0;
+	#endif
+	}
+
+	// 4 pixels widened to 32 bits -> 0xffffffff where H and S are out of range
+	inline uint32x4_t outOfRangeHS(int32x4_t v, int32x4_t diff, int32x4_t h_raw, const HSVRange& range) {
+		const int32x4_t one = vdupq_n_s32(1);
+		const int32x4_t half = vdupq_n_s32(1 << (hsv_shift - 1));
+
+		int32x4_t sdiv = divRound(vdupq_n_f32(static_cast<float>(sdiv_numerator)), vmaxq_s32(v, one));
+		int32x4_t s = vshrq_n_s32(vmlaq_s32(half, diff, sdiv), hsv_shift);
+
+		int32x4_t hdiv = divRound(vdupq_n_f32(static_cast<float>(hdiv_numerator)), vmaxq_s32(diff, one));
+		int32x4_t h = vshrq_n_s32(vmlaq_s32(half, h_raw, hdiv), hsv_shift);
+		h = vaddq_s32(h, vandq_s32(vreinterpretq_s32_u32(vcltq_s32(h, vdupq_n_s32(0))), vdupq_n_s32(180)));
+
+		uint32x4_t out = vorrq_u32(vcltq_s32(h, vdupq_n_s32(range.lower[0])), vcgtq_s32(h, vdupq_n_s32(range.upper[0])));
+		out = vorrq_u32(out, vcltq_s32(s, vdupq_n_s32(range.lower[1])));
+		return vorrq_u32(out, vcgtq_s32(s, vdupq_n_s32(range.upper[1])));
+	}
+
+	// 8 pixels at 16 bits -> 0xffff where H and S are out of range
+	inline uint16x8_t outOfRangeHS8(uint16x8_t v, uint16x8_t diff, int16x8_t h_raw, const HSVRange& range) {
+		uint32x4_t lo = outOfRangeHS(vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v))), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(diff))), vmovl_s16(vget_low_s16(h_raw)), range);
+		uint32x4_t hi = outOfRangeHS(vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v))), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(diff))), vmovl_s16(vget_high_s16(h_raw)), range);
+		return vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+	}
+
+	// H before the divide, for 8 pixels
+	inline int16x8_t hueNumerator(uint8x8_t b8, uint8x8_t g8, uint8x8_t r8, uint8x8_t diff8, uint8x8_t vr8, uint8x8_t vg8) {
+		int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(b8));
+		int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(g8));
+		int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(r8));
+		int16x8_t diff = vreinterpretq_s16_u16(vmovl_u8(diff8));
+		uint16x8_t vr = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vr8)));
+		uint16x8_t vg = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vg8)));
+
+		int16x8_t h_r = vsubq_s16(g, b);
+		int16x8_t h_g = vaddq_s16(vsubq_s16(b, r), vshlq_n_s16(diff, 1));
+		int16x8_t h_b = vaddq_s16(vsubq_s16(r, g), vshlq_n_s16(diff, 2));
+		return vbslq_s16(vr, h_r, vbslq_s16(vg, h_g, h_b));
+	}
+}
+
+void vision::hsvThresholdRow(const std::uint8_t* bgr, std::uint8_t* mask, int width, const HSVRange& range) {
+	if(range.empty) {
+		std::fill(mask, mask + width, 0);
+		return;
+	}
+
+	const uint8x16_t lower_v = vdupq_n_u8(range.lower[2]);
+	const uint8x16_t upper_v = vdupq_n_u8(range.upper[2]);
+
+	int i = 0;
+	for(; i + 16 <= width; i += 16) {
+		uint8x16x3_t px = vld3q_u8(bgr + 3 * i);
+		uint8x16_t b = px.val[0], g = px.val[1], r = px.val[2];
+
+		uint8x16_t v = vmaxq_u8(vmaxq_u8(b, g), r);
+		uint8x16_t in = vandq_u8(vcgeq_u8(v, lower_v), vcleq_u8(v, upper_v));
+		if(range.v_only || !anySet(in)) {
+			vst1q_u8(mask + i, in);
+			continue;
+		}
+
+		uint8x16_t diff = vsubq_u8(v, vminq_u8(vminq_u8(b, g), r));
+		uint8x16_t vr = vceqq_u8(v, r);
+		uint8x16_t vg = vceqq_u8(v, g);
+
+		int16x8_t h_lo = hueNumerator(vget_low_u8(b), vget_low_u8(g), vget_low_u8(r), vget_low_u8(diff), vget_low_u8(vr), vget_low_u8(vg));
+		int16x8_t h_hi = hueNumerator(vget_high_u8(b), vget_high_u8(g), vget_high_u8(r), vget_high_u8(diff), vget_high_u8(vr), vget_high_u8(vg));
+
+		uint16x8_t out_lo = outOfRangeHS8(vmovl_u8(vget_low_u8(v)), vmovl_u8(vget_low_u8(diff)), h_lo, range);
+		uint16x8_t out_hi = outOfRangeHS8(vmovl_u8(vget_high_u8(v)), vmovl_u8(vget_high_u8(diff)), h_hi, range);
+		uint8x16_t out = vcombine_u8(vmovn_u16(out_lo), vmovn_u16(out_hi));
+
+		vst1q_u8(mask + i, vbicq_u8(in, out));
+	}
+	hsvThresholdRowScalar(bgr + 3 * i, mask + i, width - i, range);
+}
+
+const char* vision::hsvKernelPath(void) {
+	return "neon";
+}
+
+#elif defined(HSV_KERNEL_SSE41)
+
+namespace {
+	// round(n / d) for d > 0, exact for the numerators used here (see the top of the file)
+	inline __m128i divRound(__m128 n, __m128i d) {
+		return _mm_cvtps_epi32(_mm_div_ps(n, _mm_cvtepi32_ps(d))); // round to nearest
+	}
+
+	// 4 pixels widened to 32 bits -> 0xffffffff where H and S are out of range
+	inline __m128i outOfRangeHS(__m128i v, __m128i diff, __m128i h_raw, const HSVRange& range) {
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i half = _mm_set1_epi32(1 << (hsv_shift - 1));
+
+		__m128i sdiv = divRound(_mm_set1_ps(static_cast<float>(sdiv_numerator)), _mm_max_epi32(v, one));
+		__m128i s = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(diff, sdiv), half), hsv_shift);
+
+		__m128i hdiv = divRound(_mm_set1_ps(static_cast<float>(hdiv_numerator)), _mm_max_epi32(diff, one));
+		__m128i h = _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(h_raw, hdiv), half), hsv_shift);
+		h = _mm_add_epi32(h, _mm_and_si128(_mm_srai_epi32(h, 31), _mm_set1_epi32(180)));
+
+		__m128i out = _mm_or_si128(_mm_cmplt_epi32(h, _mm_set1_epi32(range.lower[0])), _mm_cmpgt_epi32(h, _mm_set1_epi32(range.upper[0])));
+		out = _mm_or_si128(out, _mm_cmplt_epi32(s, _mm_set1_epi32(range.lower[1])));
+		return _mm_or_si128(out, _mm_cmpgt_epi32(s, _mm_set1_epi32(range.upper[1])));
+	}
+
+	// H before the divide for 8 pixels, inputs already widened to 16 bits (masks sign extended)
+	inline __m128i hueNumerator(__m128i b, __m128i g, __m128i r, __m128i diff, __m128i vr, __m128i vg) {
+		__m128i h_r = _mm_sub_epi16(g, b);
+		__m128i h_g = _mm_add_epi16(_mm_sub_epi16(b, r), _mm_slli_epi16(diff, 1));
+		__m128i h_b = _mm_add_epi16(_mm_sub_epi16(r, g), _mm_slli_epi16(diff, 2));
+		return _mm_blendv_epi8(_mm_blendv_epi8(h_b, h_g, vg), h_r, vr);
+	}
+
+	// 8 pixels at 16 bits -> 0xffff where H and S are out of range
+	inline __m128i outOfRangeHS8(__m128i v, __m128i diff, __m128i h_raw, const HSVRange& range) {
+		__m128i lo = outOfRangeHS(_mm_cvtepu16_epi32(v), _mm_cvtepu16_epi32(diff), _mm_cvtepi16_epi32(h_raw), range);
+		__m128i hi = outOfRangeHS(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8)), _mm_cvtepu16_epi32(_mm_srli_si128(diff, 8)), _mm_cvtepi16_epi32(_mm_srli_si128(h_raw, 8)), range);
+		return _mm_packs_epi32(lo, hi);
+	}
+
+	inline __m128i lowU8(__m128i x) { return _mm_cvtepu8_epi16(x); }
+	inline __m128i highU8(__m128i x) { return _mm_unpackhi_epi8(x, _mm_setzero_si128()); }
+	inline __m128i lowMask(__m128i x) { return _mm_cvtepi8_epi16(x); }
+	inline __m128i highMask(__m128i x) { return _mm_unpackhi_epi8(x, x); }
+}
+
+void vision::hsvThresholdRow(const std::uint8_t* bgr, std::uint8_t* mask, int width, const HSVRange& range) {
+	if(range.empty) {
+		std::fill(mask, mask + width, 0);
+		return;
+	}
+
+	// pull the B, G and R bytes of 16 packed pixels out of 3 loads, -1 (0x80) zeroes the byte
+	const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+	const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+	const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+	const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+	const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+	const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+	const __m128i lower_v = _mm_set1_epi8(static_cast<char>(range.lower[2]));
+	const __m128i upper_v = _mm_set1_epi8(static_cast<char>(range.upper[2]));
+
+	int i = 0;
+	for(; i + 16 <= width; i += 16) {
+		const std::uint8_t* p = bgr + 3 * i;
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+		__m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, b0), _mm_shuffle_epi8(m, b1)), _mm_shuffle_epi8(c, b2));
+		__m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, g0), _mm_shuffle_epi8(m, g1)), _mm_shuffle_epi8(c, g2));
+		__m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, r0), _mm_shuffle_epi8(m, r1)), _mm_shuffle_epi8(c, r2));
+
+		// unsigned v >= lower and v <= upper
+		__m128i v = _mm_max_epu8(_mm_max_epu8(b, g), r);
+		__m128i in = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, lower_v), v), _mm_cmpeq_epi8(_mm_min_epu8(v, upper_v), v));
+		if(range.v_only || _mm_movemask_epi8(in) == 0) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), in);
+			continue;
+		}
+
+		__m128i diff = _mm_sub_epi8(v, _mm_min_epu8(_mm_min_epu8(b, g), r));
+		__m128i vr = _mm_cmpeq_epi8(v, r);
+		__m128i vg = _mm_cmpeq_epi8(v, g);
+
+		__m128i h_lo = hueNumerator(lowU8(b), lowU8(g), lowU8(r), lowU8(diff), lowMask(vr), lowMask(vg));
+		__m128i h_hi = hueNumerator(highU8(b), highU8(g), highU8(r), highU8(diff), highMask(vr), highMask(vg));
+
+		__m128i out_lo = outOfRangeHS8(lowU8(v), lowU8(diff), h_lo, range);
+		__m128i out_hi = outOfRangeHS8(highU8(v), highU8(diff), h_hi, range);
+		__m128i out = _mm_packs_epi16(out_lo, out_hi); // -1 stays -1
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), _mm_andnot_si128(out, in));
+	}
+	hsvThresholdRowScalar(bgr + 3 * i, mask + i, width - i, range);
+}
+
+const char* vision::hsvKernelPath(void) {
+	return "sse4.1";
+}
+
+#else
+
+void vision::hsvThresholdRow(const std::uint8_t* bgr, std::uint8_t* mask, int width, const HSVRange& range) {
+	hsvThresholdRowScalar(bgr, mask, width, range);
+}
+
+const char* vision::hsvKernelPath(void) {
+	return "scalar";
+}
+
+#endif
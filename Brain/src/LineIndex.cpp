@@ -0,0 +1,131 @@
+#include "Vision/LineIndex.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace vision;
+
+LineIndex::LineIndex() : tolerance(0) {}
+
+void LineIndex::clear(void) {
+	x1.clear();
+	y1.clear();
+	x2.clear();
+	y2.clear();
+	mid_x.clear();
+	mid_y.clear();
+	length.clear();
+	angle.clear();
+	bucket_pos.clear();
+	bucket.clear();
+	for(std::vector<int>& b : buckets) b.clear();
+}
+
+void LineIndex::add(cv::Point2f p1, cv::Point2f p2) {
+	x1.push_back(p1.x);
+	y1.push_back(p1.y);
+	x2.push_back(p2.x);
+	y2.push_back(p2.y);
+	mid_x.push_back((p1.x + p2.x) * 0.5f);
+	mid_y.push_back((p1.y + p2.y) * 0.5f);
+	length.push_back(std::hypot(p2.x - p1.x, p2.y - p1.y));
+
+	float a = std::atan2(p2.y - p1.y, p2.x - p1.x);
+	if(a < 0) a += (float)CV_PI;
+	if(a >= (float)CV_PI) a -= (float)CV_PI;
+	angle.push_back(a);
+}
+
+void LineIndex::permute(std::vector<float>& v) {
+	scratch.resize(order.size());
+	for(std::size_t k = 0; k < order.size(); ++k) scratch[k] = v[order[k]];
+	v.swap(scratch); // the old buffer becomes the next scratch, so nothing is allocated once both have grown
+}
+
+std::size_t LineIndex::build(std::size_t max_lines, double _tolerance) {
+	const std::size_t n = length.size();
+	const std::size_t keep = std::min(n, max_lines);
+
+	order.resize(n);
+	std::iota(order.begin(), order.end(), 0);
+	auto longer = [this](int a, int b) { return length[a] > length[b] || (length[a] == length[b] && a < b); };
+	if(keep < n) {
+		std::partial_sort(order.begin(), order.begin() + keep, order.end(), longer);
+		order.resize(keep);
+	} else {
+		std::sort(order.begin(), order.end(), longer);
+	}
+
+	permute(x1);
+	permute(y1);
+	permute(x2);
+	permute(y2);
+	permute(mid_x);
+	permute(mid_y);
+	permute(length);
+	permute(angle);
+
+	// buckets at least tolerance wide, so a parallel line is never more than one bucket over
+	tolerance = _tolerance;
+	std::size_t count = (tolerance > 0 ? std::max(1, (int)(CV_PI / tolerance)) : 1);
+	buckets.resize(count);
+	for(std::vector<int>& b : buckets) b.clear();
+
+	bucket.resize(keep);
+	bucket_pos.resize(keep);
+	for(std::size_t i = 0; i < keep; ++i) {
+		std::size_t b = bucketOf(angle[i]);
+		bucket[i] = b;
+		bucket_pos[i] = buckets[b].size();
+		buckets[b].push_back(i);
+	}
+	return n - keep;
+}
+
+std::size_t LineIndex::bucketOf(float a) const {
+	std::size_t b = (std::size_t)(a / CV_PI * buckets.size());
+	return std::min(b, buckets.size() - 1);
+}
+
+void LineIndex::markUsed(std::size_t i) {
+	int pos = bucket_pos[i];
+	if(pos < 0) return;
+
+	// swap with the last of the bucket and drop it, the order in a bucket doesn't matter
+	std::vector<int>& b = buckets[bucket[i]];
+	int last = b.back();
+	b[pos] = last;
+	bucket_pos[last] = pos;
+	b.pop_back();
+	bucket_pos[i] = -1;
+}
+
+int LineIndex::nearestParallel(std::size_t i, float min_length) const {
+	const std::size_t count = buckets.size();
+	std::size_t first = bucket[i] + count - 1, last = bucket[i] + count + 1;
+	if(count < 3) {
+		// every bucket is a neighbour
+		first = 0;
+		last = count - 1;
+	}
+
+	int best = -1;
+	float best_dist = 0;
+	for(std::size_t k = first; k <= last; ++k) {
+		for(int j : buckets[k % count]) {
+			if(j == (int)i || length[j] < min_length) continue;
+
+			float diff = std::fabs(angle[i] - angle[j]);
+			diff = std::min(diff, (float)CV_PI - diff);
+			if(diff >= tolerance) continue;
+
+			float dx = mid_x[j] - mid_x[i], dy = mid_y[j] - mid_y[i];
+			float dist = dx * dx + dy * dy;
+			if(best < 0 || dist < best_dist || (dist == best_dist && j < best)) {
+				best = j;
+				best_dist = dist;
+			}
+		}
+	}
+	return best;
+}
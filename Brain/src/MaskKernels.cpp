@@ -0,0 +1,221 @@
+#include "Vision/MaskKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace vision;
+
+// ********************************
+// dilateRect
+// ********************************
+
+/*
+A square is separable: the max over a column window, then over a row window of
+that. Both loops run over a whole row with no dependencies between pixels, so
+-O3 vectorizes them. Out of the image counts as 0, which can't win a max - the
+same as OpenCV's default border for dilate.
+*/
+void vision::dilateRect(const std::uint8_t* src, std::size_t src_step, std::uint8_t* dst, std::size_t dst_step,
+	int width, int height, int size, std::uint8_t* row) {
+	const int before = size / 2; // OpenCV's default anchor is the kernel's center
+	const int after = size - 1 - before;
+
+	for(int y = 0; y < height; ++y) {
+		std::uint8_t* out = dst + y * dst_step;
+
+		int first = std::max(0, y - before), last = std::min(height - 1, y + after);
+		std::memcpy(out, src + first * src_step, width);
+		for(int j = first + 1; j <= last; ++j) {
+			const std::uint8_t* in = src + j * src_step;
+			for(int x = 0; x < width; ++x) out[x] = std::max(out[x], in[x]);
+		}
+
+		// padded copy of the column maxima, so the row window needs no edge cases
+		std::memset(row, 0, before);
+		std::memcpy(row + before, out, width);
+		std::memset(row + before + width, 0, after);
+		for(int k = 1; k < size; ++k) {
+			const std::uint8_t* in = row + k;
+			for(int x = 0; x < width; ++x) out[x] = std::max(out[x], in[x]);
+		}
+		// out started as the column max at x, which is row[x + before] and not row[x]
+		if(before > 0) {
+			for(int x = 0; x < width; ++x) out[x] = std::max(out[x], row[x]);
+		}
+	}
+}
+
+// ********************************
+// decimate
+// ********************************
+
+void vision::decimate(const std::uint8_t* src, std::size_t src_step, int src_width, int src_height,
+	std::uint8_t* dst, std::size_t dst_step, int dst_width, int dst_height, int channels, int* x_ofs) {
+	// resizeNN in imgproc/resize.cpp: source pixel floor(x * src / dst), clamped to the last one
+	const double ifx = 1. / ((double)dst_width / src_width);
+	const double ify = 1. / ((double)dst_height / src_height);
+
+	for(int x = 0; x < dst_width; ++x) {
+		int sx = (int)std::floor(x * ifx);
+		x_ofs[x] = std::min(sx, src_width - 1) * channels;
+	}
+
+	for(int y = 0; y < dst_height; ++y) {
+		int sy = std::min((int)std::floor(y * ify), src_height - 1);
+		const std::uint8_t* in = src + sy * src_step;
+		std::uint8_t* out = dst + y * dst_step;
+		if(channels == 3) {
+			for(int x = 0; x < dst_width; ++x, out += 3) {
+				const std::uint8_t* p = in + x_ofs[x];
+				out[0] = p[0];
+				out[1] = p[1];
+				out[2] = p[2];
+			}
+		} else {
+			for(int x = 0; x < dst_width; ++x, out += channels) std::memcpy(out, in + x_ofs[x], channels);
+		}
+	}
+}
+
+// ********************************
+// traceExternalContours
+// ********************************
+
+/*
+This follows cvFindNextContour and icvFetchContour (imgproc/contours.cpp) for
+RETR_EXTERNAL and CHAIN_APPROX_SIMPLE step for step, so the points, where each
+contour starts and the order of the contours all come out the same:
+	labels  ~ the mask as 0/1 with a 1 pixel border of 0. Border following marks
+	          the pixels it visits 2, or -126 when the pixel to their right is
+	          outside the object
+	scan    ~ a 0 -> 1 step starts an outer border. It is only followed when the
+	          last marked pixel to the left on the row isn't a positive mark -
+	          otherwise the step is the edge of something inside a hole
+	follow  ~ around the border counter-clockwise in the 8 neighbourhood,
+	          keeping a point wherever the direction changes
+OpenCV hands the contours back newest first, so they're reversed at the end.
+*/
+
+namespace {
+	const int code_dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+	const int code_dy[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+
+	const std::int8_t marked = 2;
+	const std::int8_t marked_right = (std::int8_t)(2 | -128);
+
+	void followBorder(std::int8_t* i0, const std::ptrdiff_t* deltas, int x, int y, ContourStore& out) {
+		// the first object pixel clockwise from the left, which is outside
+		int s = 4;
+		const int s_start = s;
+		std::int8_t* i1;
+		do {
+			s = (s - 1) & 7;
+			i1 = i0 + deltas[s];
+		} while(*i1 == 0 && s != s_start);
+
+		if(s == s_start) {
+			// a pixel on its own
+			*i0 = marked_right;
+			out.xy.push_back(x);
+			out.xy.push_back(y);
+			return;
+		}
+
+		std::int8_t* i3 = i0;
+		std::int8_t* i4;
+		int prev_s = s ^ 4;
+		for(;;) {
+			int s_end = s;
+			while(s < 15) {
+				i4 = i3 + deltas[++s];
+				if(*i4 != 0) break;
+			}
+			s &= 7;
+
+			// passed over the right neighbour and it was outside
+			if((unsigned)(s - 1) < (unsigned)s_end) *i3 = marked_right;
+			else if(*i3 == 1) *i3 = marked;
+
+			if(s != prev_s) {
+				out.xy.push_back(x);
+				out.xy.push_back(y);
+				prev_s = s;
+			}
+			x += code_dx[s];
+			y += code_dy[s];
+
+			if(i4 == i0 && i3 == i1) break;
+			i3 = i4;
+			s = (s + 4) & 7;
+		}
+	}
+
+	// reverses the order of n x, y pairs
+	void reversePoints(int* p, std::size_t n) {
+		for(std::size_t i = 0, j = n - 1; i + 1 <= j && j < n; ++i, --j) {
+			std::swap(p[2 * i], p[2 * j]);
+			std::swap(p[2 * i + 1], p[2 * j + 1]);
+		}
+	}
+
+	void reverseContours(ContourStore& out) {
+		const std::size_t n = out.size();
+		if(n < 2) return;
+
+		// reversing every contour, then all the points, puts the contours in reverse order with their points the right way round
+		for(std::size_t i = 0; i < n; ++i) reversePoints(out.points(i), out.count(i));
+		reversePoints(out.xy.data(), out.xy.size() / 2);
+
+		// contour i now starts where contour n - 1 - i ended, counted from the back
+		const int total = out.starts[n];
+		for(std::size_t i = 0; i < n / 2; ++i) std::swap(out.starts[i + 1], out.starts[n - i - 1]);
+		for(std::size_t i = 1; i < n; ++i) out.starts[i] = total - out.starts[i];
+	}
+}
+
+void vision::traceExternalContours(const std::uint8_t* mask, std::size_t step, int width, int height,
+	int offset_x, int offset_y, std::int8_t* labels, ContourStore& out) {
+	out.clear();
+	if(width <= 0 || height <= 0) return;
+
+	const int lw = width + 2, lh = height + 2;
+	std::memset(labels, 0, lw);
+	for(int y = 0; y < height; ++y) {
+		std::int8_t* l = labels + (y + 1) * lw;
+		const std::uint8_t* m = mask + y * step;
+		l[0] = 0;
+		for(int x = 0; x < width; ++x) l[x + 1] = (m[x] != 0);
+		l[width + 1] = 0;
+	}
+	std::memset(labels + (lh - 1) * lw, 0, lw);
+
+	// neighbour offsets in direction order, twice over so a search can run past 7
+	std::ptrdiff_t deltas[16] = { 1, -lw + 1, -lw, -lw - 1, -1, lw - 1, lw, lw + 1 };
+	for(int k = 0; k < 8; ++k) deltas[k + 8] = deltas[k];
+
+	for(int y = 1; y < lh - 1; ++y) {
+		std::int8_t* img = labels + y * lw;
+		int lnbd = 0; // x of the last marked pixel stepped onto in this row, the border column to start with
+		int prev = 0;
+		for(int x = 1; x < lw - 1; ++x) {
+			int p = img[x];
+			if(p == prev) continue;
+
+			if(prev == 0 && p == 1 && img[lnbd] <= 0) {
+				std::size_t before = out.xy.size();
+				followBorder(img + x, deltas, x - 1 + offset_x, y - 1 + offset_y, out);
+				out.starts.push_back(out.starts.back() + (int)(out.xy.size() - before) / 2);
+				prev = img[x]; // marked now, and lnbd isn't moved for it
+				continue;
+			}
+
+			// a hole's edge moves lnbd back onto the object pixel before it
+			if(p == 0 && prev >= 1 && (prev & -2)) lnbd = x - 1;
+			prev = p;
+			if(prev & -2) lnbd = x;
+		}
+	}
+
+	reverseContours(out);
+}
@@ -0,0 +1,100 @@
+#include "Vision/QualityGovernor.hpp"
+
+#include <algorithm>
+
+using namespace vision;
+
+namespace {
+	const QualityLevel levels[] = {
+		{ true, 1, 0 },
+		{ false, 1, 0 },
+		{ false, 2, 0 },
+		{ false, 2, 1 },
+		{ false, 2, 2 }
+	};
+	const int level_count = sizeof(levels) / sizeof(levels[0]);
+
+	const double smoothing = 0.2; // weight of the newest frame in smoothed_ms
+	const unsigned max_backoff = 16;
+}
+
+QualityGovernor::QualityGovernor() : budget_ms(0), hold_frames(5), recover_frames(30), recover_ratio(0.5),
+	current_level(0), smoothed_ms(-1), over(0), under(0), since_change(0), recover_wait(30), recovered(false), skip_count(0),
+	frames_skipped(0), changes(0) {}
+
+void QualityGovernor::setBudget(double _budget_ms, unsigned _hold_frames, unsigned _recover_frames, double _recover_ratio) {
+	budget_ms = _budget_ms;
+	hold_frames = std::max(1u, _hold_frames);
+	recover_frames = std::max(1u, _recover_frames);
+	recover_ratio = _recover_ratio;
+	recover_wait = recover_frames;
+	recovered = false;
+	changeLevel(0);
+}
+
+const QualityLevel& QualityGovernor::current(void) const {
+	return levels[current_level];
+}
+
+int QualityGovernor::levelCount(void) {
+	return level_count;
+}
+
+bool QualityGovernor::skip(void) {
+	if(skip_count < levels[current_level].skip) {
+		++skip_count;
+		++frames_skipped;
+		return true;
+	}
+	skip_count = 0;
+	return false;
+}
+
+double QualityGovernor::levelBudget(int level) const {
+	return budget_ms * (levels[level].skip + 1);
+}
+
+void QualityGovernor::update(double frame_ms) {
+	if(!enabled()) return;
+
+	++since_change;
+	if(recovered && since_change > recover_wait) {
+		// the step up held, the next one doesn't need to wait as long
+		recovered = false;
+		recover_wait = recover_frames;
+	}
+	smoothed_ms = (smoothed_ms < 0 ? frame_ms : smoothed_ms + smoothing * (frame_ms - smoothed_ms));
+
+	if(smoothed_ms > levelBudget(current_level)) {
+		under = 0;
+		if(++over >= hold_frames && current_level + 1 < level_count) {
+			// back off if the last step up didn't hold, otherwise it's a new load and recovery starts fresh
+			recover_wait = (recovered && since_change <= recover_wait ? std::min(recover_wait * 2, recover_frames * max_backoff) : recover_frames);
+			recovered = false;
+			changeLevel(current_level + 1);
+		}
+	} else if(current_level > 0 && smoothed_ms < levelBudget(current_level - 1) * recover_ratio) {
+		over = 0;
+		if(++under >= recover_wait) {
+			recovered = true;
+			changeLevel(current_level - 1);
+		}
+	} else {
+		over = under = 0;
+	}
+}
+
+void QualityGovernor::changeLevel(int level) {
+	if(level != current_level) ++changes;
+	current_level = level;
+	// what the last level cost says little about this one
+	smoothed_ms = -1;
+	over = under = 0;
+	since_change = 0;
+	skip_count = 0;
+}
+
+void QualityGovernor::resetStats(void) {
+	frames_skipped = 0;
+	changes = 0;
+}
@@ -6,6 +6,7 @@
 #include "plog/Log.h"
 
 #include "string_util.hpp"
+#include "TimerWheel.hpp"
 
 TaskManager::TaskManager() : NamedClass("TaskManager") {
 }
@@ -106,9 +107,11 @@ void TaskManager::killAll(bool reset_after_kill) {
 }
 
 void TaskManager::update(bool reset_after_branch) {
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now(); // one clock read per tick, shared by all tasks
+	TimerWheel::shared().advance(now); // expire TimeOuts before tasks look at them
 	for(auto& task_entry : tasks) {
 		std::shared_ptr<Task> task = task_entry.second;
-		if(task->getState() == Task::State::Running) {
+		if(task->getState() == Task::State::Running && task->isAwake(now)) {
 			Task::Result result = task->update();
 			if(result.getStatus() != Task::ReturnStatus::Continue) {
 				task->kill(reset_after_branch);
@@ -0,0 +1,67 @@
+#include "Comms/TelemetryFrame.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace {
+	std::uint16_t u16(const std::uint8_t* p) { return (std::uint16_t)(p[0] | p[1] << 8); }
+	std::uint32_t u32(const std::uint8_t* p) { return (std::uint32_t)p[0] | (std::uint32_t)p[1] << 8 | (std::uint32_t)p[2] << 16 | (std::uint32_t)p[3] << 24; }
+	float f32(const std::uint8_t* p) {
+		std::uint32_t bits = u32(p);
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+}
+
+telemetry::Result telemetry::decode(const std::uint8_t* data, std::size_t size, Frame& frame) {
+	// the header can rule a frame out before all of it has arrived
+	if(size == 0 || data[0] != SYNC0) return Result::Bad;
+	if(size > 1 && data[1] != SYNC1) return Result::Bad;
+	if(size > 2 && data[2] != VERSION) return Result::Bad;
+	if(size > 3 && data[3] != FRAME_SIZE) return Result::Bad;
+	if(size < FRAME_SIZE) return Result::NeedMore;
+	if(crc16(data, FRAME_SIZE - 2) != u16(data + FRAME_SIZE - 2)) return Result::Bad;
+
+	frame.seq = u32(data + 4);
+	frame.time_ms = u32(data + 8);
+	frame.pressure = f32(data + 12);
+	frame.temperature = f32(data + 16);
+	frame.yaw = f32(data + 20);
+	frame.pitch = f32(data + 24);
+	frame.roll = f32(data + 28);
+	for(int i = 0; i < AXES; ++i) frame.pid_out[i] = f32(data + 32 + 4 * i);
+	for(int i = 0; i < THRUSTERS; ++i) frame.power[i] = (std::int8_t)data[48 + i];
+	frame.pid_auto = data[54];
+	frame.flags = data[55];
+	frame.kill_adc = u16(data + 56);
+	return Result::Ok;
+}
+
+std::uint16_t telemetry::crc16(const std::uint8_t* data, std::size_t size) {
+	// a byte at a time from a table, the bit at a time version costs more than the rest of decode() put together
+	static const std::array<std::uint16_t, 256> table = [] {
+		std::array<std::uint16_t, 256> t;
+		for(int i = 0; i < 256; ++i) {
+			std::uint16_t crc = (std::uint16_t)(i << 8);
+			for(int b = 0; b < 8; ++b) crc = crc & 0x8000 ? (std::uint16_t)((crc << 1) ^ 0x1021) : (std::uint16_t)(crc << 1);
+			t[i] = crc;
+		}
+		return t;
+	}();
+
+	std::uint16_t crc = 0xFFFF;
+	while(size--) crc = (std::uint16_t)(crc << 8) ^ table[(crc >> 8) ^ *data++];
+	return crc;
+}
+
+std::uint32_t telemetry::SequenceTracker::update(std::uint32_t seq) {
+	std::uint32_t gap = 0;
+	// a seq behind the one expected is the teensy starting over, not frames lost
+	if(started && seq >= expected) gap = seq - expected;
+	started = true;
+	expected = seq + 1;
+	++received_cnt;
+	lost_cnt += gap;
+	return gap;
+}
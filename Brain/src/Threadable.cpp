@@ -3,7 +3,7 @@
 #include <thread>
 #include <chrono>
 
-Threadable::Threadable() : allow_step(true), working(false), clean_up_next(false), init_complete(false), persistent(false) {}
+Threadable::Threadable() : allow_step(true), working(false), clean_up_next(false), init_complete(false), persistent(false), steps_completed(0) {}
 
 void Threadable::operator()(void) {
 	if(init_complete) {
@@ -24,6 +24,7 @@ void Threadable::operator()(void) {
 
 					working.store(true);
 					step();
+					steps_completed.fetch_add(1);
 					working.store(false);
 				} else {
 					sleepThread(0);
@@ -0,0 +1,120 @@
+#include "TimerWheel.hpp"
+
+TimerWheel::Timer::~Timer() {
+	if(wheel != nullptr) wheel->cancel(*this);
+}
+
+TimerWheel::TimerWheel() : origin(clock::now()), next_tick(1), pending_count(0) {
+	for(int l = 0; l < levels; ++l) {
+		for(int s = 0; s < slots; ++s) wheel[l][s] = nullptr;
+	}
+}
+
+TimerWheel::~TimerWheel() {
+	// leave any remaining timers in a sane state so their destructors don't touch this wheel
+	for(int l = 0; l < levels; ++l) {
+		for(int s = 0; s < slots; ++s) {
+			while(wheel[l][s] != nullptr) {
+				Timer* t = wheel[l][s];
+				unlink(*t);
+				t->wheel = nullptr;
+			}
+		}
+	}
+}
+
+TimerWheel& TimerWheel::shared(void) {
+	static TimerWheel instance;
+	return instance;
+}
+
+void TimerWheel::schedule(Timer& timer, int milliseconds) {
+	if(timer.isPending()) unlink(timer);
+
+	// read the clock here rather than trusting the last advance(), a timer started
+	// before TaskManager begins ticking should still get its full duration. toTick()
+	// floors, so the start could be up to a tick behind now - expiring a tick later
+	// means it never fires before its duration is up, same as the old now > start + dur
+	std::uint64_t start = toTick(clock::now());
+	std::uint64_t expiry = start + (milliseconds > 0 ? milliseconds : 0) + 1;
+	if(expiry < next_tick) expiry = next_tick;
+
+	timer.wheel = this;
+	timer.expiry = expiry;
+	file(timer);
+}
+
+void TimerWheel::cancel(Timer& timer) {
+	if(timer.isPending()) unlink(timer);
+}
+
+void TimerWheel::advance(const clock::time_point& now) {
+	std::uint64_t target = toTick(now);
+	while(next_tick <= target) processTick();
+}
+
+std::uint64_t TimerWheel::toTick(const clock::time_point& t) const {
+	if(t <= origin) return 0;
+	return std::chrono::duration_cast<std::chrono::milliseconds>(t - origin).count();
+}
+
+void TimerWheel::file(Timer& timer) {
+	// pick the level from the distance to the next tick, the slot from the absolute expiry
+	std::uint64_t delta = (timer.expiry > next_tick ? timer.expiry - next_tick : 0);
+	std::uint64_t expiry = timer.expiry;
+	if(delta > max_delta) expiry = next_tick + max_delta; // re-filed on arrival, see processTick()
+
+	int level = 0;
+	while(level < levels - 1 && delta >= (1ull << (level_bits * (level + 1)))) ++level;
+
+	Timer** head = &wheel[level][(expiry >> (level_bits * level)) & slot_mask];
+	timer.head = head;
+	timer.prev = nullptr;
+	timer.next = *head;
+	if(*head != nullptr) (*head)->prev = &timer;
+	*head = &timer;
+
+	++pending_count;
+}
+
+void TimerWheel::unlink(Timer& timer) {
+	if(timer.prev != nullptr) timer.prev->next = timer.next; else *(timer.head) = timer.next;
+	if(timer.next != nullptr) timer.next->prev = timer.prev;
+
+	timer.head = nullptr;
+	timer.prev = timer.next = nullptr;
+
+	--pending_count;
+}
+
+void TimerWheel::cascade(int level, std::uint64_t index) {
+	Timer** head = &wheel[level][index];
+	while(*head != nullptr) {
+		Timer* t = *head;
+		unlink(*t);
+		file(*t); // lands on a lower level now that it is closer
+	}
+}
+
+void TimerWheel::processTick(void) {
+	const std::uint64_t tick = next_tick;
+
+	// when the first level wraps, pull the next block of timers down from above
+	for(int level = 1; level < levels; ++level) {
+		if(((tick >> (level_bits * (level - 1))) & slot_mask) != 0) break;
+		cascade(level, (tick >> (level_bits * level)) & slot_mask);
+	}
+
+	++next_tick; // anything scheduled from expired() goes to a later tick
+
+	Timer** head = &wheel[0][tick & slot_mask];
+	while(*head != nullptr) {
+		Timer* t = *head;
+		unlink(*t);
+		if(t->expiry > tick) {
+			file(*t); // longer than the wheel's range, not done yet
+		} else {
+			t->expired();
+		}
+	}
+}
@@ -101,92 +101,105 @@ void USBSerialLink::receive() {
 		char buff[bytes_waiting];
 		int byte_cnt = sp_nonblocking_read(port, buff, bytes_waiting);
 		if(byte_cnt > 0) {
-			std::string new_input = std::string(buff, byte_cnt);
-			unparsed_input = parse(unparsed_input + new_input);
+			unparsed_input.append(buff, byte_cnt);
+			parse(unparsed_input);
 		}
 	}
 }
 
-std::string USBSerialLink::parse(const std::string& parse_me) {
-	std::string keep_for_later;
-	std::vector<std::string> lines;
-	string_util::splitOnChar(parse_me, '\n', lines); // removes token from result
-	int usable_lines = lines.size();
-	if(parse_me[parse_me.length()-1] != '\n') {
-		// keep the last line for later, it'll get finished after the the next append
-		keep_for_later = lines[lines.size()-1]; // store the last element to return
-		--usable_lines; // and then don't use the incomplete line
+void USBSerialLink::parse(std::string& input) {
+	// lines are looked at in place, nothing is copied until a field is stored
+	telemetry::consume(input,
+		[this](string_util::StringView line) { parseLine(line); },
+		[this](const telemetry::Frame& frame) { publish(frame); });
+}
+
+void USBSerialLink::publish(const telemetry::Frame& frame) {
+	std::uint32_t lost = telemetry_seq.update(frame.seq);
+	if(lost > 0) {
+		LOG_DEBUG << "(USB) " << lost << " telemetry frames lost before " << frame.seq;
 	}
-	if(usable_lines > 0) {
-		for(int i = 0; i < usable_lines; ++i) {
-			std::string& line = lines[i]; // vector[] returns reference
-			line = string_util::trim(line);
-
-			// in substring, verify that first two characters are separator (drop input if not), then remove the first two and split on separator
-			if(line.find(std::string(2u, separator)) == 0) {
-				line = line.substr(2);
-				std::vector<std::string> fields;
-				string_util::splitOnChar(line, separator, fields); // modify splitOnChar to limit the number of splits to handle the use of separator in data (though not field_name)
-				if(fields.size() == 3) {
-					Hint type_hint = deduceHint(fields[1]);
-					std::string& data = fields[2];
-					switch(type_hint) {
-						case Hint::Bool:
-							setInBuffer(fields[0], type_hint, (data == "true" ? true : false));
-							break;
-						case Hint::Int:
-							setInBuffer(fields[0], type_hint, std::stoi(data));
-							break;
-						case Hint::IntVector:
-							setInBuffer(fields[0], type_hint, aStoiV(data, array_separator));
-							break;
-						case Hint::Double:
-							setInBuffer(fields[0], type_hint, std::stod(data));
-							break;
-						case Hint::DoubleVector:
-							setInBuffer(fields[0], type_hint, aStodV(data, array_separator));
-							break;
-						case Hint::String:
-							setInBuffer(fields[0], type_hint, data);
-							break;
-						default:
-							typeNotSupported(fields[0]);
-					}
-				} else continue; 
-			} else {
-				if(line != "") {
-					LOG_INFO << "(USB) " << line;
-				}
-				continue;
-			}
+
+	if(frame.flags & telemetry::FRESH_PRESSURE) {
+		setInBuffer("data_pressure", Hint::Double, (double)frame.pressure);
+		setInBuffer("data_temperature", Hint::Double, (double)frame.temperature);
+	}
+	setInBuffer("data_orientation", Hint::DoubleVector, std::vector<double>{ frame.yaw, frame.pitch, frame.roll });
+	setInBuffer("data_pid_out", Hint::DoubleVector, std::vector<double>(frame.pid_out, frame.pid_out + telemetry::AXES));
+	setInBuffer("data_pid_auto", Hint::Int, (int)frame.pid_auto);
+	setInBuffer("data_thrusters", Hint::IntVector, std::vector<int>(frame.power, frame.power + telemetry::THRUSTERS));
+	setInBuffer("data_kill_adc", Hint::Int, (int)frame.kill_adc);
+	setInBuffer("telemetry_seq", Hint::Int, (int)frame.seq);
+	setInBuffer("telemetry_lost", Hint::Int, (int)telemetry_seq.lost());
+}
+
+void USBSerialLink::parseLine(string_util::StringView line) {
+	line = string_util::trim(line);
+
+	// verify that first two characters are separator (drop input if not), then remove the first two and split on separator
+	const char prefix[2] = { separator, separator };
+	if(!line.startsWith(string_util::StringView(prefix, 2))) {
+		if(!line.empty()) {
+			LOG_INFO << "(USB) " << line;
 		}
+		return;
+	}
+
+	// the separator may not appear in data (though not field_name), so there have to be exactly 3 fields
+	string_util::StringView fields[3];
+	int field_cnt = 0;
+	for(string_util::StringView field : string_util::split(line.substr(2), separator)) {
+		if(field_cnt == 3) return;
+		fields[field_cnt++] = field;
+	}
+	if(field_cnt != 3) return;
+
+	Hint type_hint = deduceHint(fields[1]);
+	std::string field_name = fields[0].str();
+	string_util::StringView data = fields[2];
+	switch(type_hint) {
+		case Hint::Bool:
+			setInBuffer(field_name, type_hint, (data == "true" ? true : false));
+			break;
+		case Hint::Int:
+			setInBuffer(field_name, type_hint, std::stoi(data.str()));
+			break;
+		case Hint::IntVector:
+			setInBuffer(field_name, type_hint, aStoiV(data, array_separator));
+			break;
+		case Hint::Double:
+			setInBuffer(field_name, type_hint, std::stod(data.str()));
+			break;
+		case Hint::DoubleVector:
+			setInBuffer(field_name, type_hint, aStodV(data, array_separator));
+			break;
+		case Hint::String:
+			setInBuffer(field_name, type_hint, data.str());
+			break;
+		default:
+			typeNotSupported(field_name);
 	}
-	return keep_for_later;
 }
 
-Hint USBSerialLink::deduceHint(const std::string& hint_str) {
+Hint USBSerialLink::deduceHint(string_util::StringView hint_str) {
 	for(auto it = hint_strings.begin(); it != hint_strings.end(); ++it) {
-		if(it->second == hint_str) return it->first;
+		if(hint_str == it->second) return it->first;
 	}
 	return Hint::Other;
 }
 
-std::vector<int> USBSerialLink::aStoiV(const std::string& s, const char arr_sep) {
-	std::vector<std::string> v_tmp;
-	string_util::splitOnChar(s, arr_sep, v_tmp);
+std::vector<int> USBSerialLink::aStoiV(string_util::StringView s, const char arr_sep) {
 	std::vector<int> v_final;
-	for(int i = 0; i < v_tmp.size(); i++) {
-		if(v_tmp[i] != "") v_final.push_back(stoi(v_tmp[i]));
+	for(string_util::StringView part : string_util::split(s, arr_sep)) {
+		if(!part.empty()) v_final.push_back(std::stoi(part.str()));
 	}
 	return v_final;
 }
 
-std::vector<double> USBSerialLink::aStodV(const std::string& s, const char arr_sep) {
-	std::vector<std::string> v_tmp;
-	string_util::splitOnChar(s, arr_sep, v_tmp);
+std::vector<double> USBSerialLink::aStodV(string_util::StringView s, const char arr_sep) {
 	std::vector<double> v_final;
-	for(int i = 0; i < v_tmp.size(); i++) {
-		if(v_tmp[i] != "") v_final.push_back(stod(v_tmp[i]));
+	for(string_util::StringView part : string_util::split(s, arr_sep)) {
+		if(!part.empty()) v_final.push_back(std::stod(part.str()));
 	}
 	return v_final;
 }
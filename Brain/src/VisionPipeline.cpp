@@ -0,0 +1,236 @@
+#include "Vision/VisionPipeline.hpp"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace vision;
+
+Pipeline::Pipeline() : tracking(false), track_margin(0.5), track_min_margin(16), full_search_every(30), since_full(0),
+	roi_frames(0), lost_frames(0), frame_scale(1), frames(0), total_ms(0), last_frame_ms(0), timing(false) {}
+
+void Pipeline::setTracking(bool enabled, double margin, int min_margin, unsigned _full_search_every) {
+	tracking = enabled;
+	track_margin = margin;
+	track_min_margin = min_margin;
+	full_search_every = _full_search_every;
+	track_bounds = cv::Rect();
+}
+
+bool Pipeline::step(FrameSource& source) {
+	if(!timing) {
+		// count the wait for the first frame too, fps is what the consumer sees
+		started = clock::now();
+		timing = true;
+	}
+
+	if(!source.read(current.input)) return false;
+	while(governor.skip()) {
+		if(!source.read(current.input)) return false;
+	}
+	current.detection.captured = clock::now();
+	current.detection.frame_number = frames + governor.skipped() + 1;
+
+	process();
+	return true;
+}
+
+const Detection& Pipeline::process(CapturedFrame& frame) {
+	// the pixels change hands, frame gets this pipeline's previous input buffer to fill next time
+	cv::swap(frame.image, current.input);
+	current.detection.captured = frame.captured;
+	current.detection.frame_number = frame.sequence;
+
+	return process();
+}
+
+const Detection& Pipeline::process(void) {
+	if(!timing) {
+		started = clock::now();
+		timing = true;
+	}
+
+	Detection& d = current.detection;
+	d.clear();
+	d.frame_size = current.input.size();
+
+	for(StageTiming& t : timings) t.last_ms = 0;
+	clock::time_point frame_start = clock::now();
+	stage_start = frame_start;
+
+	current.arena.reserve(current.input.size()); // only does anything on the first frame
+
+	d.quality = governor.level();
+	frame_scale = governor.current().downscale;
+	if(frame_scale > 1) {
+		// nearest neighbour, it's only a little worse than INTER_AREA for thresholding and a fraction of the cost
+		const cv::Mat& in = current.input;
+		current.reduced.create(in.rows / frame_scale, in.cols / frame_scale, in.type()); // no-op after the first time
+		decimate(in.ptr<std::uint8_t>(0), in.step, in.cols, in.rows, current.reduced.ptr<std::uint8_t>(0), current.reduced.step,
+			current.reduced.cols, current.reduced.rows, in.channels(), current.arena.offsets(current.reduced.cols));
+		cv::swap(current.input, current.reduced);
+	}
+
+	cv::Rect searched = nextRoi();
+	current.roi = searched;
+	runStages();
+	bool from_roi = (searched.area() < current.input.cols * current.input.rows);
+	if(from_roi && !d.found) {
+		// lost it, look everywhere before calling this frame empty
+		++lost_frames;
+		d.clear();
+		current.roi = cv::Rect(0, 0, current.input.cols, current.input.rows);
+		runStages();
+		from_roi = false;
+	}
+	if(from_roi) ++roi_frames;
+	else since_full = 0;
+
+	d.roi = current.roi;
+	if(frame_scale > 1) {
+		// back to the frame as it came in, a CapturedFrame gets its own size buffer back
+		cv::swap(current.input, current.reduced);
+		scaleDetection(d, frame_scale);
+	}
+	track_bounds = (d.found ? d.bounds : cv::Rect());
+	last_frame_ms = std::chrono::duration<double, std::milli>(clock::now() - frame_start).count();
+	total_ms += last_frame_ms;
+	governor.update(last_frame_ms);
+
+	++frames;
+	d.fps = fps();
+	return d;
+}
+
+cv::Rect Pipeline::nextRoi(void) {
+	cv::Rect full(0, 0, current.input.cols, current.input.rows);
+	if(!tracking || track_bounds.area() == 0) return full;
+	if(full_search_every > 0 && since_full + 1 >= full_search_every) return full;
+
+	// track_bounds is in full resolution, input may not be
+	cv::Rect b(track_bounds.x / frame_scale, track_bounds.y / frame_scale, track_bounds.width / frame_scale, track_bounds.height / frame_scale);
+	int mx = std::max(track_min_margin, (int)(b.width * track_margin));
+	int my = std::max(track_min_margin, (int)(b.height * track_margin));
+	cv::Rect roi = cv::Rect(b.x - mx, b.y - my, b.width + 2 * mx, b.height + 2 * my) & full;
+
+	// past about 2/3 of the frame the saving doesn't pay for the chance of a second pass
+	if(roi.area() * 3 > full.area() * 2) return full;
+	++since_full;
+	return roi;
+}
+
+void Pipeline::runStages(void) {
+	current.arena.reset();
+	const bool optional = governor.current().optional_stages;
+	for(std::size_t i = 0; i < stages.size(); ++i) {
+		if(!optional && stages[i]->isOptional()) continue;
+		stages[i]->process(current);
+
+		clock::time_point stage_end = clock::now();
+		double ms = std::chrono::duration<double, std::milli>(stage_end - stage_start).count();
+		timings[i].last_ms += ms; // twice when the tracking ROI came up empty
+		timings[i].total_ms += ms;
+		stage_start = stage_end;
+
+		if(current.roi.area() == 0) break; // a stage found nothing to look at
+	}
+}
+
+void Pipeline::scaleDetection(Detection& d, int scale) {
+	const float s = scale;
+	d.roi = cv::Rect(d.roi.x * scale, d.roi.y * scale, d.roi.width * scale, d.roi.height * scale);
+	if(!d.found) return;
+
+	d.center = d.center * s;
+	d.area *= s * s;
+	d.bounds = cv::Rect(d.bounds.x * scale, d.bounds.y * scale, d.bounds.width * scale, d.bounds.height * scale);
+	d.min_bounds = cv::RotatedRect(d.min_bounds.center * s, cv::Size2f(d.min_bounds.size.width * s, d.min_bounds.size.height * s), d.min_bounds.angle);
+	d.path_ends[0] = d.path_ends[0] * s;
+	d.path_ends[1] = d.path_ends[1] * s;
+	// offset and path_angle don't depend on the scale, and HeadingStage already held the center to its
+	// tolerance in full frame pixels
+}
+
+double Pipeline::fps(void) const {
+	if(frames == 0) return 0;
+	double sec = std::chrono::duration<double>(clock::now() - started).count();
+	return (sec > 0 ? frames / sec : 0);
+}
+
+double Pipeline::meanFrameMs(void) const {
+	return (frames > 0 ? total_ms / frames : 0);
+}
+
+std::string Pipeline::report(void) const {
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(2);
+	oss << frames << " frames, " << fps() << " fps, " << meanFrameMs() << " ms/frame processing\n";
+	if(tracking) oss << roi_frames << " frames from the ROI alone, " << lost_frames << " lost and searched again in full\n";
+	if(governor.enabled()) {
+		oss << "quality level " << governor.level() << " of " << QualityGovernor::levelCount() - 1 << " (" << governor.budget() << " ms budget), "
+			<< governor.levelChanges() << " changes, " << governor.skipped() << " frames skipped\n";
+	}
+	for(const StageTiming& t : timings) {
+		oss << "\t" << std::left << std::setw(16) << t.name << std::right << std::setw(8) << (frames > 0 ? t.total_ms / frames : 0) << " ms\n";
+	}
+	return oss.str();
+}
+
+void Pipeline::resetStats(void) {
+	frames = 0;
+	total_ms = 0;
+	last_frame_ms = 0;
+	timing = false;
+	roi_frames = lost_frames = 0;
+	governor.resetStats();
+	for(StageTiming& t : timings) t.last_ms = t.total_ms = 0;
+}
+
+void vision::configureHeading(Pipeline& pipeline) {
+	// values selected using hsv_filter.cpp
+	pipeline.add<HSVThreshold>(cv::Scalar(2, 111, 100), cv::Scalar(18, 255, 255));
+	// make the white parts bigger, not strictly needed but seems to help a little in lower light
+	pipeline.add<Dilate>(7).setOptional(true);
+	pipeline.add<FindContours>(0);
+	pipeline.add<LargestTarget>();
+	pipeline.add<HeadingStage>(7);
+}
+
+void vision::configurePath(Pipeline& pipeline, int pyramid_levels) {
+	// same orange as the heading, get_path.cpp
+	const cv::Scalar lower(2, 111, 100), upper(18, 255, 255);
+	if(pyramid_levels > 0) pipeline.add<CoarseLocate>(lower, upper, pyramid_levels);
+	pipeline.add<HSVThreshold>(lower, upper);
+	pipeline.add<Dilate>(5);
+	pipeline.add<FindContours>(0);
+	// a decently high tolerance, the sides should come out as few long lines
+	pipeline.add<LargestTarget>(5);
+	pipeline.add<PathLines>(15, 4);
+}
+
+bool vision::configure(Pipeline& pipeline, const std::string& name) {
+	if(name == "heading") {
+		configureHeading(pipeline);
+	} else if(name == "path") {
+		configurePath(pipeline);
+	} else if(name == "path_pyramid") {
+		configurePath(pipeline, 2);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void vision::publish(Comms& comms, const std::string& link_id, const Detection& detection) {
+	using comms_util::Hint;
+	comms.send(link_id, "vision_found", Hint::Bool, detection.found);
+	comms.send(link_id, "vision_heading", Hint::String, std::string(headingName(detection.heading)));
+	comms.send(link_id, "vision_offset", Hint::Double, detection.offset);
+	comms.send(link_id, "vision_center", Hint::DoubleVector, std::vector<double>{ detection.center.x, detection.center.y });
+	comms.send(link_id, "vision_area", Hint::Double, detection.area);
+	comms.send(link_id, "vision_fps", Hint::Double, detection.fps);
+
+	double age_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - detection.captured).count();
+	comms.send(link_id, "vision_age_ms", Hint::Double, age_ms);
+	comms.send(link_id, "vision_quality", Hint::Int, detection.quality);
+}
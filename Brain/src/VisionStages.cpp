@@ -0,0 +1,268 @@
+#include "Vision/VisionStages.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace vision;
+
+const char* vision::headingName(Heading heading) {
+	switch(heading) {
+		case Heading::Left: return "left";
+		case Heading::Right: return "right";
+		case Heading::OnTarget: return "on target";
+		case Heading::None: break;
+	}
+	return "none";
+}
+
+// ********************************
+// HSVThreshold
+// ********************************
+
+HSVThreshold::HSVThreshold(cv::Scalar _lower, cv::Scalar _upper, bool _fused) : Stage("HSVThreshold"), lower(_lower), upper(_upper), fused(_fused) {
+	double lo[3] = { lower[0], lower[1], lower[2] };
+	double hi[3] = { upper[0], upper[1], upper[2] };
+	range = makeHSVRange(lo, hi);
+}
+
+void HSVThreshold::process(VisionFrame& frame) {
+	const cv::Mat in = frame.input(frame.roi); // a header onto the same pixels, rows aren't contiguous unless roi is the whole frame
+	if(!fused || in.type() != CV_8UC3) {
+		frame.hsv = frame.arena.take(in.size(), in.type());
+		frame.mask = frame.arena.take(in.size(), CV_8UC1);
+		cv::cvtColor(in, frame.hsv, cv::COLOR_BGR2HSV);
+		cv::inRange(frame.hsv, lower, upper, frame.mask);
+		return;
+	}
+
+	frame.mask = frame.arena.take(in.size(), CV_8UC1);
+	if(in.isContinuous() && frame.mask.isContinuous()) {
+		hsvThresholdRow(in.ptr<std::uint8_t>(0), frame.mask.ptr<std::uint8_t>(0), in.rows * in.cols, range);
+	} else {
+		for(int y = 0; y < in.rows; ++y) hsvThresholdRow(in.ptr<std::uint8_t>(y), frame.mask.ptr<std::uint8_t>(y), in.cols, range);
+	}
+}
+
+// ********************************
+// Dilate
+// ********************************
+
+Dilate::Dilate(int _kernel_size) : Stage("Dilate"), kernel_size(_kernel_size) {}
+
+void Dilate::process(VisionFrame& frame) {
+	// the same as cv::dilate with a MORPH_RECT kernel, without the filter engine it sets up every call
+	const cv::Mat& mask = frame.mask;
+	frame.scratch = frame.arena.take(mask.size(), CV_8UC1);
+	dilateRect(mask.ptr<std::uint8_t>(0), mask.step, frame.scratch.ptr<std::uint8_t>(0), frame.scratch.step,
+		mask.cols, mask.rows, kernel_size, frame.arena.row(mask.cols + kernel_size));
+	cv::swap(frame.mask, frame.scratch);
+}
+
+// ********************************
+// FindContours
+// ********************************
+
+FindContours::FindContours(double _min_area) : Stage("FindContours"), min_area(_min_area) {}
+
+void FindContours::process(VisionFrame& frame) {
+	// findContours with RETR_EXTERNAL (only the outermost contours) and CHAIN_APPROX_SIMPLE (horizontal/vertical
+	// runs are stored as their two end points), into storage kept from frame to frame
+	// the offset puts the points in full frame coordinates when mask only covers the roi
+	const cv::Mat& mask = frame.mask;
+	traceExternalContours(mask.ptr<std::uint8_t>(0), mask.step, mask.cols, mask.rows, frame.roi.x, frame.roi.y,
+		frame.arena.labels(mask.size()), frame.contours);
+
+	frame.targets.reset(frame.contours, 2);
+	frame.target = -1;
+	for(std::size_t i = 0; i < frame.contours.size(); ++i) {
+		cv::Moments m = cv::moments(contourMat(frame.contours, i), true); // true b/c binary image
+		if(m.m00 > min_area) frame.targets.add(i, m);
+	}
+}
+
+// ********************************
+// LargestTarget
+// ********************************
+
+LargestTarget::LargestTarget(double _poly_epsilon) : Stage("LargestTarget"), poly_epsilon(_poly_epsilon) {}
+
+void LargestTarget::process(VisionFrame& frame) {
+	ContourTable& targets = frame.targets;
+	if(targets.empty()) return;
+
+	// only the largest is used, no need to sort them all - or to approximate the others
+	targets.rankByArea(1);
+	targets.setPolyEpsilon(poly_epsilon);
+	frame.target = 0;
+
+	Detection& d = frame.detection;
+	d.found = true;
+	d.area = targets.area(0);
+	d.bounds = targets.bounds(0);
+	d.min_bounds = targets.minBounds(0);
+	d.center = d.min_bounds.center;
+}
+
+// ********************************
+// HeadingStage
+// ********************************
+
+HeadingStage::HeadingStage(int _tolerance) : Stage("Heading"), tolerance(_tolerance) {}
+
+void HeadingStage::process(VisionFrame& frame) {
+	Detection& d = frame.detection;
+	if(!d.found) {
+		d.heading = Heading::None;
+		return;
+	}
+
+	double half_width = frame.input.cols / 2.0;
+	double diff = d.center.x - half_width;
+	d.offset = diff / half_width;
+
+	// the tolerance is in pixels of the frame as it came in, the input is smaller while the Pipeline is
+	// degraded to a lower resolution - the on target band has to stay the same width either way
+	if(frame.input.cols > 0 && d.frame_size.width > 0) diff *= (double)d.frame_size.width / frame.input.cols;
+
+	if(std::fabs(diff) > tolerance) {
+		d.heading = (diff > 0 ? Heading::Right : Heading::Left);
+	} else {
+		d.heading = Heading::OnTarget;
+	}
+}
+
+// ********************************
+// CoarseLocate
+// ********************************
+
+CoarseLocate::CoarseLocate(cv::Scalar lower, cv::Scalar upper, int _levels, double _min_area, int _margin) : Stage("CoarseLocate"),
+	levels(_levels), min_area(_min_area), margin(_margin) {
+	double lo[3] = { lower[0], lower[1], lower[2] };
+	double hi[3] = { upper[0], upper[1], upper[2] };
+	range = makeHSVRange(lo, hi);
+}
+
+void CoarseLocate::process(VisionFrame& frame) {
+	const int scale = 1 << levels;
+	const cv::Mat in = frame.input(frame.roi);
+
+	// plain decimation, every scale'th pixel of every scale'th row (cv::resize with INTER_NEAREST). pyrDown's
+	// blur would be nicer to look at but costs more than thresholding the whole frame with the fused kernel,
+	// and the target is big enough that it can't fall between the samples
+	cv::Size small_size((in.cols + scale - 1) / scale, (in.rows + scale - 1) / scale);
+	cv::Mat small = frame.arena.take(small_size, CV_8UC3);
+	decimate(in.ptr<std::uint8_t>(0), in.step, in.cols, in.rows, small.ptr<std::uint8_t>(0), small.step,
+		small.cols, small.rows, 3, frame.arena.offsets(small.cols));
+
+	cv::Mat small_mask = frame.arena.take(small_size, CV_8UC1);
+	for(int y = 0; y < small.rows; ++y) hsvThresholdRow(small.ptr<std::uint8_t>(y), small_mask.ptr<std::uint8_t>(y), small.cols, range);
+
+	traceExternalContours(small_mask.ptr<std::uint8_t>(0), small_mask.step, small_mask.cols, small_mask.rows, 0, 0,
+		frame.arena.labels(small_size), contours);
+
+	int best = -1;
+	double best_area = min_area / (scale * scale);
+	for(std::size_t i = 0; i < contours.size(); ++i) {
+		double area = cv::moments(contourMat(contours, i), true).m00;
+		if(area > best_area) {
+			best = i;
+			best_area = area;
+		}
+	}
+
+	if(best < 0) {
+		frame.roi = cv::Rect(); // nothing here, the rest of the pass is skipped
+		return;
+	}
+
+	// back to full resolution, the margin covers edges that fell between samples and what Dilate adds
+	cv::Rect r = cv::boundingRect(contourMat(contours, best));
+	cv::Rect full_res(frame.roi.x + r.x * scale - margin, frame.roi.y + r.y * scale - margin,
+		r.width * scale + 2 * margin, r.height * scale + 2 * margin);
+	frame.roi = frame.roi & full_res;
+}
+
+// ********************************
+// PathLines
+// ********************************
+
+namespace {
+	// longest first, ties keep their order - an insertion sort, there are only a few and
+	// std::stable_sort allocates a buffer every call
+	void sortLongerFirst(std::vector<Segment>& segments) {
+		for(std::size_t i = 1; i < segments.size(); ++i) {
+			Segment s = segments[i];
+			std::size_t j = i;
+			for(; j > 0 && segments[j - 1].length() < s.length(); --j) segments[j] = segments[j - 1];
+			segments[j] = s;
+		}
+	}
+}
+
+PathLines::PathLines(double _parallel_tolerance, int _max_sections, std::size_t _max_lines, double _min_length_ratio) : Stage("PathLines"),
+	parallel_tolerance(_parallel_tolerance * CV_PI / 180), max_sections(_max_sections), max_lines(_max_lines), min_length_ratio(_min_length_ratio) {}
+
+void PathLines::process(VisionFrame& frame) {
+	Detection& d = frame.detection;
+	LineIndex& lines = frame.lines;
+	lines.clear();
+	frame.centerlines.clear();
+	if(!d.found || frame.target < 0) return;
+	const std::vector<cv::Point>& poly = frame.targets.poly(frame.target);
+	if(poly.size() < 2) return;
+
+	// sides of the polygon, long to short - long gets first chance as target
+	const std::size_t n = poly.size();
+	for(std::size_t i = 0; i < n; ++i) lines.add(poly[i], poly[(i + 1) % n]);
+	lines.build(max_lines, parallel_tolerance);
+
+	std::size_t sections = std::min<std::size_t>(n / 2, max_sections);
+	for(std::size_t t = 0; t < lines.size() && frame.centerlines.size() < sections; ++t) {
+		if(lines.used(t)) continue;
+		lines.markUsed(t);
+
+		// the nearest (by midpoint) of the remaining sides that is near parallel and not a sliver next to it
+		int match = lines.nearestParallel(t, lines.getLength(t) * min_length_ratio);
+		if(match < 0) continue;
+		lines.markUsed(match);
+
+		// opposite sides of a polygon usually run in opposite directions, point both the same way
+		// (and down the frame, to be predictable) so their ends pair up
+		Segment target = lines.segment(t);
+		Segment other = lines.segment(match);
+		if(target.angle() < 0) target.reverse();
+		if((target.p2 - target.p1).dot(other.p2 - other.p1) < 0) other.reverse();
+
+		frame.centerlines.push_back(Segment((target.p1 + other.p1) * 0.5f, (target.p2 + other.p2) * 0.5f));
+	}
+
+	if(frame.centerlines.empty()) return;
+	sortLongerFirst(frame.centerlines);
+
+	d.path_sections = frame.centerlines.size();
+	double angle = frame.centerlines.front().angle();
+	if(angle < 0) angle += CV_PI;
+	d.path_angle = std::fmod(angle * 180 / CV_PI, 180.0);
+
+	// the ends of the path are the two center line endpoints farthest apart, at most 2 * max_sections of them
+	cv::Point2f a = frame.centerlines.front().p1, b = frame.centerlines.front().p2;
+	double best = cv::norm(a - b);
+	for(std::size_t i = 0; i < 2 * frame.centerlines.size(); ++i) {
+		const Segment& si = frame.centerlines[i / 2];
+		cv::Point2f pi = (i % 2 ? si.p2 : si.p1);
+		for(std::size_t j = i + 1; j < 2 * frame.centerlines.size(); ++j) {
+			const Segment& sj = frame.centerlines[j / 2];
+			cv::Point2f pj = (j % 2 ? sj.p2 : sj.p1);
+			double dist = cv::norm(pi - pj);
+			if(dist > best) {
+				best = dist;
+				a = pi;
+				b = pj;
+			}
+		}
+	}
+	if(a.y < b.y) std::swap(a, b);
+	d.path_ends[0] = a;
+	d.path_ends[1] = b;
+	d.center = (a + b) * 0.5f;
+}
@@ -41,10 +41,10 @@ int main(int argc, char* argv[]) {
 	int opt;
 	bool TEST_comms = false;
 	bool use_usb = false;
-	while( (opt = getopt(argc, argv, "c:p:l:t:d:euh")) != -1) {
+	while( (opt = getopt(argc, argv, "c:p:l:t:d:v:euh")) != -1) {
 		switch(opt) {
 			case 'h':
-				std::cout << "-c : Start delay\n-p : Submerge pressure\n-l : Submerge tol\n-t : Validation thrust\n-d : Validation dur\n-u : Use USB\n-e : Run tests" << std::endl;
+				std::cout << "-c : Start delay\n-p : Submerge pressure\n-l : Submerge tol\n-t : Validation thrust\n-d : Validation dur\n-v : Vision source (camera index, video file or image directory)\n-u : Use USB\n-e : Run tests" << std::endl;
 				return 0;
 			case 'c':
 				try {
@@ -88,6 +88,11 @@ int main(int argc, char* argv[]) {
 				} catch(std::invalid_argument& e) {}
 				break;
 
+			case 'v':
+				comms.send("pi", "vision_source", comms_util::Hint::String, std::string(optarg));
+				LOG_INFO << "-v = Set vision source to '" << optarg << "'.";
+				break;
+
 			case 'e':
 				TEST_comms = true;
 				LOG_INFO << "-e = Tests enabled";
@@ -136,7 +141,12 @@ int main(int argc, char* argv[]) {
 
 	TimeStamp cmdline_ts;
 
+	// loop rate is the main figure of merit when comparing build configurations (see README)
+	unsigned long loop_count = 0;
+	std::chrono::steady_clock::time_point loop_start = std::chrono::steady_clock::now();
+
 	while(task_manager.tasksRunning()) {
+		++loop_count;
 		task_manager.update();
 		//cout << task_manager.listTasks();
 		if(comms.hasNew("pi", "cmdline", cmdline_ts.getTimePoint())) {
@@ -157,6 +167,9 @@ int main(int argc, char* argv[]) {
 		}
 		//std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
+
+	double loop_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - loop_start).count();
+	LOG_INFO << "Main loop: " << loop_count << " iterations in " << loop_sec << " s (" << (loop_sec > 0 ? loop_count / loop_sec : 0) << " Hz)";
 	
 	return 0;
 }
@@ -1,27 +1,85 @@
 #include "string_util.hpp"
 
-void string_util::splitOnChar(const std::string& s, const char delim, std::vector<std::string>& v) {
-    std::size_t pos = s.find(delim);
-    if(pos == std::string::npos) {
-    	v.push_back(s);
-    } else {
-    	int i = 0;
-	    while (pos != std::string::npos) {
-	      v.push_back(s.substr(i, pos-i));
-	      i = ++pos;
-	      pos = s.find(delim, pos);
-
-	      if (pos == std::string::npos)
-	         v.push_back(s.substr(i, s.length()));
-	    }
+#include <algorithm>
+
+using string_util::StringView;
+
+std::size_t StringView::find(char c, std::size_t from) const {
+	if(from >= len) return std::string::npos;
+	const void* found = std::memchr(ptr + from, c, len - from);
+	return found ? static_cast<const char*>(found) - ptr : std::string::npos;
+}
+
+StringView StringView::substr(std::size_t pos, std::size_t n) const {
+	if(pos > len) pos = len;
+	return StringView(ptr + pos, std::min(n, len - pos));
+}
+
+bool StringView::startsWith(StringView prefix) const {
+	return len >= prefix.len && std::memcmp(ptr, prefix.ptr, prefix.len) == 0;
+}
+
+std::ostream& string_util::operator<<(std::ostream& os, StringView v) {
+	return os.write(v.data(), v.size());
+}
+
+string_util::Split::iterator::iterator(StringView _src, char _delim, bool _done)
+	: src(_src), next(0), delim(_delim), done(_done)
+{
+	if(!done) {
+		next = 0;
+		++(*this);
 	}
 }
 
-std::string string_util::removeWhitespace(const std::string& s) {
-	return std::regex_replace( s, std::regex("\\s+"), "" );
+string_util::Split::iterator& string_util::Split::iterator::operator++() {
+	if(next == std::string::npos) {
+		done = true;
+		return *this;
+	}
+	std::size_t pos = src.find(delim, next);
+	if(pos == std::string::npos) {
+		current = src.substr(next);
+		next = std::string::npos;
+	} else {
+		current = src.substr(next, pos - next);
+		next = pos + 1;
+	}
+	return *this;
 }
 
-std::string string_util::trim(const std::string& s) {
-	std::string trimmed_start = std::regex_replace(s, std::regex("^\\s+"), "");
-	return std::regex_replace(trimmed_start, std::regex("\\s+$"), "");
+string_util::Split string_util::split(StringView s, const char delim) {
+	return Split(s, delim);
+}
+
+StringView string_util::trim(StringView s) {
+	const char* b = s.begin();
+	const char* e = s.end();
+	while(b != e && isWhitespace(*b)) ++b;
+	while(e != b && isWhitespace(*(e - 1))) --e;
+	return StringView(b, e - b);
+}
+
+void string_util::trimInPlace(std::string& s) {
+	StringView t = trim(s);
+	std::size_t start = t.data() - s.data();
+	s.erase(start + t.size());
+	s.erase(0, start);
+}
+
+void string_util::removeWhitespaceInPlace(std::string& s) {
+	s.erase(std::remove_if(s.begin(), s.end(), isWhitespace), s.end());
+}
+
+void string_util::splitOnChar(StringView s, const char delim, std::vector<std::string>& v) {
+	for(StringView part : split(s, delim)) v.push_back(part.str());
+}
+
+std::string string_util::removeWhitespace(StringView s) {
+	std::string out;
+	out.reserve(s.size());
+	for(char c : s) {
+		if(!isWhitespace(c)) out.push_back(c);
+	}
+	return out;
 }
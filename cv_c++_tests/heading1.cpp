@@ -19,44 +19,55 @@ const cv::Scalar C_LIGHT_GRAY = cv::Scalar(180, 180, 180);
 const uint16_t FRAME_WIDTH = 640;
 const uint16_t FRAME_HEIGHT = 480;
 
+// refers to a contour by index instead of copying it, polygon and bounds are only worked out when asked for
 class ContourInfo {
 public:
-	ContourInfo(std::vector<cv::Point> _contour, cv::Moments _moments)
-		: contour(_contour), moments(_moments)
+	ContourInfo(const std::vector<std::vector<cv::Point>>& _contours, int _index, const cv::Moments& _moments)
+		: contours(&_contours), index(_index), moments(_moments), computed(false)
 	{
-			// in, out, epsilon, closed
-			approxPolyDP(contour, approx_poly, 2, true);
 			center = cv::Point2f(moments.m10/moments.m00, moments.m01/moments.m00);
-			bounding_box = boundingRect(approx_poly);
-			min_bounding_box = minAreaRect(approx_poly);
 	}
-	std::vector<cv::Point> getContour() {
-		return contour;
+	const std::vector<cv::Point>& getContour() const {
+		return (*contours)[index];
 	}
-	std::vector<cv::Point> getPoly() {
+	const std::vector<cv::Point>& getPoly() {
+		compute();
 		return approx_poly;
 	}
-	cv::Moments getMoments() {
+	const cv::Moments& getMoments() const {
 		return moments;
 	}
-	cv::Point2f getCenter() {
+	cv::Point2f getCenter() const {
 		return center;
 	}
-	double getArea() {
+	double getArea() const {
 		return moments.m00;
 	}
 	cv::Rect getBoundingBox() {
+		compute();
 		return bounding_box;
 	}
 	cv::RotatedRect getMinBoundingBox() {
+		compute();
 		return min_bounding_box;
 	}
 
 private:
-	std::vector<cv::Point> contour;
-	std::vector<cv::Point> approx_poly;
+	void compute() {
+		if(computed) return;
+		// in, out, epsilon, closed
+		approxPolyDP(getContour(), approx_poly, 2, true);
+		bounding_box = boundingRect(approx_poly);
+		min_bounding_box = minAreaRect(approx_poly);
+		computed = true;
+	}
+
+	const std::vector<std::vector<cv::Point>>* contours;
+	int index;
 	cv::Moments moments;
 	cv::Point2f center;
+	bool computed;
+	std::vector<cv::Point> approx_poly;
 	cv::Rect bounding_box;
 	cv::RotatedRect min_bounding_box;
 };
@@ -130,13 +141,15 @@ int main(int argc, char* argv[]) {
 					// set by the GUI slider, save the contour for later processing
 
 					if(m.m00 > area_lower) {
-						packs.push_back(ContourInfo(contours[i], m));
+						packs.push_back(ContourInfo(contours, i, m));
 					}
 				}
 
 				if(packs.size() > 0) {
-					sort(packs.begin(), packs.end(),
-						[](ContourInfo lhs, ContourInfo rhs) {
+					// only the largest 2 are drawn, so only those need to be in order
+					const size_t draw_count = 2;
+					partial_sort(packs.begin(), packs.begin() + min(draw_count, packs.size()), packs.end(),
+						[](const ContourInfo& lhs, const ContourInfo& rhs) {
 							// sort largest to smallest
 							return lhs.getArea() > rhs.getArea();
 						}
@@ -153,7 +166,7 @@ int main(int argc, char* argv[]) {
 					// render the contours
 					for(int i = 0; i < packs.size(); i++) {
 						// only draw the first 2
-						if(i == 2) break;
+						if(i == draw_count) break;
 						vector<vector<Point>> contour_list;
 						contour_list.push_back(packs[i].getPoly());
 